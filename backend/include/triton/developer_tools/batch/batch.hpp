@@ -25,18 +25,26 @@
 #include <triton/backend/backend_input_collector.h>
 #include <triton/backend/backend_output_responder.h>
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <functional>
 #include <iterator>
 #include <memory>
 #include <numeric>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <triton/developer_tools/batch/response_sender.hpp>
 #include <triton/developer_tools/build_control.hpp>
 #include <triton/developer_tools/exceptions.hpp>
 #include <triton/developer_tools/memory/buffer.hpp>
+#include <triton/developer_tools/memory/buffer_pool.hpp>
 #include <triton/developer_tools/memory/types.hpp>
+#include <triton/developer_tools/stream/event.hpp>
 #include <triton/developer_tools/tensor/tensor.hpp>
 #include <triton/developer_tools/triton/device.hpp>
 #include <triton/developer_tools/triton/input.hpp>
+#include <triton/developer_tools/triton/logging.hpp>
 #include <triton/developer_tools/triton/requests.hpp>
 #include <triton/developer_tools/triton/responses.hpp>
 #include <triton/developer_tools/triton/statistics.hpp>
@@ -47,6 +55,25 @@
 namespace triton {
 namespace developer_tools {
 namespace backend {
+/**
+ * @brief A description of an input to be retrieved with `Batch::get_inputs`
+ *
+ * If `memory_type` is std::nullopt, the input is provided wherever it can be
+ * collected without a copy, either on host or on the indicated device.
+ */
+struct InputDescriptor {
+  std::string name;
+  std::optional<MemoryType> memory_type;
+  device_id_t device_id;
+};
+
+namespace detail {
+/* Alias mapping every type of a parameter pack to T, used to declare one
+ * function parameter of type T per element of the pack */
+template <typename T, typename>
+using for_each_t = T;
+}  // namespace detail
+
 /**
  * @brief A representation of all data about a single batch of inference
  * requests
@@ -82,10 +109,14 @@ struct Batch {
         bool use_pinned_input,
         bool use_pinned_output,
         size_type max_batch_size,
-        cudaStream_t stream)
+        cudaStream_t stream,
+        std::shared_ptr<BufferPool> output_pool = nullptr,
+        bool decoupled                          = false,
+        std::function<std::vector<std::int64_t>(std::string const&)> get_config_output_shape = {})
     : requests_{raw_requests, raw_requests + count},
       responses_{construct_responses(requests_.begin(), requests_.end())},
       get_output_shape_{std::move(get_output_shape)},
+      get_config_output_shape_{std::move(get_config_output_shape)},
       report_statistics_{std::move(report_request_statistics)},
       collector_(raw_requests, count, &responses_, &triton_mem_manager, use_pinned_input, stream),
       responder_{std::make_shared<triton::backend::BackendOutputResponder>(raw_requests,
@@ -98,28 +129,30 @@ struct Batch {
       stream_{stream},
       start_time_{std::chrono::steady_clock::now()},
       compute_start_time_{std::chrono::steady_clock::now()},
-      batch_size_{}
+      batch_size_{},
+      request_batch_dims_{},
+      output_pool_{std::move(output_pool)},
+      output_leases_{},
+      decoupled_{decoupled},
+      has_outputs_{false},
+      sender_{}
   {
   }
 
+  // The response sender refers to the batch's request sizes, so a batch must
+  // stay where it was constructed
+  Batch(Batch const&)            = delete;
+  Batch& operator=(Batch const&) = delete;
+  Batch(Batch&&)                 = delete;
+  Batch& operator=(Batch&&)      = delete;
+
   template <typename T>
   auto get_input_shape(std::string const& name)
   {
     auto result = std::vector<size_type>{};
     if (!requests_.empty()) {
       result = get_triton_input_shape<T>(std::begin(requests_), std::end(requests_), name);
-
-      auto input_batch_dim = size_type{};
-      if (result.size() > 0) { input_batch_dim = result[0]; }
-
-      if (batch_size_.has_value()) {
-        if (batch_size_.value() != input_batch_dim) {
-          throw TritonException(Error::Internal,
-                                "all input tensors must have same batch dimension");
-        }
-      } else {
-        batch_size_ = input_batch_dim;
-      }
+      check_batch_size(result, name);
     }
     return result;
   }
@@ -130,70 +163,184 @@ struct Batch {
                  device_id_t device_id,
                  cudaStream_t stream)
   {
-    auto shape = get_input_shape<T>(name);
-    auto size_bytes =
-      sizeof(T) * std::reduce(shape.begin(), shape.end(), std::size_t{1}, std::multiplies<>());
-    auto allowed_memory_configs = std::vector<std::pair<MemoryType, int64_t>>{};
-    if (memory_type.has_value()) {
-      allowed_memory_configs.emplace_back(memory_type.value(), device_id);
-    } else {
-      allowed_memory_configs.emplace_back(HostMemory, int64_t{});
-      allowed_memory_configs.emplace_back(DeviceMemory, device_id);
-    }
-
-    auto const* raw_buffer  = static_cast<char*>(nullptr);
-    auto reported_bytes     = std::size_t{};
-    auto reported_mem_type  = MemoryType{};
-    auto reported_device_id = int64_t{};
+    auto descriptor = InputDescriptor{name, memory_type, device_id};
+    auto shape      = get_input_shape<T>(name);
+    auto collected  = collect_input<T>(descriptor, shape);
+    finalize_input_collection(&collected, &collected + 1, stream);
+    return make_input<T>(std::move(shape), collected, descriptor, stream);
+  }
 
-    triton_check(
-      collector_.ProcessTensor(name.c_str(),
-                               static_cast<char*>(nullptr),  // Return data without copy if possible
-                               size_bytes,
-                               allowed_memory_configs,
-                               &raw_buffer,
-                               &reported_bytes,
-                               &reported_mem_type,
-                               &reported_device_id));
+  template <typename T>
+  auto get_input(std::string const& name,
+                 std::optional<MemoryType> const& memory_type,
+                 device_id_t device_id)
+  {
+    return get_input<T>(name, memory_type, device_id, stream_);
+  }
 
-    if(collector_.Finalize()){
-      if constexpr (IS_GPU_BUILD) {
-        cuda_check(cudaStreamSynchronize(stream_));
-      } else {
-        throw TritonException(Error::Internal, "stream synchronization required in non-GPU build");
+  /**
+   * @brief Get the named input for every request of the batch without
+   * requiring the requests to agree on its shape
+   *
+   * The requests' data is concatenated without padding into the values of
+   * the returned RaggedTensor, whose offsets delimit each request's elements
+   * and are placed in the same memory location as the values.
+   */
+  template <typename T>
+  auto get_ragged_input(std::string const& name,
+                        std::optional<MemoryType> const& memory_type,
+                        device_id_t device_id,
+                        cudaStream_t stream)
+  {
+    auto shapes  = std::vector<std::vector<size_type>>{};
+    auto offsets = std::vector<std::int64_t>{0};
+    auto rows    = size_type{};
+    if (!requests_.empty()) {
+      shapes = get_triton_input_request_shapes<T>(std::begin(requests_), std::end(requests_), name);
+      offsets.reserve(shapes.size() + 1);
+      for (auto const& shape : shapes) {
+        auto elements =
+          std::reduce(shape.begin(), shape.end(), std::size_t{1}, std::multiplies<>());
+        offsets.push_back(offsets.back() + narrow<std::int64_t>(elements));
+        if (!shape.empty()) { rows += shape[0]; }
       }
+      check_batch_size(std::vector<size_type>{rows}, name);
     }
 
-    std::for_each(std::begin(responses_), std::end(responses_), [](auto* response) {
-      if (response == nullptr) {
-        throw TritonException(Error::Internal, "Input collection failed");
-      }
-    });
+    auto descriptor   = InputDescriptor{name, memory_type, device_id};
+    auto values_shape = std::vector<size_type>{narrow<size_type>(offsets.back())};
+    auto collected    = collect_input<T>(descriptor, values_shape);
+    finalize_input_collection(&collected, &collected + 1, stream);
+    auto values = make_input<T>(std::move(values_shape), collected, descriptor, stream);
 
-    auto buffer = Buffer(reinterpret_cast<T*>(raw_buffer),
-                         reported_bytes / sizeof(T),
-                         reported_mem_type,
-                         reported_device_id,
-                         stream);
+    // The offsets are copied on the same stream as the values were collected,
+    // so that both are ready once that stream reaches this point
+    auto host_offsets =
+      Buffer<std::int64_t>{offsets.data(), offsets.size(), HostMemory, values.device(), stream};
+    return RaggedTensor<T>(std::move(values.buffer()),
+                           Buffer<std::int64_t>{host_offsets, values.mem_type(), values.device()},
+                           std::move(shapes));
+  }
 
-    if (memory_type && (reported_mem_type != memory_type || reported_device_id != device_id)) {
-      throw TritonException(Error::Internal, "data collected in wrong location");
+  template <typename T>
+  auto get_ragged_input(std::string const& name,
+                        std::optional<MemoryType> const& memory_type,
+                        device_id_t device_id)
+  {
+    return get_ragged_input<T>(name, memory_type, device_id, stream_);
+  }
+
+  /**
+   * @brief Get the shape of the named input in each request of the batch
+   */
+  template <typename T>
+  auto get_request_shapes(std::string const& name) const
+  {
+    return get_triton_input_request_shapes<T>(std::begin(requests_), std::end(requests_), name);
+  }
+
+  /**
+   * @brief Get the number of rows along the batch dimension contributed by
+   * each request
+   *
+   * This is only available once an input has been retrieved.
+   */
+  auto const& get_request_batch_dims() const
+  {
+    if (!batch_size_.has_value()) {
+      throw TritonException(Error::Internal,
+                            "At least one input must be retrieved before request boundaries");
     }
+    return request_batch_dims_;
+  }
 
-    // Set start time of batch to time latest input tensor was retrieved
-    compute_start_time_ = std::chrono::steady_clock::now();
+  /**
+   * @brief Get the index along the batch dimension of the first row of each
+   * request
+   */
+  auto get_request_row_offsets() const
+  {
+    auto const& batch_dims = get_request_batch_dims();
+    auto result            = std::vector<size_type>(batch_dims.size());
+    std::exclusive_scan(batch_dims.begin(), batch_dims.end(), result.begin(), size_type{});
+    return result;
+  }
 
-    return Tensor(std::move(shape), std::move(buffer));
+  /**
+   * @brief Get tensors for several inputs at once
+   *
+   * Unlike successive calls to `get_input`, which each walk all requests to
+   * determine the input's shape and finalize the input collection
+   * separately, this gathers every input in a single collection pass with at
+   * most one stream synchronization for the whole set. The element type of
+   * each input is given as a template argument and the tensors are returned
+   * as a tuple in the same order as the descriptors, e.g.
+   *
+   *   auto [features, mask] = batch.get_inputs<float const, bool const>(
+   *     stream, {"features", HostMemory, 0}, {"mask", HostMemory, 0});
+   */
+  template <typename... Ts>
+  auto get_inputs(cudaStream_t stream, detail::for_each_t<InputDescriptor, Ts> const&... inputs)
+  {
+    auto descriptors = std::array<InputDescriptor const*, sizeof...(Ts)>{&inputs...};
+    auto shapes      = get_input_shapes(std::vector<std::string>{inputs.name...},
+                                   std::vector<DType>{TritonDtype<Ts>::value...});
+    auto index       = std::size_t{};
+    // Braced initialization guarantees that the inputs are processed in order
+    auto collected =
+      std::array<CollectedInput, sizeof...(Ts)>{collect_input<Ts>(inputs, shapes[index++])...};
+    finalize_input_collection(collected.begin(), collected.end(), stream);
+    return make_inputs<Ts...>(
+      std::index_sequence_for<Ts...>{}, std::move(shapes), collected, descriptors, stream);
   }
 
+  /**
+   * @brief Get tensors for several inputs of the same type at once
+   *
+   * This behaves like the variadic overload but accepts any number of
+   * descriptors at runtime, returning the tensors in the same order.
+   */
   template <typename T>
-  auto get_input(std::string const& name,
-                 std::optional<MemoryType> const& memory_type,
-                 device_id_t device_id)
+  auto get_inputs(std::vector<InputDescriptor> const& inputs, cudaStream_t stream)
   {
-    return get_input<T>(name, memory_type, device_id, stream_);
+    auto names = std::vector<std::string>{};
+    names.reserve(inputs.size());
+    std::transform(std::begin(inputs),
+                   std::end(inputs),
+                   std::back_inserter(names),
+                   [](auto const& input) { return input.name; });
+    auto shapes =
+      get_input_shapes(names, std::vector<DType>(inputs.size(), TritonDtype<T>::value));
+    auto collected = std::vector<CollectedInput>{};
+    collected.reserve(inputs.size());
+    for (auto i = std::size_t{}; i < inputs.size(); ++i) {
+      collected.push_back(collect_input<T>(inputs[i], shapes[i]));
+    }
+    finalize_input_collection(collected.begin(), collected.end(), stream);
+
+    auto result = std::vector<Tensor<T>>{};
+    result.reserve(inputs.size());
+    for (auto i = std::size_t{}; i < inputs.size(); ++i) {
+      result.push_back(make_input<T>(std::move(shapes[i]), collected[i], inputs[i], stream));
+    }
+    return result;
   }
 
+  template <typename T>
+  auto get_inputs(std::vector<InputDescriptor> const& inputs)
+  {
+    return get_inputs<T>(inputs, stream_);
+  }
+
+  /**
+   * @brief Get a tensor in which to store the named output for the entire
+   * batch
+   *
+   * If the batch was constructed with an output pool, the tensor's memory is
+   * borrowed from the pool and is *not* initialized; it is returned to the
+   * pool once the responses have been sent by `finalize`. Otherwise, a new
+   * zero-initialized allocation is made for every call.
+   */
   template <typename T>
   auto get_output(std::string const& name,
                   std::optional<MemoryType> const& memory_type,
@@ -204,18 +351,10 @@ struct Batch {
       throw TritonException(Error::Internal,
                             "At least one input must be retrieved before any output");
     }
-    auto shape       = get_output_shape_(name, batch_size_.value());
-    auto buffer_size = std::reduce(shape.begin(), shape.end(), std::size_t{1}, std::multiplies<>());
-    auto final_memory_type = MemoryType{};
-    if (memory_type.has_value()) {
-      final_memory_type = memory_type.value();
-    } else {
-      // If consumer doesn't care, use HostMemory to avoid additional copy on
-      // non-shared-memory responses.
-      final_memory_type = HostMemory;
-    }
-    auto buffer = Buffer<T>(buffer_size, final_memory_type, device_id, stream);
-    return OutputTensor<T>(std::move(shape), std::move(buffer), name, responder_);
+    auto shape  = get_output_shape_(name, batch_size_.value());
+    auto buffer = allocate_output<T>(shape, memory_type, device_id, stream);
+    has_outputs_ = true;
+    return OutputTensor<T>(std::move(shape), std::move(buffer), name, responder_, stream_);
   }
 
   template <typename T>
@@ -226,16 +365,251 @@ struct Batch {
     return get_output<T>(name, memory_type, device_id, stream_);
   }
 
+  /**
+   * @brief Get a tensor of the given shape in which to store the named
+   * output for the entire batch
+   *
+   * This allows outputs whose size depends on the data rather than the
+   * model config, such as top-k results or detections. `shape` is the shape
+   * of the output for the whole batch, and `request_rows[i]` is the number
+   * of rows along its first dimension which belong to the ith request, so
+   * that these must sum to `shape[0]`. Any dimension of `shape` which is not
+   * variable in the model config must match the config. Memory is allocated
+   * once for the whole batch as with the other overloads, and each request
+   * is sent its own rows when the tensor is finalized.
+   */
+  template <typename T>
+  auto get_output(std::string const& name,
+                  std::vector<size_type> shape,
+                  std::vector<size_type> request_rows,
+                  std::optional<MemoryType> const& memory_type,
+                  device_id_t device_id,
+                  cudaStream_t stream)
+  {
+    detail::check_request_rows(name,
+                               shape,
+                               request_rows,
+                               responses_.size(),
+                               get_config_output_shape_ ? get_config_output_shape_(name)
+                                                        : std::vector<std::int64_t>{});
+    auto buffer = allocate_output<T>(shape, memory_type, device_id, stream);
+    has_outputs_ = true;
+    return OutputTensor<T>(
+      std::move(shape), std::move(buffer), name, &responses_, std::move(request_rows));
+  }
+
+  template <typename T>
+  auto get_output(std::string const& name,
+                  std::vector<size_type> shape,
+                  std::vector<size_type> request_rows,
+                  std::optional<MemoryType> const& memory_type,
+                  device_id_t device_id)
+  {
+    return get_output<T>(
+      name, std::move(shape), std::move(request_rows), memory_type, device_id, stream_);
+  }
+
+  /**
+   * @brief Get an output tensor which shares the memory of an input tensor
+   *
+   * The returned tensor views all of the input's elements with the given
+   * shape, so identity and reshape outputs can be sent without allocating or
+   * filling an output buffer. Since the output is divided between the
+   * requests along its first dimension in the same way as the inputs, that
+   * dimension must be the batch size. Input tensors retrieved from a batch
+   * view memory owned by the requests or by the batch's input collector,
+   * which remains valid until the batch is finalized, so the input tensor
+   * object itself need not outlive the returned output.
+   */
+  template <typename U>
+  auto get_output_alias(std::string const& name,
+                        BaseTensor<U> const& input,
+                        std::vector<size_type> shape)
+  {
+    using T = std::remove_const_t<U>;
+
+    if (!batch_size_.has_value()) {
+      throw TritonException(Error::InvalidArg,
+                            "output alias " + name + " requires an input of the batch");
+    }
+    auto alias_batch_dim = shape.empty() ? size_type{} : shape[0];
+    auto alias_size      =
+      std::reduce(shape.begin(), shape.end(), std::size_t{1}, std::multiplies<>());
+    if (alias_batch_dim != batch_size_.value() || alias_size != input.size()) {
+      throw TritonException(
+        Error::InvalidArg,
+        "output alias " + name + " must have the batch size and the elements of its input");
+    }
+    // The responder only reads from the buffer, so dropping const is safe
+    auto buffer = Buffer<T>(const_cast<T*>(input.data()),
+                            alias_size,
+                            input.mem_type(),
+                            input.device(),
+                            input.stream());
+    has_outputs_ = true;
+    return OutputTensor<T>(std::move(shape), std::move(buffer), name, responder_, stream_);
+  }
+
+  template <typename U>
+  auto get_output_alias(std::string const& name, BaseTensor<U> const& input)
+  {
+    return get_output_alias(name, input, input.shape());
+  }
+
+  /**
+   * @brief Get a tensor whose storage is the response buffers of the named
+   * output for each request in the batch
+   *
+   * Each request's output is created up front with
+   * `TRITONBACKEND_ResponseOutput`, and the buffer Triton provides for it is
+   * exposed as one region of the returned tensor. Data written to the tensor
+   * therefore goes straight into the responses without an additional copy.
+   * Triton may place a region in a different memory type than the one
+   * requested, so models should check the memory type of each region before
+   * writing to it. A direct output should not also be retrieved with
+   * `get_output`.
+   */
+  template <typename T>
+  auto get_direct_output(std::string const& name,
+                         std::optional<MemoryType> const& memory_type,
+                         device_id_t device_id,
+                         cudaStream_t stream)
+  {
+    if (!batch_size_.has_value()) {
+      throw TritonException(Error::Internal,
+                            "At least one input must be retrieved before any output");
+    }
+    auto shape   = get_output_shape_(name, batch_size_.value());
+    has_outputs_ = true;
+
+    auto regions = std::vector<Buffer<T>>{};
+    regions.reserve(responses_.size());
+    auto row_offsets = std::vector<size_type>{};
+    row_offsets.reserve(responses_.size());
+
+    auto row_offset = size_type{};
+    for (auto i = std::size_t{}; i < responses_.size(); ++i) {
+      auto request_shape = get_output_shape_(name, request_batch_dims_[i]);
+      auto region_size   = std::reduce(
+        request_shape.begin(), request_shape.end(), std::size_t{1}, std::multiplies<>());
+      auto region_memory_type = memory_type.value_or(HostMemory);
+
+      auto* response = responses_[i];
+      if (response == nullptr) {
+        // The response for this request has already failed; give the model
+        // somewhere harmless to write its rows
+        regions.emplace_back(region_size, region_memory_type, device_id, stream);
+      } else {
+        auto triton_shape = std::vector<std::int64_t>{};
+        triton_shape.reserve(request_shape.size());
+        std::transform(std::begin(request_shape),
+                       std::end(request_shape),
+                       std::back_inserter(triton_shape),
+                       [](auto& val) { return narrow<int64_t>(val); });
+
+        auto* output = static_cast<TRITONBACKEND_Output*>(nullptr);
+        triton_check(TRITONBACKEND_ResponseOutput(response,
+                                                  &output,
+                                                  name.c_str(),
+                                                  TritonDtype<T>::value,
+                                                  triton_shape.data(),
+                                                  triton_shape.size()));
+
+        auto* raw_buffer          = static_cast<void*>(nullptr);
+        auto actual_memory_type   = region_memory_type;
+        auto actual_memory_device = int64_t{device_id};
+        triton_check(TRITONBACKEND_OutputBuffer(output,
+                                                &raw_buffer,
+                                                region_size * sizeof(T),
+                                                &actual_memory_type,
+                                                &actual_memory_device));
+        if (actual_memory_type == TRITONSERVER_MEMORY_CPU_PINNED) {
+          actual_memory_type = HostMemory;
+        }
+        regions.emplace_back(static_cast<T*>(raw_buffer),
+                             region_size,
+                             actual_memory_type,
+                             narrow<device_id_t>(actual_memory_device),
+                             stream);
+      }
+      row_offsets.push_back(row_offset);
+      row_offset += request_batch_dims_[i];
+    }
+
+    return DirectOutputTensor<T>(std::move(shape), std::move(regions), std::move(row_offsets));
+  }
+
+  template <typename T>
+  auto get_direct_output(std::string const& name,
+                         std::optional<MemoryType> const& memory_type,
+                         device_id_t device_id)
+  {
+    return get_direct_output<T>(name, memory_type, device_id, stream_);
+  }
+
+  /**
+   * @brief Get the sender through which a decoupled model may send several
+   * responses to each request of this batch
+   *
+   * This is only available if the model config sets
+   * `model_transaction_policy { decoupled: true }`. Outputs retrieved from
+   * the batch itself, if any, are sent in the final response to each
+   * request when the batch is finalized; otherwise, each request is
+   * completed by the sender with just the final flag.
+   */
+  auto& get_response_sender()
+  {
+    if (!decoupled_) {
+      throw TritonException(Error::Internal,
+                            "only decoupled models may send several responses per request");
+    }
+    if (!sender_) {
+      sender_ = std::make_unique<ResponseSender>(std::begin(requests_),
+                                                 std::end(requests_),
+                                                 request_batch_dims_,
+                                                 get_output_shape_,
+                                                 get_config_output_shape_);
+    }
+    return *sender_;
+  }
+
   auto const& compute_start_time() const { return compute_start_time_; }
 
   auto stream() const { return stream_; }
 
-  void finalize(TRITONSERVER_Error* err)
+  /**
+   * @brief Send the responses for every request in the batch
+   *
+   * On success, the requests are released back to Triton. On failure, Triton
+   * resumes ownership of the requests if `err` is also returned from the
+   * execute call; if the backend has already returned from execute,
+   * `release_on_error` must be set so that the requests are released here.
+   */
+  void finalize(TRITONSERVER_Error* err, bool release_on_error = false)
   {
     auto compute_end_time = std::chrono::steady_clock::now();
     if (responder_->Finalize()) { cuda_check(cudaStreamSynchronize(stream_)); }
+    // The responder has finished copying out of the pooled output buffers
+    output_leases_.clear();
 
-    send_responses(std::begin(responses_), std::end(responses_), err);
+    if (decoupled_ && err == nullptr && !has_outputs_) {
+      // Nothing was added to the batch's own responses, so complete each
+      // request through its response factory instead
+      auto& sender = get_response_sender();
+      delete_responses(std::begin(responses_), std::end(responses_));
+      sender.close();
+    } else {
+      if (sender_ && err == nullptr) {
+        try {
+          sender_->send();
+        } catch (TritonException& sender_err) {
+          log_error(__FILE__, __LINE__, sender_err.what());
+        }
+      } else if (sender_) {
+        sender_->discard();
+      }
+      send_responses(std::begin(responses_), std::end(responses_), err);
+    }
 
     // Triton resumes ownership of failed requests; only release on success
     if (err == nullptr) {
@@ -247,14 +621,181 @@ struct Batch {
                              compute_end_time,
                              std::chrono::steady_clock::now());
         });
+    }
+    if (err == nullptr || release_on_error) {
       release_requests(std::begin(requests_), std::end(requests_));
     }
   }
 
  private:
+  /* Location and size of an input as reported by the input collector */
+  struct CollectedInput {
+    char const* buffer;
+    std::size_t bytes;
+    MemoryType mem_type;
+    int64_t device_id;
+  };
+
+  void check_batch_size(std::vector<size_type> const& shape, std::string const& name)
+  {
+    auto input_batch_dim = size_type{};
+    if (shape.size() > 0) { input_batch_dim = shape[0]; }
+
+    if (batch_size_.has_value()) {
+      if (batch_size_.value() != input_batch_dim) {
+        throw TritonException(Error::Internal, "all input tensors must have same batch dimension");
+      }
+    } else {
+      batch_size_ = input_batch_dim;
+      request_batch_dims_ =
+        get_triton_input_batch_dims(std::begin(requests_), std::end(requests_), name);
+    }
+  }
+
+  /* Allocate the buffer for an output of the whole batch, borrowing it from
+   * the output pool if there is one */
+  template <typename T>
+  auto allocate_output(std::vector<size_type> const& shape,
+                       std::optional<MemoryType> const& memory_type,
+                       device_id_t device_id,
+                       cudaStream_t stream)
+  {
+    auto buffer_size = std::reduce(shape.begin(), shape.end(), std::size_t{1}, std::multiplies<>());
+    auto final_memory_type = MemoryType{};
+    if (memory_type.has_value()) {
+      final_memory_type = memory_type.value();
+    } else {
+      // If consumer doesn't care, use HostMemory to avoid additional copy on
+      // non-shared-memory responses.
+      final_memory_type = HostMemory;
+    }
+    auto buffer = Buffer<T>{};
+    if (output_pool_) {
+      auto lease =
+        output_pool_->acquire(buffer_size * sizeof(T), final_memory_type, device_id, stream);
+      buffer = Buffer<T>(
+        reinterpret_cast<T*>(lease->data()), buffer_size, final_memory_type, device_id, stream);
+      output_leases_.push_back(std::move(lease));
+    } else {
+      buffer = Buffer<T>(buffer_size, final_memory_type, device_id, stream);
+    }
+    return buffer;
+  }
+
+  /* Determine the shapes of several inputs in one walk over the requests */
+  auto get_input_shapes(std::vector<std::string> const& names, std::vector<DType> const& dtypes)
+  {
+    auto result = std::vector<std::vector<size_type>>(names.size());
+    if (!requests_.empty()) {
+      result = get_triton_input_shapes(std::begin(requests_), std::end(requests_), names, dtypes);
+      for (auto i = std::size_t{}; i < names.size(); ++i) {
+        check_batch_size(result[i], names[i]);
+      }
+    }
+    return result;
+  }
+
+  /* Queue an input with the collector; the data may not be available until
+   * `finalize_input_collection` is called */
+  template <typename T>
+  auto collect_input(InputDescriptor const& input, std::vector<size_type> const& shape)
+  {
+    auto size_bytes =
+      sizeof(T) * std::reduce(shape.begin(), shape.end(), std::size_t{1}, std::multiplies<>());
+    auto allowed_memory_configs = std::vector<std::pair<MemoryType, int64_t>>{};
+    if (input.memory_type.has_value()) {
+      allowed_memory_configs.emplace_back(input.memory_type.value(), input.device_id);
+    } else {
+      allowed_memory_configs.emplace_back(HostMemory, int64_t{});
+      allowed_memory_configs.emplace_back(DeviceMemory, input.device_id);
+    }
+
+    auto result =
+      CollectedInput{static_cast<char*>(nullptr), std::size_t{}, MemoryType{}, int64_t{}};
+
+    triton_check(
+      collector_.ProcessTensor(input.name.c_str(),
+                               static_cast<char*>(nullptr),  // Return data without copy if possible
+                               size_bytes,
+                               allowed_memory_configs,
+                               &result.buffer,
+                               &result.bytes,
+                               &result.mem_type,
+                               &result.device_id));
+    return result;
+  }
+
+  /* Complete all pending input copies
+   *
+   * Copies into device memory are left in flight on the batch's stream, and
+   * the stream which will consume the inputs is ordered after them with an
+   * event. The host only blocks if some input was collected into host
+   * memory. */
+  template <typename Iter>
+  void finalize_input_collection(Iter collected_begin, Iter collected_end, cudaStream_t stream)
+  {
+    if(collector_.Finalize()){
+      if constexpr (IS_GPU_BUILD) {
+        auto device_only = std::all_of(collected_begin, collected_end, [](auto const& input) {
+          return input.mem_type == DeviceMemory;
+        });
+        if (!device_only) {
+          cuda_check(cudaStreamSynchronize(stream_));
+        } else if (stream != stream_) {
+          auto inputs_ready = Event{};
+          inputs_ready.record(stream_);
+          inputs_ready.wait(stream);
+        }
+      } else {
+        throw TritonException(Error::Internal, "stream synchronization required in non-GPU build");
+      }
+    }
+
+    std::for_each(std::begin(responses_), std::end(responses_), [](auto* response) {
+      if (response == nullptr) {
+        throw TritonException(Error::Internal, "Input collection failed");
+      }
+    });
+
+    // Set start time of batch to time latest input tensor was retrieved
+    compute_start_time_ = std::chrono::steady_clock::now();
+  }
+
+  template <typename T>
+  auto make_input(std::vector<size_type>&& shape,
+                  CollectedInput const& collected,
+                  InputDescriptor const& input,
+                  cudaStream_t stream)
+  {
+    auto buffer = Buffer(reinterpret_cast<T*>(collected.buffer),
+                         collected.bytes / sizeof(T),
+                         collected.mem_type,
+                         collected.device_id,
+                         stream);
+
+    if (input.memory_type &&
+        (collected.mem_type != input.memory_type || collected.device_id != input.device_id)) {
+      throw TritonException(Error::Internal, "data collected in wrong location");
+    }
+
+    return Tensor(std::move(shape), std::move(buffer));
+  }
+
+  template <typename... Ts, std::size_t... Is>
+  auto make_inputs(std::index_sequence<Is...>,
+                   std::vector<std::vector<size_type>>&& shapes,
+                   std::array<CollectedInput, sizeof...(Ts)> const& collected,
+                   std::array<InputDescriptor const*, sizeof...(Ts)> const& descriptors,
+                   cudaStream_t stream)
+  {
+    return std::tuple<Tensor<Ts>...>{
+      make_input<Ts>(std::move(shapes[Is]), collected[Is], *descriptors[Is], stream)...};
+  }
+
   std::vector<TRITONBACKEND_Request*> requests_;
   std::vector<TRITONBACKEND_Response*> responses_;
   std::function<std::vector<size_type>(std::string const&, size_type)> get_output_shape_;
+  std::function<std::vector<std::int64_t>(std::string const&)> get_config_output_shape_;
   std::function<void(TRITONBACKEND_Request*,
                      time_point const&,
                      time_point const&,
@@ -267,6 +808,14 @@ struct Batch {
   std::chrono::time_point<std::chrono::steady_clock> start_time_;
   std::chrono::time_point<std::chrono::steady_clock> compute_start_time_;
   std::optional<size_type> batch_size_;
+  // The number of rows of the batch contributed by each request
+  std::vector<size_type> request_batch_dims_;
+  std::shared_ptr<BufferPool> output_pool_;
+  std::vector<BufferPool::lease_type> output_leases_;
+  bool decoupled_;
+  // Whether any output has been added to the batch's own responses
+  bool has_outputs_;
+  std::unique_ptr<ResponseSender> sender_;
 };
 }  // namespace backend
 }  // namespace developer_tools
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include <triton/developer_tools/exceptions.hpp>
+#include <triton/developer_tools/stream/ordered_queue.hpp>
+
+namespace triton {
+namespace developer_tools {
+namespace backend {
+/**
+ * @brief Tracks batches whose inference has been started but whose responses
+ * have not yet been sent
+ *
+ * Each submitted batch is completed on a dedicated thread once its future is
+ * ready, in the order in which batches were submitted. At most
+ * `max_inflight` batches may await completion at a time; further submissions
+ * block until an earlier batch completes, which bounds the memory held by
+ * batches in flight.
+ */
+struct InflightBatches {
+  using size_type = std::size_t;
+
+  explicit InflightBatches(size_type max_inflight)
+    : max_inflight_{max_inflight}, count_{}, mtx_{}, slot_free_{}, completions_{}
+  {
+    if (max_inflight_ == 0) {
+      throw TritonException(Error::InvalidArg, "at least one batch must be allowed in flight");
+    }
+  }
+
+  InflightBatches(InflightBatches const&) = delete;
+  InflightBatches& operator=(InflightBatches const&) = delete;
+
+  /**
+   * @brief Arrange for `on_complete` to be invoked once `done` is ready
+   *
+   * `on_complete` receives the exception stored in `done`, if any. It must
+   * not throw, since there is no caller left to report the error to.
+   */
+  void submit(std::future<void>&& done, std::function<void(std::exception_ptr)> on_complete)
+  {
+    {
+      auto lock = std::unique_lock<std::mutex>{mtx_};
+      slot_free_.wait(lock, [this]() { return count_ < max_inflight_; });
+      ++count_;
+    }
+    auto shared_done = std::make_shared<std::future<void>>(std::move(done));
+    completions_.enqueue([this, shared_done, on_complete = std::move(on_complete)]() {
+      auto error = std::exception_ptr{};
+      try {
+        shared_done->get();
+      } catch (...) {
+        error = std::current_exception();
+      }
+      on_complete(error);
+      {
+        auto lock = std::lock_guard<std::mutex>{mtx_};
+        --count_;
+      }
+      slot_free_.notify_all();
+    });
+  }
+
+  /**
+   * @brief Block until every submitted batch has been completed
+   */
+  void wait_all()
+  {
+    auto lock = std::unique_lock<std::mutex>{mtx_};
+    slot_free_.wait(lock, [this]() { return count_ == 0; });
+  }
+
+  auto max_inflight() const { return max_inflight_; }
+
+  auto inflight() const
+  {
+    auto lock = std::lock_guard<std::mutex>{mtx_};
+    return count_;
+  }
+
+ private:
+  size_type max_inflight_;
+  size_type count_;
+  mutable std::mutex mtx_;
+  std::condition_variable slot_free_;
+  // Declared last so that pending completions are drained before any other
+  // member is destroyed
+  OrderedQueue completions_;
+};
+
+}  // namespace backend
+}  // namespace developer_tools
+}  // namespace triton
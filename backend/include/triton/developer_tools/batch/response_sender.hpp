@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#ifdef TRITON_ENABLE_GPU
+#include <cuda_runtime_api.h>
+#else
+#include <triton/developer_tools/cpu_only/cuda_runtime_replacement.hpp>
+#endif
+#include <triton/core/tritonbackend.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <triton/developer_tools/exceptions.hpp>
+#include <triton/developer_tools/memory/buffer.hpp>
+#include <triton/developer_tools/memory/types.hpp>
+#include <triton/developer_tools/tensor/tensor.hpp>
+#include <triton/developer_tools/triton/device.hpp>
+#include <triton/developer_tools/triton/logging.hpp>
+#include <triton/developer_tools/triton/responses.hpp>
+#include <triton/developer_tools/utils/narrow.hpp>
+#include <utility>
+#include <vector>
+
+namespace triton {
+namespace developer_tools {
+namespace backend {
+namespace detail {
+/* Check that an output shape and its division into rows per request are
+ * consistent with each other and with the shape of the output in the model
+ * config, in which variable dimensions are given as -1 */
+inline void check_request_rows(std::string const& name,
+                               std::vector<std::size_t> const& shape,
+                               std::vector<std::size_t> const& request_rows,
+                               std::size_t request_count,
+                               std::vector<std::int64_t> const& config_shape)
+{
+  if (shape.empty() || request_rows.size() != request_count ||
+      std::reduce(request_rows.begin(), request_rows.end(), std::size_t{}) != shape[0]) {
+    throw TritonException(Error::InvalidArg,
+                          "rows of output " + name + " must be divided between all requests");
+  }
+  auto consistent = config_shape.empty() || config_shape.size() == shape.size();
+  for (auto dim = std::size_t{}; consistent && dim < config_shape.size(); ++dim) {
+    consistent = config_shape[dim] < 0 || narrow<std::size_t>(config_shape[dim]) == shape[dim];
+  }
+  if (!consistent) {
+    throw TritonException(
+      Error::InvalidArg,
+      "shape requested for output " + name + " does not match its shape in the model config");
+  }
+}
+}  // namespace detail
+
+/**
+ * @brief Sends any number of responses to each request of a batch for
+ * models using the decoupled transaction policy
+ *
+ * Outputs retrieved from a ResponseSender cover the whole batch, exactly as
+ * those retrieved from the Batch itself, and each request receives its own
+ * rows of them. Once the outputs of a step have been finalized, `send`
+ * delivers one response per request containing all of them, and the next
+ * outputs retrieved begin a new response. The batch completes each request
+ * with the final flag when it is finalized.
+ *
+ * The sender refers to the batch size of each request as recorded by the
+ * batch, which must therefore outlive it.
+ */
+struct ResponseSender {
+  using size_type = std::size_t;
+
+  template <typename Iter>
+  ResponseSender(
+    Iter requests_begin,
+    Iter requests_end,
+    std::vector<size_type> const& request_batch_dims,
+    std::function<std::vector<size_type>(std::string const&, size_type)> get_output_shape,
+    std::function<std::vector<std::int64_t>(std::string const&)> get_config_output_shape = {})
+    : factories_{construct_response_factories(requests_begin, requests_end)},
+      responses_(factories_.size()),
+      request_batch_dims_{request_batch_dims},
+      get_output_shape_{std::move(get_output_shape)},
+      get_config_output_shape_{std::move(get_config_output_shape)},
+      closed_{false}
+  {
+  }
+
+  ResponseSender(ResponseSender const&) = delete;
+  ResponseSender& operator=(ResponseSender const&) = delete;
+
+  ~ResponseSender()
+  {
+    discard();
+    delete_response_factories(std::begin(factories_), std::end(factories_));
+  }
+
+  /**
+   * @brief Get a tensor in which to store the named output of the next
+   * response for the entire batch, with each request's share of its rows
+   * given by its batch size
+   */
+  template <typename T>
+  auto get_output(std::string const& name,
+                  std::optional<MemoryType> const& memory_type,
+                  device_id_t device_id,
+                  cudaStream_t stream)
+  {
+    if (request_batch_dims_.size() != factories_.size()) {
+      throw TritonException(Error::Internal,
+                            "At least one input must be retrieved before any output");
+    }
+    auto batch_size =
+      std::reduce(request_batch_dims_.begin(), request_batch_dims_.end(), size_type{});
+    return get_output<T>(name,
+                         get_output_shape_(name, batch_size),
+                         request_batch_dims_,
+                         memory_type,
+                         device_id,
+                         stream);
+  }
+
+  /**
+   * @brief Get a tensor of the given shape in which to store the named
+   * output of the next response for the entire batch
+   *
+   * As with `Batch::get_output`, `request_rows[i]` is the number of rows
+   * along the first dimension of `shape` which belong to the ith request.
+   * Since the rows of each step are sent as soon as possible, the buffer is
+   * allocated afresh for each call rather than borrowed from the batch's
+   * output pool.
+   */
+  template <typename T>
+  auto get_output(std::string const& name,
+                  std::vector<size_type> shape,
+                  std::vector<size_type> request_rows,
+                  std::optional<MemoryType> const& memory_type,
+                  device_id_t device_id,
+                  cudaStream_t stream)
+  {
+    if (closed_) {
+      throw TritonException(Error::Internal,
+                            "cannot add output " + name + " after the final response");
+    }
+    detail::check_request_rows(name,
+                               shape,
+                               request_rows,
+                               factories_.size(),
+                               get_config_output_shape_ ? get_config_output_shape_(name)
+                                                        : std::vector<std::int64_t>{});
+    start_responses();
+    auto buffer_size = std::reduce(shape.begin(), shape.end(), std::size_t{1}, std::multiplies<>());
+    auto buffer = Buffer<T>(buffer_size, memory_type.value_or(HostMemory), device_id, stream);
+    return OutputTensor<T>(
+      std::move(shape), std::move(buffer), name, &responses_, std::move(request_rows));
+  }
+
+  /**
+   * @brief Send a response to every request with all outputs finalized
+   * since the last call
+   */
+  void send()
+  {
+    if (closed_) {
+      throw TritonException(Error::Internal, "cannot send responses after the final response");
+    }
+    for (auto& response : responses_) {
+      if (response != nullptr) {
+        auto* sent = response;
+        response   = nullptr;
+        triton_check(TRITONBACKEND_ResponseSend(sent, 0, nullptr));
+      }
+    }
+  }
+
+  /**
+   * @brief Complete every request, sending any outputs which have been
+   * finalized but not yet sent along with the final flag
+   *
+   * This is called when the batch is finalized. Errors are logged rather
+   * than thrown, since the requests are released regardless.
+   */
+  void close()
+  {
+    if (closed_) { return; }
+    closed_ = true;
+    for (auto i = std::size_t{}; i < factories_.size(); ++i) {
+      try {
+        if (responses_[i] != nullptr) {
+          auto* sent    = responses_[i];
+          responses_[i] = nullptr;
+          triton_check(
+            TRITONBACKEND_ResponseSend(sent, TRITONSERVER_RESPONSE_COMPLETE_FINAL, nullptr));
+        } else {
+          triton_check(TRITONBACKEND_ResponseFactorySendFlags(
+            factories_[i], TRITONSERVER_RESPONSE_COMPLETE_FINAL));
+        }
+      } catch (TritonException& err) {
+        log_error(__FILE__, __LINE__, err.what());
+      }
+    }
+  }
+
+  /**
+   * @brief Drop any outputs which have not yet been sent, e.g. because the
+   * batch failed and its requests will be completed with an error
+   */
+  void discard() { delete_responses(std::begin(responses_), std::end(responses_)); }
+
+ private:
+  std::vector<TRITONBACKEND_ResponseFactory*> factories_;
+  // Responses currently being assembled, or nullptr if no output has been
+  // retrieved for a request since the last call to `send`
+  std::vector<TRITONBACKEND_Response*> responses_;
+  // Empty until the batch has retrieved its first input
+  std::vector<size_type> const& request_batch_dims_;
+  std::function<std::vector<size_type>(std::string const&, size_type)> get_output_shape_;
+  std::function<std::vector<std::int64_t>(std::string const&)> get_config_output_shape_;
+  bool closed_;
+
+  /* Begin the next response for every request if it has not been begun */
+  void start_responses()
+  {
+    for (auto i = std::size_t{}; i < factories_.size(); ++i) {
+      if (responses_[i] == nullptr) {
+        triton_check(TRITONBACKEND_ResponseNewFromFactory(&responses_[i], factories_[i]));
+      }
+    }
+  }
+};
+}  // namespace backend
+}  // namespace developer_tools
+}  // namespace triton
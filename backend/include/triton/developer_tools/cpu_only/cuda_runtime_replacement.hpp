@@ -39,6 +39,47 @@ inline auto cudaStreamSynchronize(cudaStream_t stream) {
   return cudaError_t::cudaErrorNonGpuBuild;
 }
 
+inline auto cudaSetDevice(int device_id) {
+  return cudaError_t::cudaErrorNonGpuBuild;
+}
+
+using cudaEvent_t = void*;
+using cudaHostFn_t = void (*)(void*);
+auto constexpr cudaEventDisableTiming = 0x02u;
+auto constexpr cudaStreamNonBlocking = 0x01u;
+
+inline auto cudaStreamCreateWithFlags(cudaStream_t* stream, unsigned int flags) {
+  return cudaError_t::cudaErrorNonGpuBuild;
+}
+
+inline auto cudaStreamDestroy(cudaStream_t stream) {
+  return cudaError_t::cudaErrorNonGpuBuild;
+}
+
+inline auto cudaEventCreateWithFlags(cudaEvent_t* event, unsigned int flags) {
+  return cudaError_t::cudaErrorNonGpuBuild;
+}
+
+inline auto cudaEventDestroy(cudaEvent_t event) {
+  return cudaError_t::cudaErrorNonGpuBuild;
+}
+
+inline auto cudaEventRecord(cudaEvent_t event, cudaStream_t stream) {
+  return cudaError_t::cudaErrorNonGpuBuild;
+}
+
+inline auto cudaEventSynchronize(cudaEvent_t event) {
+  return cudaError_t::cudaErrorNonGpuBuild;
+}
+
+inline auto cudaStreamWaitEvent(cudaStream_t stream, cudaEvent_t event, unsigned int flags) {
+  return cudaError_t::cudaErrorNonGpuBuild;
+}
+
+inline auto cudaLaunchHostFunc(cudaStream_t stream, cudaHostFn_t fn, void* user_data) {
+  return cudaError_t::cudaErrorNonGpuBuild;
+}
+
 inline auto cudaGetDevice(int* device_id) {
   return cudaError_t::cudaErrorNonGpuBuild;
 }
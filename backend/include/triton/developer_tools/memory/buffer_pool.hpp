@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#ifdef TRITON_ENABLE_GPU
+#include <cuda_runtime_api.h>
+#include <triton/developer_tools/memory/detail/gpu_only/owned_device_buffer.hpp>
+#else
+#include <triton/developer_tools/cpu_only/cuda_runtime_replacement.hpp>
+#include <triton/developer_tools/memory/detail/cpu_only/owned_device_buffer.hpp>
+#endif
+
+#include <triton/developer_tools/build_control.hpp>
+#include <triton/developer_tools/exceptions.hpp>
+#include <triton/developer_tools/memory/types.hpp>
+#include <triton/developer_tools/triton/device.hpp>
+
+namespace triton {
+namespace developer_tools {
+namespace backend {
+/**
+ * @brief A pool of uninitialized host and device allocations which are
+ * recycled by size class
+ *
+ * Requested sizes are rounded up to the next power of two (with a minimum of
+ * `min_block_bytes`), and blocks of the same memory type, device and size
+ * class are reused once every lease on them has been dropped. Unlike owning
+ * Buffers, host blocks are not value-initialized, so callers must write every
+ * element they read back. Device blocks are allocated through the current
+ * RMM resource on the stream passed when they are first created; callers must
+ * ensure that all work on a block has completed before dropping its lease.
+ *
+ * Pools are always held through a std::shared_ptr so that outstanding leases
+ * can safely outlive them, in which case the blocks are simply freed.
+ */
+struct BufferPool : std::enable_shared_from_this<BufferPool> {
+  using size_type = std::size_t;
+
+  /**
+   * @brief A block of memory on loan from a pool
+   */
+  struct Block {
+    using host_data   = std::unique_ptr<std::byte[]>;
+    using device_data = detail::owned_device_buffer<std::byte, IS_GPU_BUILD>;
+
+    auto* data() const
+    {
+      return data_.index() == 0 ? std::get<0>(data_).get() : std::get<1>(data_).get();
+    }
+    auto bytes() const { return bytes_; }
+    auto mem_type() const { return mem_type_; }
+    auto device() const { return device_; }
+
+    Block(size_type bytes, MemoryType mem_type, device_id_t device, cudaStream_t stream)
+      : data_{[bytes, mem_type, device, stream]() {
+          auto result = std::variant<host_data, device_data>{};
+          if (mem_type == DeviceMemory) {
+            if constexpr (IS_GPU_BUILD) {
+              result.emplace<1>(device, bytes, stream);
+            } else {
+              throw TritonException(Error::Internal,
+                                    "DeviceMemory requested in CPU-only build");
+            }
+          } else {
+            // Default-initialization leaves the memory uninitialized
+            result = host_data{new std::byte[bytes]};
+          }
+          return result;
+        }()},
+        bytes_{bytes},
+        mem_type_{mem_type},
+        device_{device}
+    {
+    }
+
+   private:
+    std::variant<host_data, device_data> data_;
+    size_type bytes_;
+    MemoryType mem_type_;
+    device_id_t device_;
+  };
+
+  using lease_type = std::shared_ptr<Block>;
+
+  /**
+   * @brief Create a pool which caches at most `max_cached_bytes` of unused
+   * blocks, freeing any block released beyond that limit
+   */
+  static auto create(size_type max_cached_bytes = std::numeric_limits<size_type>::max(),
+                     size_type min_block_bytes  = size_type{256})
+  {
+    return std::shared_ptr<BufferPool>(new BufferPool(max_cached_bytes, min_block_bytes));
+  }
+
+  /**
+   * @brief Return the size of the blocks used for requests of `bytes` bytes
+   */
+  auto size_class(size_type bytes) const
+  {
+    auto result = min_block_bytes_;
+    while (result < bytes) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  /**
+   * @brief Borrow a block of at least `bytes` bytes in the given location
+   *
+   * The block returns to the pool when the last copy of the returned lease is
+   * destroyed.
+   */
+  auto acquire(size_type bytes, MemoryType mem_type, device_id_t device, cudaStream_t stream = 0)
+  {
+    auto block_bytes = size_class(bytes);
+    auto block       = std::unique_ptr<Block>{};
+    {
+      auto lock   = std::lock_guard<std::mutex>{mutex_};
+      auto& cache = free_blocks_[std::make_tuple(mem_type, device, block_bytes)];
+      if (!cache.empty()) {
+        block = std::move(cache.back());
+        cache.pop_back();
+        cached_bytes_ -= block_bytes;
+      }
+    }
+    if (!block) { block = std::make_unique<Block>(block_bytes, mem_type, device, stream); }
+
+    auto pool = weak_from_this();
+    return lease_type{block.release(), [pool](Block* released) {
+                        if (auto owner = pool.lock()) {
+                          owner->release(std::unique_ptr<Block>{released});
+                        } else {
+                          delete released;
+                        }
+                      }};
+  }
+
+  /**
+   * @brief Return the total size of the unused blocks held by the pool
+   */
+  auto cached_bytes() const
+  {
+    auto lock = std::lock_guard<std::mutex>{mutex_};
+    return cached_bytes_;
+  }
+
+  /**
+   * @brief Free all unused blocks
+   */
+  void clear()
+  {
+    auto lock = std::lock_guard<std::mutex>{mutex_};
+    free_blocks_.clear();
+    cached_bytes_ = size_type{};
+  }
+
+ private:
+  BufferPool(size_type max_cached_bytes, size_type min_block_bytes)
+    : max_cached_bytes_{max_cached_bytes},
+      min_block_bytes_{min_block_bytes == 0 ? size_type{1} : min_block_bytes},
+      cached_bytes_{}
+  {
+  }
+
+  void release(std::unique_ptr<Block>&& block)
+  {
+    auto lock = std::lock_guard<std::mutex>{mutex_};
+    if (max_cached_bytes_ - cached_bytes_ >= block->bytes()) {
+      cached_bytes_ += block->bytes();
+      free_blocks_[std::make_tuple(block->mem_type(), block->device(), block->bytes())]
+        .push_back(std::move(block));
+    }
+  }
+
+  size_type max_cached_bytes_;
+  size_type min_block_bytes_;
+  size_type cached_bytes_;
+  std::map<std::tuple<MemoryType, device_id_t, size_type>, std::vector<std::unique_ptr<Block>>>
+    free_blocks_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace backend
+}  // namespace developer_tools
+}  // namespace triton
@@ -21,14 +21,20 @@
 #include <triton/developer_tools/cpu_only/cuda_runtime_replacement.hpp>
 #endif
 #include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
 #include <triton/developer_tools/batch/batch.hpp>
 #include <triton/developer_tools/memory/resource.hpp>
 #include <triton/developer_tools/model/shared_state.hpp>
+#include <triton/developer_tools/stream/stream_pool.hpp>
 #include <triton/developer_tools/tensor/tensor.hpp>
 #include <triton/developer_tools/triton/deployment.hpp>
 #include <triton/developer_tools/triton/device.hpp>
 #include <triton/developer_tools/utils/narrow.hpp>
+#include <triton/developer_tools/utils/thread_pool.hpp>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace triton {
@@ -38,6 +44,31 @@ template <typename SharedState = SharedModelState>
 struct Model {
   virtual void predict(Batch& batch) const = 0;
 
+  /**
+   * @brief Start inference on a batch, returning a future which becomes
+   * ready once all of the batch's outputs have been finalized
+   *
+   * This is only called when the `max_inflight_batches` config parameter is
+   * greater than one, in which case the batch's responses are sent on another
+   * thread once the future is ready while Triton moves on to the next batch.
+   * The batch remains valid until then. The base implementation runs
+   * `predict` to completion and returns a ready future, which already lets
+   * sending one batch's responses overlap with the next batch; models whose
+   * work completes asynchronously (e.g. on a stream from the stream pool) may
+   * override this to return as soon as that work has been submitted.
+   */
+  virtual std::future<void> predict_async(Batch& batch) const
+  {
+    auto result = std::promise<void>{};
+    try {
+      predict(batch);
+      result.set_value();
+    } catch (...) {
+      result.set_exception(std::current_exception());
+    }
+    return result.get_future();
+  }
+
   virtual void load() {}
   virtual void unload() {}
 
@@ -69,14 +100,57 @@ struct Model {
   /**
    * @brief Retrieve a stream used to set up batches for this model
    *
-   * The base implementation of this method simply returns the default stream
-   * provided by Triton for use with this model. Child classes may choose to
-   * override this in order to provide different streams for use with
-   * successive incoming batches. For instance, one might cycle through
-   * several streams in order to distribute batches across them, but care
-   * should be taken to ensure proper synchronization in this case.
+   * The base implementation of this method returns the default stream
+   * provided by Triton for use with this model, unless the
+   * `stream_pool_size` config parameter is set to a positive value, in which
+   * case it cycles through a pool of that many streams so that successive
+   * batches can overlap. The helper methods below use the batch's stream by
+   * default, and the library orders input collection, compute and output
+   * transfers on different streams with events rather than by blocking.
+   * Child classes may override this to distribute batches across streams in
+   * other ways, but care should be taken to ensure proper synchronization of
+   * any additional streams they use.
+   */
+  virtual cudaStream_t get_stream() const
+  {
+    return stream_pool_ ? stream_pool_->get() : default_stream_;
+  }
+
+  /**
+   * @brief Retrieve the pool of streams from which batches are set up, or
+   * nullptr if every batch uses the default stream
+   */
+  auto get_stream_pool() const { return stream_pool_; }
+
+  /**
+   * @brief Invoke `body(chunk_begin, chunk_end)` over contiguous chunks of
+   * [begin, end) in parallel on the backend-wide thread pool
+   *
+   * This allows a single instance to spread a large batch across all cores
+   * of a CPU deployment. See `ThreadPool::parallel_for` for details.
+   */
+  template <typename F>
+  void parallel_for(std::size_t begin, std::size_t end, F&& body, std::size_t grain = 0) const
+  {
+    get_thread_pool()->parallel_for(begin, end, std::forward<F>(body), grain);
+  }
+
+  /**
+   * @brief Reduce [begin, end) in parallel on the backend-wide thread pool
+   *
+   * See `ThreadPool::parallel_reduce` for details.
    */
-  virtual cudaStream_t get_stream() const { return default_stream_; }
+  template <typename T, typename Map, typename Combine>
+  auto parallel_reduce(std::size_t begin,
+                       std::size_t end,
+                       T init,
+                       Map&& map,
+                       Combine&& combine,
+                       std::size_t grain = 0) const
+  {
+    return get_thread_pool()->parallel_reduce(
+      begin, end, std::move(init), std::forward<Map>(map), std::forward<Combine>(combine), grain);
+  }
 
   /**
    * @brief Get input tensor of a particular named input for an entire batch
@@ -94,12 +168,52 @@ struct Model {
                  std::string const& name,
                  std::optional<MemoryType> const& mem_type) const
   {
-    return get_input<T>(batch, name, mem_type, default_stream_);
+    return get_input<T>(batch, name, mem_type, batch.stream());
   }
   template <typename T>
   auto get_input(Batch& batch, std::string const& name) const
   {
-    return get_input<T>(batch, name, preferred_mem_type(batch), default_stream_);
+    return get_input<T>(batch, name, preferred_mem_type(batch), batch.stream());
+  }
+
+  /**
+   * @brief Get a named input whose shape may differ between the requests of
+   * a batch, without padding
+   */
+  template <typename T>
+  auto get_ragged_input(Batch& batch,
+                        std::string const& name,
+                        std::optional<MemoryType> const& mem_type,
+                        cudaStream_t stream) const
+  {
+    return batch.get_ragged_input<T const>(name, mem_type, device_id_, stream);
+  }
+  template <typename T>
+  auto get_ragged_input(Batch& batch, std::string const& name) const
+  {
+    return get_ragged_input<T>(batch, name, preferred_mem_type(batch), batch.stream());
+  }
+
+  /**
+   * @brief Get input tensors of several named inputs for an entire batch
+   *
+   * All inputs are collected in a single pass, so that multi-input models
+   * pay for at most one synchronization per batch rather than one per
+   * input. The element type of each input is given as a template argument,
+   * e.g. `auto [x, mask] = get_inputs<float, bool>(batch, "x", "mask");`
+   */
+  template <typename... Ts>
+  auto get_inputs(Batch& batch,
+                  std::optional<MemoryType> const& mem_type,
+                  cudaStream_t stream,
+                  detail::for_each_t<std::string, Ts> const&... names) const
+  {
+    return batch.get_inputs<Ts const...>(stream, InputDescriptor{names, mem_type, device_id_}...);
+  }
+  template <typename... Ts>
+  auto get_inputs(Batch& batch, detail::for_each_t<std::string, Ts> const&... names) const
+  {
+    return get_inputs<Ts...>(batch, preferred_mem_type(batch), batch.stream(), names...);
   }
 
   /**
@@ -127,12 +241,138 @@ struct Model {
                   std::string const& name,
                   std::optional<MemoryType> const& mem_type) const
   {
-    return get_output<T>(batch, name, mem_type, device_id_, default_stream_);
+    return get_output<T>(batch, name, mem_type, device_id_, batch.stream());
   }
   template <typename T>
   auto get_output(Batch& batch, std::string const& name) const
   {
-    return get_output<T>(batch, name, preferred_mem_type(batch), device_id_, default_stream_);
+    return get_output<T>(batch, name, preferred_mem_type(batch), device_id_, batch.stream());
+  }
+
+  /**
+   * @brief Get output tensor of a particular named output with a shape
+   * chosen by the model, given the number of its rows belonging to each
+   * request
+   */
+  template <typename T>
+  auto get_output(Batch& batch,
+                  std::string const& name,
+                  std::vector<std::size_t> shape,
+                  std::vector<std::size_t> request_rows,
+                  std::optional<MemoryType> const& mem_type,
+                  cudaStream_t stream) const
+  {
+    return batch.get_output<T>(
+      name, std::move(shape), std::move(request_rows), mem_type, device_id_, stream);
+  }
+  template <typename T>
+  auto get_output(Batch& batch,
+                  std::string const& name,
+                  std::vector<std::size_t> shape,
+                  std::vector<std::size_t> request_rows) const
+  {
+    return get_output<T>(batch,
+                         name,
+                         std::move(shape),
+                         std::move(request_rows),
+                         preferred_mem_type(batch),
+                         batch.stream());
+  }
+
+  /**
+   * @brief Get output tensor of a particular named output for the next of
+   * several responses sent to each request by a decoupled model
+   *
+   * Once all outputs of a step are finalized, `send_streamed_outputs` delivers
+   * them.
+   */
+  template <typename T>
+  auto get_streamed_output(Batch& batch,
+                           std::string const& name,
+                           std::optional<MemoryType> const& mem_type,
+                           cudaStream_t stream) const
+  {
+    return batch.get_response_sender().get_output<T>(name, mem_type, device_id_, stream);
+  }
+  template <typename T>
+  auto get_streamed_output(Batch& batch, std::string const& name) const
+  {
+    return get_streamed_output<T>(batch, name, preferred_mem_type(batch), batch.stream());
+  }
+  template <typename T>
+  auto get_streamed_output(Batch& batch,
+                           std::string const& name,
+                           std::vector<std::size_t> shape,
+                           std::vector<std::size_t> request_rows,
+                           std::optional<MemoryType> const& mem_type,
+                           cudaStream_t stream) const
+  {
+    return batch.get_response_sender().get_output<T>(
+      name, std::move(shape), std::move(request_rows), mem_type, device_id_, stream);
+  }
+  template <typename T>
+  auto get_streamed_output(Batch& batch,
+                           std::string const& name,
+                           std::vector<std::size_t> shape,
+                           std::vector<std::size_t> request_rows) const
+  {
+    return get_streamed_output<T>(batch,
+                                  name,
+                                  std::move(shape),
+                                  std::move(request_rows),
+                                  preferred_mem_type(batch),
+                                  batch.stream());
+  }
+
+  /**
+   * @brief Send a partial response to each request of a batch containing
+   * the streamed outputs finalized since the last call
+   */
+  void send_streamed_outputs(Batch& batch) const { batch.get_response_sender().send(); }
+
+  /**
+   * @brief Get a tensor backed directly by the response buffers of a
+   * particular named output for an entire batch
+   */
+  template <typename T>
+  auto get_direct_output(Batch& batch,
+                         std::string const& name,
+                         std::optional<MemoryType> const& mem_type,
+                         device_id_t device_id,
+                         cudaStream_t stream) const
+  {
+    return batch.get_direct_output<T>(name, mem_type, device_id, stream);
+  }
+  template <typename T>
+  auto get_direct_output(Batch& batch,
+                         std::string const& name,
+                         std::optional<MemoryType> const& mem_type) const
+  {
+    return get_direct_output<T>(batch, name, mem_type, device_id_, batch.stream());
+  }
+  template <typename T>
+  auto get_direct_output(Batch& batch, std::string const& name) const
+  {
+    return get_direct_output<T>(
+      batch, name, preferred_mem_type(batch), device_id_, batch.stream());
+  }
+
+  /**
+   * @brief Get an output tensor which forwards an input tensor, possibly
+   * reshaped, without copying it
+   */
+  template <typename U>
+  auto get_output_alias(Batch& batch,
+                        std::string const& name,
+                        BaseTensor<U> const& input,
+                        std::vector<std::size_t> shape) const
+  {
+    return batch.get_output_alias(name, input, std::move(shape));
+  }
+  template <typename U>
+  auto get_output_alias(Batch& batch, std::string const& name, BaseTensor<U> const& input) const
+  {
+    return batch.get_output_alias(name, input);
   }
 
   /**
@@ -168,7 +408,11 @@ struct Model {
       device_id_{device_id},
       default_stream_{default_stream},
       deployment_type_{deployment_type},
-      filepath_{filepath}
+      filepath_{filepath},
+      stream_pool_{[this]() {
+        auto pool_size = get_config_param<std::size_t>("stream_pool_size", std::size_t{});
+        return pool_size == 0 ? nullptr : std::make_shared<StreamPool>(pool_size, device_id_);
+      }()}
   {
     if constexpr (IS_GPU_BUILD) { setup_memory_resource(device_id_); }
   }
@@ -182,6 +426,8 @@ struct Model {
     return shared_state_->get_output_shape(name);
   }
 
+  auto is_decoupled() const { return shared_state_->is_decoupled(); }
+
  protected:
   auto get_shared_state() const { return shared_state_; }
 
@@ -191,6 +437,7 @@ struct Model {
   cudaStream_t default_stream_;
   DeploymentType deployment_type_;
   std::string filepath_;
+  std::shared_ptr<StreamPool> stream_pool_;
 };
 }  // namespace backend
 }  // namespace developer_tools
@@ -49,6 +49,7 @@ struct SharedModelState {
                             bool squeeze_output = false)
     : config_{std::move(config)},
       max_batch_size_{get_max_batch_size(*config_)},
+      decoupled_{get_decoupled(*config_)},
       output_shapes_([this, squeeze_output]() {
         auto result         = std::vector<std::pair<std::string, std::vector<std::int64_t>>>{};
         auto output_entries = triton::common::TritonJson::Value{};
@@ -104,6 +105,12 @@ struct SharedModelState {
     return get_config_param<T>(name, std::make_optional(default_value));
   }
 
+  /**
+   * @brief Whether the model may send several responses per request, as set
+   * by `model_transaction_policy` in the config
+   */
+  auto is_decoupled() const { return decoupled_; }
+
   auto get_output_shape(std::string const& name) const
   {
     auto cached_shape = std::lower_bound(
@@ -140,6 +147,7 @@ struct SharedModelState {
  private:
   std::unique_ptr<common::TritonJson::Value> config_;
   Batch::size_type max_batch_size_;
+  bool decoupled_;
   std::vector<std::pair<std::string, std::vector<std::int64_t>>> mutable output_shapes_;
 
   template <typename T>
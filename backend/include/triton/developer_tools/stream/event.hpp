@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#ifdef TRITON_ENABLE_GPU
+#include <cuda_runtime_api.h>
+#else
+#include <triton/developer_tools/cpu_only/cuda_runtime_replacement.hpp>
+#endif
+
+#include <triton/developer_tools/build_control.hpp>
+#include <triton/developer_tools/exceptions.hpp>
+#include <triton/developer_tools/stream/stream.hpp>
+
+namespace triton {
+namespace developer_tools {
+namespace backend {
+/**
+ * @brief A point in a stream's work which other streams or the host can wait
+ * on without synchronizing the whole stream
+ *
+ * This mirrors a CUDA event: `wait` orders work submitted afterwards to the
+ * waiting stream after the work captured by the most recent `record`. In GPU
+ * builds it wraps a cudaEvent_t; in non-GPU builds it orders OrderedQueue
+ * streams with host-side signalling, so pipelining logic behaves the same way
+ * in both.
+ */
+struct Event {
+  Event() : event_{}, state_{}
+  {
+    if constexpr (IS_GPU_BUILD) {
+      cuda_check(cudaEventCreateWithFlags(&event_, cudaEventDisableTiming));
+    } else {
+      state_ = std::make_shared<host_state>();
+    }
+  }
+
+  Event(Event const&) = delete;
+  Event& operator=(Event const&) = delete;
+  Event(Event&& other) noexcept
+    : event_{std::exchange(other.event_, cudaEvent_t{})}, state_{std::move(other.state_)}
+  {
+  }
+  Event& operator=(Event&& other) noexcept
+  {
+    std::swap(event_, other.event_);
+    std::swap(state_, other.state_);
+    return *this;
+  }
+
+  ~Event()
+  {
+    if constexpr (IS_GPU_BUILD) {
+      if (event_ != cudaEvent_t{}) { cudaEventDestroy(event_); }
+    }
+  }
+
+  /**
+   * @brief Capture all work submitted to the given stream so far
+   */
+  void record(cudaStream_t stream)
+  {
+    if constexpr (IS_GPU_BUILD) {
+      cuda_check(cudaEventRecord(event_, stream));
+    } else {
+      auto target = std::uint64_t{};
+      {
+        auto lock = std::lock_guard<std::mutex>{state_->mtx};
+        target    = ++state_->recorded;
+      }
+      enqueue(stream, [state = state_, target]() { state->complete(target); });
+    }
+  }
+
+  /**
+   * @brief Make all work submitted to the given stream from now on wait for
+   * the most recently recorded work to complete
+   */
+  void wait(cudaStream_t stream) const
+  {
+    if constexpr (IS_GPU_BUILD) {
+      cuda_check(cudaStreamWaitEvent(stream, event_, 0));
+    } else {
+      enqueue(stream,
+              [state = state_, target = state_->last_recorded()]() { state->wait(target); });
+    }
+  }
+
+  /**
+   * @brief Block the calling thread until the most recently recorded work
+   * has completed
+   */
+  void synchronize() const
+  {
+    if constexpr (IS_GPU_BUILD) {
+      cuda_check(cudaEventSynchronize(event_));
+    } else {
+      state_->wait(state_->last_recorded());
+    }
+  }
+
+ private:
+  struct host_state {
+    std::mutex mtx{};
+    std::condition_variable cv{};
+    std::uint64_t recorded{};
+    std::uint64_t completed{};
+
+    std::uint64_t last_recorded()
+    {
+      auto lock = std::lock_guard<std::mutex>{mtx};
+      return recorded;
+    }
+
+    void complete(std::uint64_t target)
+    {
+      {
+        auto lock = std::lock_guard<std::mutex>{mtx};
+        if (target > completed) { completed = target; }
+      }
+      cv.notify_all();
+    }
+
+    void wait(std::uint64_t target)
+    {
+      auto lock = std::unique_lock<std::mutex>{mtx};
+      cv.wait(lock, [this, target]() { return completed >= target; });
+    }
+  };
+
+  cudaEvent_t event_;
+  std::shared_ptr<host_state> state_;
+};
+
+}  // namespace backend
+}  // namespace developer_tools
+}  // namespace triton
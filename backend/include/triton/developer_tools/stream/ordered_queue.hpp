@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace triton {
+namespace developer_tools {
+namespace backend {
+/**
+ * @brief A queue of host tasks executed one at a time, in submission order,
+ * on a dedicated worker thread
+ *
+ * In non-GPU builds, OrderedQueues stand in for CUDA streams: work submitted
+ * to the same queue is serialized, work submitted to different queues may
+ * overlap, and `synchronize` blocks until everything submitted so far has
+ * run. If a task throws, the first exception is rethrown by the next call to
+ * `synchronize`.
+ */
+struct OrderedQueue {
+  OrderedQueue()
+    : mtx_{},
+      task_ready_{},
+      task_done_{},
+      tasks_{},
+      submitted_{},
+      completed_{},
+      error_{},
+      stopping_{false},
+      worker_{[this]() { run(); }}
+  {
+  }
+
+  OrderedQueue(OrderedQueue const&) = delete;
+  OrderedQueue& operator=(OrderedQueue const&) = delete;
+
+  ~OrderedQueue()
+  {
+    {
+      auto lock = std::lock_guard<std::mutex>{mtx_};
+      stopping_ = true;
+    }
+    task_ready_.notify_one();
+    worker_.join();
+  }
+
+  void enqueue(std::function<void()> task)
+  {
+    {
+      auto lock = std::lock_guard<std::mutex>{mtx_};
+      tasks_.push_back(std::move(task));
+      ++submitted_;
+    }
+    task_ready_.notify_one();
+  }
+
+  void synchronize()
+  {
+    auto lock   = std::unique_lock<std::mutex>{mtx_};
+    auto target = submitted_;
+    task_done_.wait(lock, [this, target]() { return completed_ >= target; });
+    if (error_) { std::rethrow_exception(std::exchange(error_, nullptr)); }
+  }
+
+ private:
+  std::mutex mtx_;
+  std::condition_variable task_ready_;
+  std::condition_variable task_done_;
+  std::deque<std::function<void()>> tasks_;
+  std::uint64_t submitted_;
+  std::uint64_t completed_;
+  std::exception_ptr error_;
+  bool stopping_;
+  // Declared last so that every other member is initialized before the
+  // worker starts
+  std::thread worker_;
+
+  void run()
+  {
+    auto lock = std::unique_lock<std::mutex>{mtx_};
+    while (true) {
+      task_ready_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+      // Drain remaining work before stopping so that nothing waiting on this
+      // queue is left blocked
+      if (tasks_.empty()) { break; }
+      auto task = std::move(tasks_.front());
+      tasks_.pop_front();
+      lock.unlock();
+      try {
+        task();
+      } catch (...) {
+        lock.lock();
+        if (!error_) { error_ = std::current_exception(); }
+        lock.unlock();
+      }
+      lock.lock();
+      ++completed_;
+      task_done_.notify_all();
+    }
+  }
+};
+
+}  // namespace backend
+}  // namespace developer_tools
+}  // namespace triton
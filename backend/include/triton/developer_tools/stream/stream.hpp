@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <functional>
+#include <memory>
+#include <utility>
+
+#ifdef TRITON_ENABLE_GPU
+#include <cuda_runtime_api.h>
+#else
+#include <triton/developer_tools/cpu_only/cuda_runtime_replacement.hpp>
+#endif
+
+#include <triton/developer_tools/build_control.hpp>
+#include <triton/developer_tools/exceptions.hpp>
+#include <triton/developer_tools/stream/ordered_queue.hpp>
+
+namespace triton {
+namespace developer_tools {
+namespace backend {
+/**
+ * @brief Return the handle by which an OrderedQueue is passed wherever a
+ * stream is expected in non-GPU builds
+ *
+ * In non-GPU builds, a null stream denotes the calling thread itself: work
+ * "enqueued" on it runs immediately. Any other stream must be a handle
+ * obtained from this function.
+ */
+inline auto as_stream(OrderedQueue& queue) { return reinterpret_cast<cudaStream_t>(&queue); }
+
+namespace detail {
+inline auto* get_ordered_queue(cudaStream_t stream)
+{
+  return reinterpret_cast<OrderedQueue*>(stream);
+}
+}  // namespace detail
+
+/**
+ * @brief Run a host task after all work previously submitted to a stream
+ *
+ * In GPU builds, the task is launched with `cudaLaunchHostFunc` and so must
+ * not make any CUDA calls; since exceptions cannot propagate through the
+ * CUDA runtime, any exception it throws is discarded.
+ */
+inline void enqueue(cudaStream_t stream, std::function<void()> task)
+{
+  if constexpr (IS_GPU_BUILD) {
+    auto heap_task = std::make_unique<std::function<void()>>(std::move(task));
+    cuda_check(cudaLaunchHostFunc(
+      stream,
+      [](void* data) {
+        auto owned_task =
+          std::unique_ptr<std::function<void()>>(static_cast<std::function<void()>*>(data));
+        try {
+          (*owned_task)();
+        } catch (...) {
+        }
+      },
+      heap_task.get()));
+    heap_task.release();
+  } else {
+    if (stream == cudaStream_t{}) {
+      task();
+    } else {
+      detail::get_ordered_queue(stream)->enqueue(std::move(task));
+    }
+  }
+}
+
+/**
+ * @brief Block until all work previously submitted to a stream has completed
+ */
+inline void stream_synchronize(cudaStream_t stream)
+{
+  if constexpr (IS_GPU_BUILD) {
+    cuda_check(cudaStreamSynchronize(stream));
+  } else {
+    if (stream != cudaStream_t{}) { detail::get_ordered_queue(stream)->synchronize(); }
+  }
+}
+
+}  // namespace backend
+}  // namespace developer_tools
+}  // namespace triton
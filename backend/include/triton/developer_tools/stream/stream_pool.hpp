@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#ifdef TRITON_ENABLE_GPU
+#include <cuda_runtime_api.h>
+#else
+#include <triton/developer_tools/cpu_only/cuda_runtime_replacement.hpp>
+#endif
+
+#include <triton/developer_tools/build_control.hpp>
+#include <triton/developer_tools/exceptions.hpp>
+#include <triton/developer_tools/stream/ordered_queue.hpp>
+#include <triton/developer_tools/stream/stream.hpp>
+#include <triton/developer_tools/triton/device.hpp>
+
+namespace triton {
+namespace developer_tools {
+namespace backend {
+/**
+ * @brief A fixed set of streams handed out in round-robin order
+ *
+ * In GPU builds, the pool owns non-blocking CUDA streams created on the given
+ * device; in non-GPU builds, it owns OrderedQueues. Successive batches set up
+ * on different streams of a pool can overlap their input transfers, compute
+ * and output transfers, with ordering between streams expressed through
+ * Events rather than host synchronization.
+ */
+struct StreamPool {
+  using size_type = std::size_t;
+
+  StreamPool(size_type size, device_id_t device = 0) : queues_{}, streams_{}, next_{0}
+  {
+    if (size == 0) { throw TritonException(Error::InvalidArg, "stream pool must not be empty"); }
+    streams_.reserve(size);
+    if constexpr (IS_GPU_BUILD) {
+      auto prev_device = int{};
+      cuda_check(cudaGetDevice(&prev_device));
+      cuda_check(cudaSetDevice(device));
+      try {
+        for (auto i = size_type{}; i < size; ++i) {
+          auto stream = cudaStream_t{};
+          cuda_check(cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking));
+          streams_.push_back(stream);
+        }
+      } catch (...) {
+        destroy_streams();
+        cudaSetDevice(prev_device);
+        throw;
+      }
+      cuda_check(cudaSetDevice(prev_device));
+    } else {
+      queues_.reserve(size);
+      for (auto i = size_type{}; i < size; ++i) {
+        queues_.push_back(std::make_unique<OrderedQueue>());
+        streams_.push_back(as_stream(*queues_.back()));
+      }
+    }
+  }
+
+  StreamPool(StreamPool const&) = delete;
+  StreamPool& operator=(StreamPool const&) = delete;
+
+  ~StreamPool() { destroy_streams(); }
+
+  auto size() const { return streams_.size(); }
+
+  /**
+   * @brief Return the next stream in round-robin order
+   *
+   * This may be called concurrently from several threads.
+   */
+  auto get() { return streams_[next_.fetch_add(1, std::memory_order_relaxed) % streams_.size()]; }
+
+  auto operator[](size_type index) const { return streams_[index]; }
+
+  /**
+   * @brief Block until all work submitted to every stream of the pool has
+   * completed
+   */
+  void synchronize() const
+  {
+    for (auto stream : streams_) {
+      stream_synchronize(stream);
+    }
+  }
+
+ private:
+  std::vector<std::unique_ptr<OrderedQueue>> queues_;
+  std::vector<cudaStream_t> streams_;
+  std::atomic<size_type> next_;
+
+  void destroy_streams() noexcept
+  {
+    if constexpr (IS_GPU_BUILD) {
+      for (auto stream : streams_) {
+        cudaStreamSynchronize(stream);
+        cudaStreamDestroy(stream);
+      }
+    }
+    streams_.clear();
+  }
+};
+
+}  // namespace backend
+}  // namespace developer_tools
+}  // namespace triton
@@ -16,6 +16,7 @@
 
 #pragma once
 #include <algorithm>
+#include <cstdint>
 #include <iterator>
 #include <memory>
 #include <numeric>
@@ -34,6 +35,8 @@
 #include <triton/developer_tools/build_control.hpp>
 #include <triton/developer_tools/exceptions.hpp>
 #include <triton/developer_tools/memory/buffer.hpp>
+#include <triton/developer_tools/stream/event.hpp>
+#include <triton/developer_tools/stream/stream.hpp>
 #include <triton/developer_tools/tensor/dtype.hpp>
 #include <triton/developer_tools/triton/device.hpp>
 #include <triton/developer_tools/utils/narrow.hpp>
@@ -128,13 +131,77 @@ struct Tensor final : BaseTensor<T> {
   }
 };
 
+/**
+ * @brief An input whose shape differs between the requests of a batch,
+ * stored without padding
+ *
+ * As in Triton's ragged batching, the elements of every request are
+ * concatenated in request order in `values`, and `offsets` holds the index
+ * in `values` of each request's first element followed by the total number
+ * of elements. The full shape of each request's input is given by `shapes`.
+ */
+template <typename T>
+struct RaggedTensor {
+  using size_type = typename BaseTensor<T>::size_type;
+
+  RaggedTensor(Buffer<T>&& values,
+               Buffer<std::int64_t>&& offsets,
+               std::vector<std::vector<size_type>>&& shapes)
+    : values_{{values.size()}, std::move(values)},
+      offsets_{{offsets.size()}, std::move(offsets)},
+      shapes_{std::move(shapes)}
+  {
+  }
+
+  auto& values() { return values_; }
+  auto const& values() const { return values_; }
+  auto& offsets() { return offsets_; }
+  auto const& offsets() const { return offsets_; }
+  auto const& shapes() const { return shapes_; }
+  auto request_count() const { return shapes_.size(); }
+
+ private:
+  Tensor<T> values_;
+  Tensor<std::int64_t> offsets_;
+  std::vector<std::vector<size_type>> shapes_;
+};
+
 template <typename T>
 struct OutputTensor final : BaseTensor<T> {
   OutputTensor(std::vector<typename BaseTensor<T>::size_type>&& shape,
                Buffer<T>&& buffer,
                std::string const& name,
-               std::shared_ptr<triton::backend::BackendOutputResponder> responder)
-    : BaseTensor<T>(std::move(shape), std::move(buffer)), name_{name}, responder_{responder}
+               std::shared_ptr<triton::backend::BackendOutputResponder> responder,
+               cudaStream_t responder_stream = cudaStream_t{})
+    : BaseTensor<T>(std::move(shape), std::move(buffer)),
+      name_{name},
+      responder_{responder},
+      responder_stream_{responder_stream},
+      responses_{nullptr},
+      request_rows_{}
+  {
+  }
+
+  /**
+   * @brief Construct an output whose rows are divided between the requests
+   * of a batch by `request_rows` rather than by each request's batch size
+   *
+   * The ith response receives the next `request_rows[i]` rows of the tensor
+   * along its first dimension, with all other dimensions taken from `shape`.
+   * This allows outputs whose size depends on the data, such as those with
+   * variable dimensions in the model config.
+   */
+  OutputTensor(std::vector<typename BaseTensor<T>::size_type>&& shape,
+               Buffer<T>&& buffer,
+               std::string const& name,
+               std::vector<TRITONBACKEND_Response*>* responses,
+               std::vector<typename BaseTensor<T>::size_type>&& request_rows)
+    : BaseTensor<T>(std::move(shape), std::move(buffer)),
+      name_{name},
+      responder_{},
+      responder_stream_{},
+      responses_{responses},
+      request_rows_{std::move(request_rows)}
   {
   }
   /**
@@ -150,6 +217,10 @@ struct OutputTensor final : BaseTensor<T> {
    */
   void finalize()
   {
+    if (responses_ != nullptr) {
+      send_request_rows();
+      return;
+    }
     auto& shape       = BaseTensor<T>::shape();
     auto triton_shape = std::vector<std::int64_t>{};
     triton_shape.reserve(shape.size());
@@ -158,21 +229,207 @@ struct OutputTensor final : BaseTensor<T> {
         return narrow<int64_t>(val);
       });
 
-    // Must call the following because BackendOutputResponder does not expose
-    // its stream, so we cannot be certain that our data is not being
-    // processed on another stream.
-    BaseTensor<T>::stream_synchronize();
+    // The responder copies device data asynchronously on its own stream, so
+    // device data on that stream is already ordered after the work writing
+    // it. For device data on another stream, rather than blocking the host we
+    // order the responder's stream after the work on this tensor's stream,
+    // and order any later work on this tensor's stream (such as the release
+    // of its memory) after the responder's copies. Host or pinned data may be
+    // read by the responder immediately, while asynchronous copies or kernels
+    // writing it may still be queued on this tensor's stream, so only then
+    // must that stream finish first.
+    auto tensor_stream = BaseTensor<T>::stream();
+    auto on_device     = IS_GPU_BUILD && BaseTensor<T>::mem_type() == DeviceMemory;
+    auto cross_stream  = on_device && tensor_stream != responder_stream_;
+    if (cross_stream) {
+      auto data_ready = Event{};
+      data_ready.record(tensor_stream);
+      data_ready.wait(responder_stream_);
+    } else if (!on_device) {
+      backend::stream_synchronize(tensor_stream);
+    }
     responder_->ProcessTensor(name_.c_str(),
                               TritonDtype<T>::value,
                               triton_shape,
                               reinterpret_cast<char*>(BaseTensor<T>::data()),
                               BaseTensor<T>::mem_type(),
                               BaseTensor<T>::device());
+    if (cross_stream) {
+      auto copies_done = Event{};
+      copies_done.record(responder_stream_);
+      copies_done.wait(tensor_stream);
+    }
   }
 
  private:
+  /* Copy each request's rows into an output buffer allocated for its
+   * response. The BackendOutputResponder cannot be used here, since it
+   * assumes that each request's share of an output matches its share of the
+   * inputs. */
+  void send_request_rows()
+  {
+    auto& shape = BaseTensor<T>::shape();
+    if (shape.empty() || request_rows_.size() != responses_->size() ||
+        std::reduce(request_rows_.begin(), request_rows_.end(), std::size_t{}) != shape[0]) {
+      throw TritonException(Error::InvalidArg,
+                            "rows of output " + name_ + " cannot be divided between requests");
+    }
+    auto row_size =
+      std::reduce(std::next(shape.begin()), shape.end(), std::size_t{1}, std::multiplies<>());
+
+    auto request_shape = std::vector<std::int64_t>{};
+    request_shape.reserve(shape.size());
+    std::transform(
+      std::begin(shape), std::end(shape), std::back_inserter(request_shape), [](auto& val) {
+        return narrow<int64_t>(val);
+      });
+
+    auto tensor_stream = BaseTensor<T>::stream();
+    if constexpr (!IS_GPU_BUILD) { backend::stream_synchronize(tensor_stream); }
+
+    auto& source     = BaseTensor<T>::buffer();
+    auto row_offset  = std::size_t{};
+    auto device_copy = false;
+    for (auto i = std::size_t{}; i < responses_->size(); ++i) {
+      auto rows      = request_rows_[i];
+      auto* response = (*responses_)[i];
+      auto* output   = static_cast<TRITONBACKEND_Output*>(nullptr);
+      if (response != nullptr) {
+        request_shape[0] = narrow<int64_t>(rows);
+        triton_check(TRITONBACKEND_ResponseOutput(response,
+                                                  &output,
+                                                  name_.c_str(),
+                                                  TritonDtype<T>::value,
+                                                  request_shape.data(),
+                                                  request_shape.size()));
+      }
+      if (output != nullptr && rows != 0) {
+        auto region_size          = rows * row_size;
+        auto* raw_buffer          = static_cast<void*>(nullptr);
+        auto actual_memory_type   = source.mem_type();
+        auto actual_memory_device = int64_t{source.device()};
+        triton_check(TRITONBACKEND_OutputBuffer(output,
+                                                &raw_buffer,
+                                                region_size * sizeof(T),
+                                                &actual_memory_type,
+                                                &actual_memory_device));
+        if (actual_memory_type == TRITONSERVER_MEMORY_CPU_PINNED) {
+          actual_memory_type = HostMemory;
+        }
+        auto region = Buffer<T>(static_cast<T*>(raw_buffer),
+                                region_size,
+                                actual_memory_type,
+                                narrow<device_id_t>(actual_memory_device),
+                                tensor_stream);
+        copy(region, source, row_offset * row_size, (row_offset + rows) * row_size);
+        device_copy = device_copy || actual_memory_type == DeviceMemory ||
+                      source.mem_type() == DeviceMemory;
+      }
+      row_offset += rows;
+    }
+    // Responses are sent as soon as the batch is finalized, so copies made
+    // asynchronously on the tensor's stream must complete first
+    if (device_copy) { backend::stream_synchronize(tensor_stream); }
+  }
+
   std::string name_;
   std::shared_ptr<triton::backend::BackendOutputResponder> responder_;
+  cudaStream_t responder_stream_;
+  std::vector<TRITONBACKEND_Response*>* responses_;
+  std::vector<typename BaseTensor<T>::size_type> request_rows_;
+};
+
+/**
+ * @brief An output tensor whose storage is the response buffers Triton has
+ * allocated for each request in a batch
+ *
+ * Rather than owning a single buffer for the whole batch, a
+ * DirectOutputTensor is a scatter view over one region per request, stored
+ * in request order along the batch dimension. Data written to these regions
+ * is sent with the responses as-is, so no copy is made by the
+ * BackendOutputResponder. When the batch consists of a single request, the
+ * tensor is contiguous and may be used exactly like a single buffer.
+ */
+template <typename T>
+struct DirectOutputTensor {
+  using size_type = typename Buffer<T>::size_type;
+
+  DirectOutputTensor(std::vector<size_type>&& shape,
+                     std::vector<Buffer<T>>&& regions,
+                     std::vector<size_type>&& row_offsets)
+    : shape_{std::move(shape)}, regions_{std::move(regions)}, row_offsets_{std::move(row_offsets)}
+  {
+  }
+
+  auto const& shape() const { return shape_; }
+  auto size() const
+  {
+    return std::transform_reduce(std::begin(regions_),
+                                 std::end(regions_),
+                                 size_type{},
+                                 std::plus<>{},
+                                 [](auto& region) { return region.size(); });
+  }
+  auto constexpr dtype() { return TritonDtype<T>::value; }
+
+  /**
+   * @brief The per-request regions of this tensor in request order
+   */
+  auto& regions() { return regions_; }
+  auto const& regions() const { return regions_; }
+  /**
+   * @brief The index along the batch dimension of the first row of each
+   * region
+   */
+  auto const& row_offsets() const { return row_offsets_; }
+
+  auto is_contiguous() const { return regions_.size() == 1; }
+
+  /**
+   * @brief The single buffer backing a contiguous tensor
+   */
+  auto& buffer()
+  {
+    if (!is_contiguous()) {
+      throw TritonException(Error::Internal,
+                            "direct output spanning several requests has no single buffer");
+    }
+    return regions_.front();
+  }
+  auto* data() { return buffer().data(); }
+
+  /**
+   * @brief Wait for all work queued on the streams of this tensor's regions
+   *
+   * Every region is considered regardless of its memory type, since copies
+   * from device memory into host response buffers are also asynchronous.
+   * Each distinct stream is synchronized once.
+   */
+  void stream_synchronize() const
+  {
+    auto synchronized = std::vector<cudaStream_t>{};
+    std::for_each(std::begin(regions_), std::end(regions_), [&synchronized](auto& region) {
+      auto stream = region.stream();
+      if (std::find(synchronized.begin(), synchronized.end(), stream) == synchronized.end()) {
+        backend::stream_synchronize(stream);
+        synchronized.push_back(stream);
+      }
+    });
+  }
+
+  /**
+   * @brief Ensure all data written to this tensor has landed in the response
+   * buffers
+   *
+   * Like `OutputTensor::finalize`, this *must* be called on all direct
+   * outputs before returning from `predict`.
+   */
+  void finalize() { stream_synchronize(); }
+
+ private:
+  std::vector<size_type> shape_;
+  std::vector<Buffer<T>> regions_;
+  std::vector<size_type> row_offsets_;
 };
 
 template <typename T,
@@ -200,6 +457,26 @@ void copy(Iter begin, Iter end, BaseTensor<T>& src)
   });
 }
 
+/**
+ * @brief Scatter data from a src Tensor covering the entire batch into the
+ * per-request regions of a DirectOutputTensor
+ */
+template <typename T,
+          typename U,
+          typename = std::enable_if_t<std::is_same_v<std::remove_const_t<U>, T>>>
+void copy(DirectOutputTensor<T>& dst, BaseTensor<U>& src)
+{
+  auto& regions = dst.regions();
+  std::accumulate(std::begin(regions),
+                  std::end(regions),
+                  typename BaseTensor<T>::size_type{},
+                  [&src](auto offset, auto& region) {
+                    auto end_offset = offset + region.size();
+                    copy(region, src.buffer(), offset, end_offset);
+                    return end_offset;
+                  });
+}
+
 }  // namespace backend
 }  // namespace developer_tools
 }  // namespace triton
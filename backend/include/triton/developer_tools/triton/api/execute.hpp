@@ -20,8 +20,11 @@
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <exception>
+#include <memory>
 #include <triton/developer_tools/batch/batch.hpp>
 #include <triton/developer_tools/exceptions.hpp>
+#include <triton/developer_tools/triton/logging.hpp>
 #include <triton/developer_tools/triton/model.hpp>
 #include <triton/developer_tools/triton/model_instance.hpp>
 #include <triton/developer_tools/triton/statistics.hpp>
@@ -47,11 +50,12 @@ auto* execute(TRITONBACKEND_ModelInstance* instance,
     auto& model          = instance_state->get_model();
     auto max_batch_size  = model.template get_config_param<std::size_t>("max_batch_size");
 
-    /* Note: It is safe to keep a reference to the model in this closure
-     * and a pointer to the instance in the next because the batch goes
-     * out of scope at the end of this block and Triton guarantees that
-     * the liftimes of both the instance and model extend beyond this
-     * function call. */
+    /* Note: It is safe to keep a reference to the model in the shape
+     * fetchers and a pointer to the instance in the statistics reporter
+     * because the batch is finalized either before this function returns
+     * or, for batches in flight, before the instance is unloaded, and Triton
+     * guarantees that the lifetimes of both the instance and model extend
+     * until then. */
     auto output_shape_fetcher = [&model](std::string const& name, Batch::size_type batch_dim) {
       auto result       = std::vector<Batch::size_type>{};
       auto config_shape = model.get_output_shape(name);
@@ -60,17 +64,21 @@ auto* execute(TRITONBACKEND_ModelInstance* instance,
         std::begin(config_shape),
         std::end(config_shape),
         std::back_inserter(result),
-        [](auto& coord) {
+        [&name](auto& coord) {
           if (coord < 0) {
-            throw TritonException(
-              Error::Internal,
-              "Backends with variable-shape outputs must request desired output shape");
+            throw TritonException(Error::Internal,
+                                  "Backends with variable-shape outputs must request desired "
+                                  "output shape; pass the shape and rows per request of " +
+                                    name + " to get_output");
           } else {
             return narrow<std::size_t>(coord);
           }
         });
       return result;
     };
+    auto config_shape_fetcher = [&model](std::string const& name) {
+      return model.get_output_shape(name);
+    };
     auto statistics_reporter = [instance](TRITONBACKEND_Request* request,
                                           time_point req_start,
                                           time_point req_comp_start,
@@ -79,36 +87,82 @@ auto* execute(TRITONBACKEND_ModelInstance* instance,
       report_statistics(*instance, *request, req_start, req_comp_start, req_comp_end, req_end);
     };
 
-    auto batch = Batch(raw_requests,
-                       request_count,
-                       *(model_state->TritonMemoryManager()),
-                       std::move(output_shape_fetcher),
-                       std::move(statistics_reporter),
-                       model_state->EnablePinnedInput(),
-                       model_state->EnablePinnedOutput(),
-                       max_batch_size,
-                       model.get_stream());
+    auto batch = std::make_shared<Batch>(raw_requests,
+                                         request_count,
+                                         *(model_state->TritonMemoryManager()),
+                                         std::move(output_shape_fetcher),
+                                         std::move(statistics_reporter),
+                                         model_state->EnablePinnedInput(),
+                                         model_state->EnablePinnedOutput(),
+                                         max_batch_size,
+                                         model.get_stream(),
+                                         instance_state->get_output_pool(),
+                                         model.is_decoupled(),
+                                         std::move(config_shape_fetcher));
 
+    auto device_id       = model.get_device_id();
+    auto deployment_type = model.get_deployment_type();
     if constexpr (IS_GPU_BUILD) {
-      if (model.get_deployment_type() == GPUDeployment) {
-        cuda_check(cudaSetDevice(model.get_device_id()));
-      }
+      if (deployment_type == GPUDeployment) { cuda_check(cudaSetDevice(device_id)); }
     }
 
-    auto predict_err = static_cast<TRITONSERVER_Error*>(nullptr);
-    try {
-      model.predict(batch);
-    } catch (TritonException& err) {
-      predict_err = err.error();
-    }
+    auto* inflight = instance_state->get_inflight_batches();
+    if (inflight == nullptr) {
+      auto predict_err = static_cast<TRITONSERVER_Error*>(nullptr);
+      try {
+        model.predict(*batch);
+      } catch (TritonException& err) {
+        predict_err = err.error();
+      }
+
+      auto& compute_start_time = batch->compute_start_time();
+      auto compute_end_time    = std::chrono::steady_clock::now();
+      batch->finalize(predict_err);
+      auto end_time = std::chrono::steady_clock::now();
 
-    auto& compute_start_time = batch.compute_start_time();
-    auto compute_end_time    = std::chrono::steady_clock::now();
-    batch.finalize(predict_err);
-    auto end_time = std::chrono::steady_clock::now();
+      report_statistics(
+        *instance, request_count, start_time, compute_start_time, compute_end_time, end_time);
+    } else {
+      /* Once predict has been started, the backend owns the requests: they
+       * are released (with error responses if necessary) when the batch
+       * completes, after this function has returned to Triton. The instance
+       * waits for all batches in flight before it is unloaded, so it is safe
+       * to keep a pointer to it here. */
+      inflight->submit(
+        model.predict_async(*batch),
+        [batch, instance, request_count, start_time, device_id, deployment_type](
+          std::exception_ptr error) {
+          auto predict_err = static_cast<TRITONSERVER_Error*>(nullptr);
+          try {
+            if (error) { std::rethrow_exception(error); }
+          } catch (TritonException& err) {
+            predict_err = err.error();
+          } catch (std::exception& err) {
+            predict_err = TritonException(Error::Internal, err.what()).error();
+          } catch (...) {
+            predict_err = TritonException().error();
+          }
+
+          try {
+            if constexpr (IS_GPU_BUILD) {
+              if (deployment_type == GPUDeployment) { cuda_check(cudaSetDevice(device_id)); }
+            }
+            auto compute_end_time = std::chrono::steady_clock::now();
+            batch->finalize(predict_err, true);
+            auto end_time = std::chrono::steady_clock::now();
 
-    report_statistics(
-      *instance, request_count, start_time, compute_start_time, compute_end_time, end_time);
+            report_statistics(*instance,
+                              request_count,
+                              start_time,
+                              batch->compute_start_time(),
+                              compute_end_time,
+                              end_time);
+          } catch (std::exception& err) {
+            log_error(__FILE__, __LINE__, err.what());
+          }
+          if (predict_err != nullptr) { TRITONSERVER_ErrorDelete(predict_err); }
+        });
+    }
   } catch (TritonException& err) {
     result = err.error();
   }
@@ -28,6 +28,10 @@
 #include <triton/developer_tools/triton/backend.hpp>
 #include <triton/developer_tools/triton/device.hpp>
 #include <triton/developer_tools/triton/logging.hpp>
+#include <triton/developer_tools/utils/narrow.hpp>
+#include <triton/developer_tools/utils/thread_pool.hpp>
+#include <cstddef>
+#include <stdexcept>
 #include <string>
 
 namespace triton {
@@ -46,6 +50,22 @@ inline auto* initialize(TRITONBACKEND_Backend* backend)
       throw TritonException{Error::Unsupported,
                             "triton backend API version does not support this backend"};
     }
+
+    // The backend-wide thread pool defaults to one thread per hardware
+    // thread and is only started once a model first uses it
+    auto thread_pool_size = get_backend_config_param(*backend, "thread-pool-size");
+    if (thread_pool_size.has_value()) {
+      auto thread_count = std::size_t{};
+      try {
+        thread_count = narrow<std::size_t>(std::stoll(thread_pool_size.value()));
+      } catch (std::logic_error const&) {
+        throw TritonException(Error::InvalidArg,
+                              "thread-pool-size must be a non-negative integer, got " +
+                                thread_pool_size.value());
+      }
+      log_info(__FILE__, __LINE__) << "Backend thread pool size: " << thread_count;
+      setup_thread_pool(thread_count);
+    }
     if constexpr (IS_GPU_BUILD) {
       auto device_count = int{};
       auto cuda_err     = cudaGetDeviceCount(&device_count);
@@ -16,11 +16,15 @@
 
 #pragma once
 
+#include <triton/backend/backend_common.h>
 #include <triton/core/tritonbackend.h>
+#include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <triton/developer_tools/exceptions.hpp>
 #include <triton/developer_tools/triton/logging.hpp>
 #include <string>
+#include <utility>
 
 namespace triton {
 namespace developer_tools {
@@ -32,6 +36,35 @@ inline auto get_backend_name(TRITONBACKEND_Backend& backend)
   return std::string(cname);
 }
 
+/**
+ * @brief Return the value of a backend configuration setting passed on the
+ * server command line (e.g. `--backend-config=<backend>,<name>=<value>`), if
+ * it was set
+ */
+inline auto get_backend_config_param(TRITONBACKEND_Backend& backend, std::string const& name)
+{
+  auto* config_message = static_cast<TRITONSERVER_Message*>(nullptr);
+  triton_check(TRITONBACKEND_BackendConfig(&backend, &config_message));
+
+  auto* buffer   = static_cast<char const*>(nullptr);
+  auto byte_size = std::size_t{};
+  auto* err      = TRITONSERVER_MessageSerializeToJson(config_message, &buffer, &byte_size);
+
+  auto result         = std::optional<std::string>{};
+  auto backend_config = common::TritonJson::Value{};
+  if (err == nullptr) { err = backend_config.Parse(buffer, byte_size); }
+  auto cmdline = common::TritonJson::Value{};
+  if (err == nullptr && backend_config.Find("cmdline", &cmdline) && cmdline.Find(name.c_str())) {
+    auto value = std::string{};
+    err        = cmdline.MemberAsString(name.c_str(), &value);
+    if (err == nullptr) { result = std::move(value); }
+  }
+  auto* delete_err = TRITONSERVER_MessageDelete(config_message);
+  if (err != nullptr) { throw(TritonException(err)); }
+  if (delete_err != nullptr) { throw(TritonException(delete_err)); }
+  return result;
+}
+
 namespace {
 struct backend_version {
   std::uint32_t major;
@@ -32,6 +32,20 @@ inline auto get_max_batch_size(common::TritonJson::Value& config)
   triton_check(config.MemberAsInt("max_batch_size", &reported));
   return narrow<std::size_t>(reported);
 }
+
+/**
+ * @brief Check whether the model config selects the decoupled transaction
+ * policy, under which any number of responses may be sent for a request
+ */
+inline auto get_decoupled(common::TritonJson::Value& config)
+{
+  auto result = false;
+  auto policy = common::TritonJson::Value{};
+  if (config.Find("model_transaction_policy", &policy) && policy.Find("decoupled")) {
+    triton_check(policy.MemberAsBool("decoupled", &result));
+  }
+  return result;
+}
 }  // namespace backend
 }  // namespace developer_tools
 }  // namespace triton
@@ -19,6 +19,7 @@
 #include <stdint.h>
 #include <triton/core/tritonbackend.h>
 #include <algorithm>
+#include <iterator>
 #include <numeric>
 #include <triton/developer_tools/exceptions.hpp>
 #include <triton/developer_tools/tensor/dtype.hpp>
@@ -37,41 +38,176 @@ inline auto* get_triton_input(TRITONBACKEND_Request* request, std::string const&
   return result;
 }
 
+namespace detail {
+/* Fold the shape of one request's input into the shape of the input for the
+ * whole batch, checking that every dimension after the batch dimension
+ * agrees with the requests already seen */
+inline void accumulate_input_shape(std::string const& name,
+                                   int64_t const* input_shape,
+                                   uint32_t input_dims,
+                                   bool first_request,
+                                   std::vector<std::size_t>& batch_shape,
+                                   int64_t& batch_dim)
+{
+  if (first_request) {
+    batch_shape.resize(input_dims);
+    std::transform(input_shape, input_shape + input_dims, batch_shape.begin(), [](auto& val) {
+      return narrow<std::size_t>(val);
+    });
+  } else {
+    auto consistent = batch_shape.size() == input_dims;
+    for (auto dim = std::size_t{1}; consistent && dim < input_dims; ++dim) {
+      consistent = batch_shape[dim] == narrow<std::size_t>(input_shape[dim]);
+    }
+    if (!consistent) {
+      throw TritonException(Error::InvalidArg,
+                            "requests in batch have inconsistent shapes beyond the batch "
+                            "dimension for input " +
+                              name + "; retrieve it as a ragged input instead");
+    }
+  }
+  if (input_dims != 0) { batch_dim += *input_shape; }
+}
+}  // namespace detail
+
+/**
+ * @brief Get the shape of an input for an entire batch
+ *
+ * The batch dimension is the sum of the batch dimensions of all requests. All
+ * other dimensions must be the same for every request.
+ */
 template <typename T, typename Iter>
 auto get_triton_input_shape(Iter requests_begin, Iter requests_end, std::string const& name)
+{
+  auto result        = std::vector<std::size_t>{};
+  auto batch_dim     = int64_t{};
+  auto first_request = true;
+
+  std::for_each(requests_begin, requests_end, [&](auto& request) {
+    auto reported_dtype     = DType{};
+    auto const* input_shape = static_cast<int64_t*>(nullptr);
+    auto input_dims         = uint32_t{};
+
+    auto* input = get_triton_input(request, name);
+    triton_check(TRITONBACKEND_InputProperties(
+      input, nullptr, &reported_dtype, &input_shape, &input_dims, nullptr, nullptr));
+
+    if (reported_dtype != TritonDtype<T>::value) {
+      auto log_stream = std::stringstream{};
+      log_stream << "incorrect type " << reported_dtype << " for input with required type "
+                 << TritonDtype<T>::value;
+      throw(TritonException(Error::Internal, log_stream.str()));
+    }
+
+    detail::accumulate_input_shape(
+      name, input_shape, input_dims, first_request, result, batch_dim);
+    first_request = false;
+  });
+
+  if (!result.empty()) { result[0] = narrow<std::size_t>(batch_dim); }
+
+  return result;
+}
+
+/**
+ * @brief Get the shape of an input in each request of a batch
+ */
+template <typename T, typename Iter>
+auto get_triton_input_request_shapes(Iter requests_begin,
+                                     Iter requests_end,
+                                     std::string const& name)
+{
+  auto result = std::vector<std::vector<std::size_t>>{};
+  result.reserve(std::distance(requests_begin, requests_end));
+
+  std::transform(requests_begin, requests_end, std::back_inserter(result), [&name](auto& request) {
+    auto reported_dtype     = DType{};
+    auto const* input_shape = static_cast<int64_t*>(nullptr);
+    auto input_dims         = uint32_t{};
+
+    auto* input = get_triton_input(request, name);
+    triton_check(TRITONBACKEND_InputProperties(
+      input, nullptr, &reported_dtype, &input_shape, &input_dims, nullptr, nullptr));
+
+    if (reported_dtype != TritonDtype<T>::value) {
+      auto log_stream = std::stringstream{};
+      log_stream << "incorrect type " << reported_dtype << " for input with required type "
+                 << TritonDtype<T>::value;
+      throw(TritonException(Error::Internal, log_stream.str()));
+    }
+
+    auto shape = std::vector<std::size_t>(input_dims);
+    std::transform(input_shape, input_shape + input_dims, shape.begin(), [](auto& val) {
+      return narrow<std::size_t>(val);
+    });
+    return shape;
+  });
+  return result;
+}
+
+/**
+ * @brief Get the size of the batch dimension of the named input in each
+ * request
+ */
+template <typename Iter>
+auto get_triton_input_batch_dims(Iter requests_begin, Iter requests_end, std::string const& name)
 {
   auto result = std::vector<std::size_t>{};
+  result.reserve(std::distance(requests_begin, requests_end));
+  std::transform(requests_begin, requests_end, std::back_inserter(result), [&name](auto& request) {
+    auto const* input_shape = static_cast<int64_t*>(nullptr);
+    auto input_dims         = uint32_t{};
+    auto* input             = get_triton_input(request, name);
+    triton_check(TRITONBACKEND_InputProperties(
+      input, nullptr, nullptr, &input_shape, &input_dims, nullptr, nullptr));
+    return input_dims == 0 ? std::size_t{} : narrow<std::size_t>(*input_shape);
+  });
+  return result;
+}
+
+/**
+ * @brief Get the shapes of several inputs for an entire batch in a single
+ * walk over the requests
+ *
+ * Each shape is determined as in `get_triton_input_shape`, and the dtype of
+ * each input is checked against the corresponding entry of `dtypes`.
+ */
+template <typename Iter>
+auto get_triton_input_shapes(Iter requests_begin,
+                             Iter requests_end,
+                             std::vector<std::string> const& names,
+                             std::vector<DType> const& dtypes)
+{
+  auto result        = std::vector<std::vector<std::size_t>>(names.size());
+  auto batch_dims    = std::vector<int64_t>(names.size());
+  auto first_request = true;
 
-  auto reported_dtype     = DType{};
-  auto const* input_shape = static_cast<int64_t*>(nullptr);
-  auto input_dims         = uint32_t{};
+  std::for_each(requests_begin, requests_end, [&](auto& request) {
+    for (auto i = std::size_t{}; i < names.size(); ++i) {
+      auto reported_dtype     = DType{};
+      auto const* input_shape = static_cast<int64_t*>(nullptr);
+      auto input_dims         = uint32_t{};
 
-  auto batch_dim = std::accumulate(
-    requests_begin,
-    requests_end,
-    int64_t{},
-    [&reported_dtype, &input_shape, &input_dims, &name](auto total, auto& request) {
-      auto* input = get_triton_input(request, name);
+      auto* input = get_triton_input(request, names[i]);
       triton_check(TRITONBACKEND_InputProperties(
         input, nullptr, &reported_dtype, &input_shape, &input_dims, nullptr, nullptr));
 
-      if (reported_dtype != TritonDtype<T>::value) {
+      if (reported_dtype != dtypes[i]) {
         auto log_stream = std::stringstream{};
-        log_stream << "incorrect type " << reported_dtype << " for input with required type "
-                   << TritonDtype<T>::value;
+        log_stream << "incorrect type " << reported_dtype << " for input " << names[i]
+                   << " with required type " << dtypes[i];
         throw(TritonException(Error::Internal, log_stream.str()));
       }
 
-      if (input_dims != 0) { total += *input_shape; }
-      return total;
-    });
-
-  result.reserve(input_dims);
-  std::transform(input_shape, input_shape + input_dims, std::back_inserter(result), [](auto& val) {
-    return narrow<std::size_t>(val);
+      detail::accumulate_input_shape(
+        names[i], input_shape, input_dims, first_request, result[i], batch_dims[i]);
+    }
+    first_request = false;
   });
 
-  if (!result.empty()) { result[0] = narrow<std::size_t>(batch_dim); }
+  for (auto i = std::size_t{}; i < names.size(); ++i) {
+    if (!result[i].empty()) { result[i][0] = narrow<std::size_t>(batch_dims[i]); }
+  }
 
   return result;
 }
@@ -16,8 +16,11 @@
 
 #pragma once
 #include <triton/backend/backend_model_instance.h>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <triton/developer_tools/batch/inflight_batches.hpp>
+#include <triton/developer_tools/memory/buffer_pool.hpp>
 #include <triton/developer_tools/triton/model_instance.hpp>
 #include <triton/developer_tools/triton/model_state.hpp>
 
@@ -36,17 +39,48 @@ struct ModelInstanceState : public triton::backend::BackendModelInstance {
              Kind(),
              triton::backend::JoinPath({model_state.RepositoryPath(),
                        std::to_string(model_state.Version()),
-                       ArtifactFilename()}))
+                       ArtifactFilename()})),
+      output_pool_{model_.template get_config_param<bool>("output_buffer_pool", true)
+                     ? BufferPool::create()
+                     : nullptr},
+      inflight_{[this]() {
+        auto max_inflight =
+          model_.template get_config_param<std::size_t>("max_inflight_batches", std::size_t{1});
+        return max_inflight > 1 ? std::make_unique<InflightBatches>(max_inflight) : nullptr;
+      }()}
   {
   }
 
   auto& get_model() const { return model_; }
 
+  /**
+   * @brief Return the pool from which the output buffers of this instance's
+   * batches are borrowed, or nullptr if pooling is disabled with the
+   * `output_buffer_pool` config parameter
+   */
+  auto get_output_pool() const { return output_pool_; }
+
+  /**
+   * @brief Return the tracker for batches whose responses are sent
+   * asynchronously, or nullptr if the `max_inflight_batches` config parameter
+   * is not greater than one and every batch completes within execute
+   */
+  auto* get_inflight_batches() const { return inflight_.get(); }
+
   void load() { model_.load(); }
-  void unload() { model_.unload(); }
+  void unload()
+  {
+    if (inflight_) { inflight_->wait_all(); }
+    model_.unload();
+    if (output_pool_) { output_pool_->clear(); }
+  }
 
  private:
   ToolsModel model_;
+  std::shared_ptr<BufferPool> output_pool_;
+  // Declared last so that batches still in flight complete before the model
+  // is destroyed
+  std::unique_ptr<InflightBatches> inflight_;
 };
 
 }  // namespace backend
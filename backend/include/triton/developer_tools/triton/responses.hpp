@@ -70,6 +70,58 @@ void send_responses(Iter begin, Iter end, TRITONSERVER_Error* err)
   });
 }
 
+/**
+ * @brief Delete responses which will not be sent, setting each to nullptr
+ */
+template <typename Iter>
+void delete_responses(Iter begin, Iter end)
+{
+  std::for_each(begin, end, [](auto& response) {
+    if (response != nullptr) {
+      try {
+        triton_check(TRITONBACKEND_ResponseDelete(response));
+      } catch (TritonException& err) {
+        log_error(__FILE__, __LINE__, err.what());
+      }
+      response = nullptr;
+    }
+  });
+}
+
+template <typename Iter>
+void delete_response_factories(Iter begin, Iter end)
+{
+  std::for_each(begin, end, [](auto* factory) {
+    try {
+      triton_check(TRITONBACKEND_ResponseFactoryDelete(factory));
+    } catch (TritonException& err) {
+      log_error(__FILE__, __LINE__, err.what());
+    }
+  });
+}
+
+/**
+ * @brief Create a response factory for each request, through which a
+ * decoupled model may send any number of responses
+ */
+template <typename Iter>
+auto construct_response_factories(Iter requests_begin, Iter requests_end)
+{
+  auto factories = std::vector<TRITONBACKEND_ResponseFactory*>{};
+  factories.reserve(std::distance(requests_begin, requests_end));
+  try {
+    std::transform(requests_begin, requests_end, std::back_inserter(factories), [](auto* request) {
+      auto* factory = static_cast<TRITONBACKEND_ResponseFactory*>(nullptr);
+      triton_check(TRITONBACKEND_ResponseFactoryNew(&factory, request));
+      return factory;
+    });
+  } catch (TritonException&) {
+    delete_response_factories(std::begin(factories), std::end(factories));
+    throw;
+  }
+  return factories;
+}
+
 }  // namespace backend
 }  // namespace developer_tools
 }  // namespace triton
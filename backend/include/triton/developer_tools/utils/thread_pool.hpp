@@ -0,0 +1,343 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace triton {
+namespace developer_tools {
+namespace backend {
+/**
+ * @brief A pool of worker threads which balance work among themselves by
+ * stealing
+ *
+ * Each worker owns a queue of tasks. Tasks submitted from a worker go to the
+ * back of its own queue and are taken from there first, so that recently
+ * produced (and likely cache-resident) work is processed by the thread that
+ * produced it; idle workers steal from the front of other workers' queues.
+ * Tasks submitted from outside the pool are distributed across the queues in
+ * round-robin order.
+ */
+struct ThreadPool {
+  using size_type = std::size_t;
+
+  explicit ThreadPool(size_type thread_count = default_thread_count())
+    : queues_{}, sleep_mtx_{}, wake_{}, pending_{0}, stopping_{false}, next_queue_{0}, workers_{}
+  {
+    thread_count = std::max(thread_count, size_type{1});
+    queues_.reserve(thread_count);
+    for (auto i = size_type{}; i < thread_count; ++i) {
+      queues_.push_back(std::make_unique<worker_queue>());
+    }
+    workers_.reserve(thread_count);
+    for (auto i = size_type{}; i < thread_count; ++i) {
+      workers_.emplace_back([this, i]() { run(i); });
+    }
+  }
+
+  ThreadPool(ThreadPool const&) = delete;
+  ThreadPool& operator=(ThreadPool const&) = delete;
+
+  ~ThreadPool()
+  {
+    {
+      auto lock = std::lock_guard<std::mutex>{sleep_mtx_};
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  static size_type default_thread_count()
+  {
+    return std::max(size_type{std::thread::hardware_concurrency()}, size_type{1});
+  }
+
+  auto size() const { return workers_.size(); }
+
+  /**
+   * @brief Queue a task for execution by the pool
+   *
+   * Exceptions thrown by the task are discarded; use `parallel_for` or
+   * `parallel_reduce` to propagate errors back to the caller.
+   */
+  void submit(std::function<void()> task)
+  {
+    auto index = current_pool_ == this ? current_index_
+                                       : next_queue_.fetch_add(1, std::memory_order_relaxed) %
+                                           queues_.size();
+    {
+      auto lock = std::lock_guard<std::mutex>{queues_[index]->mtx};
+      queues_[index]->tasks.push_back(std::move(task));
+    }
+    {
+      auto lock = std::lock_guard<std::mutex>{sleep_mtx_};
+      ++pending_;
+    }
+    wake_.notify_one();
+  }
+
+  /**
+   * @brief Run one queued task on the calling thread, if any is available
+   *
+   * @return whether a task was run
+   */
+  bool run_pending_task()
+  {
+    auto task = std::function<void()>{};
+    auto home = current_pool_ == this ? current_index_ : size_type{};
+    if (!try_pop(home, task)) { return false; }
+    run_task(task);
+    return true;
+  }
+
+  /**
+   * @brief Invoke `body(chunk_begin, chunk_end)` over contiguous chunks of
+   * [begin, end) in parallel, returning once every chunk has been processed
+   *
+   * Each chunk covers `grain` consecutive indices (the last may be shorter).
+   * If `grain` is zero, it is chosen to give each thread a few chunks, which
+   * keeps each thread working on a contiguous region while leaving room to
+   * balance uneven chunks. The calling thread processes chunks as well, and
+   * calls may be nested. If any invocation of `body` throws, the remaining
+   * chunks are skipped and the first exception is rethrown.
+   */
+  template <typename F>
+  void parallel_for(size_type begin, size_type end, F&& body, size_type grain = 0)
+  {
+    if (end <= begin) { return; }
+    grain       = chunk_size(end - begin, grain);
+    auto chunks = (end - begin + grain - 1) / grain;
+    if (chunks == 1) {
+      body(begin, end);
+      return;
+    }
+
+    auto state      = std::make_shared<loop_state>();
+    auto run_chunks = [state, chunks, grain, begin, end, &body]() {
+      for (auto chunk = state->next++; chunk < chunks; chunk = state->next++) {
+        if (!state->failed.load()) {
+          auto chunk_begin = begin + chunk * grain;
+          try {
+            body(chunk_begin, std::min(chunk_begin + grain, end));
+          } catch (...) {
+            auto lock = std::lock_guard<std::mutex>{state->mtx};
+            if (!state->failed.exchange(true)) { state->error = std::current_exception(); }
+          }
+        }
+        if (++state->done == chunks) {
+          auto lock = std::lock_guard<std::mutex>{state->mtx};
+          state->finished.notify_all();
+        }
+      }
+    };
+
+    auto helpers = std::min(size(), chunks - 1);
+    for (auto i = size_type{}; i < helpers; ++i) {
+      submit(run_chunks);
+    }
+    run_chunks();
+
+    // Help with other queued work while waiting so that nested loops cannot
+    // starve the pool
+    while (state->done.load() < chunks) {
+      if (!run_pending_task()) {
+        auto lock = std::unique_lock<std::mutex>{state->mtx};
+        state->finished.wait_for(lock, std::chrono::microseconds(100), [&state, chunks]() {
+          return state->done == chunks;
+        });
+      }
+    }
+    if (state->error) { std::rethrow_exception(state->error); }
+  }
+
+  /**
+   * @brief Reduce [begin, end) in parallel
+   *
+   * `map(chunk_begin, chunk_end)` computes a partial result for each chunk as
+   * in `parallel_for`, and the partial results are folded into `init` with
+   * `combine` in index order, so the result is deterministic even for
+   * operations which are not associative in floating point.
+   */
+  template <typename T, typename Map, typename Combine>
+  auto parallel_reduce(
+    size_type begin, size_type end, T init, Map&& map, Combine&& combine, size_type grain = 0)
+  {
+    auto result = std::move(init);
+    if (end <= begin) { return result; }
+    grain         = chunk_size(end - begin, grain);
+    auto chunks   = (end - begin + grain - 1) / grain;
+    auto partials = std::vector<std::optional<T>>(chunks);
+    parallel_for(
+      size_type{},
+      chunks,
+      [&partials, &map, begin, end, grain](size_type first_chunk, size_type last_chunk) {
+        for (auto chunk = first_chunk; chunk < last_chunk; ++chunk) {
+          auto chunk_begin = begin + chunk * grain;
+          partials[chunk].emplace(map(chunk_begin, std::min(chunk_begin + grain, end)));
+        }
+      },
+      size_type{1});
+    for (auto& partial : partials) {
+      result = combine(std::move(result), std::move(*partial));
+    }
+    return result;
+  }
+
+ private:
+  struct worker_queue {
+    std::mutex mtx{};
+    std::deque<std::function<void()>> tasks{};
+  };
+
+  struct loop_state {
+    std::atomic<std::size_t> next{0};
+    std::atomic<std::size_t> done{0};
+    std::atomic<bool> failed{false};
+    std::mutex mtx{};
+    std::condition_variable finished{};
+    std::exception_ptr error{};
+  };
+
+  inline static thread_local ThreadPool const* current_pool_ = nullptr;
+  inline static thread_local size_type current_index_        = 0;
+
+  std::vector<std::unique_ptr<worker_queue>> queues_;
+  std::mutex sleep_mtx_;
+  std::condition_variable wake_;
+  std::atomic<size_type> pending_;
+  bool stopping_;
+  std::atomic<size_type> next_queue_;
+  // Declared last so that every other member is initialized before the
+  // workers start
+  std::vector<std::thread> workers_;
+
+  size_type chunk_size(size_type count, size_type grain) const
+  {
+    if (grain == 0) {
+      auto target_chunks = 4 * (size() + 1);
+      grain              = (count + target_chunks - 1) / target_chunks;
+    }
+    return std::max(grain, size_type{1});
+  }
+
+  /* Take a task from the back of the home queue or, failing that, steal one
+   * from the front of another queue */
+  bool try_pop(size_type home, std::function<void()>& task)
+  {
+    for (auto offset = size_type{}; offset < queues_.size(); ++offset) {
+      auto& queue = *queues_[(home + offset) % queues_.size()];
+      auto lock   = std::lock_guard<std::mutex>{queue.mtx};
+      if (!queue.tasks.empty()) {
+        if (offset == 0) {
+          task = std::move(queue.tasks.back());
+          queue.tasks.pop_back();
+        } else {
+          task = std::move(queue.tasks.front());
+          queue.tasks.pop_front();
+        }
+        --pending_;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static void run_task(std::function<void()>& task)
+  {
+    try {
+      task();
+    } catch (...) {
+    }
+  }
+
+  void run(size_type index)
+  {
+    current_pool_  = this;
+    current_index_ = index;
+    auto task      = std::function<void()>{};
+    while (true) {
+      if (try_pop(index, task)) {
+        run_task(task);
+        task = nullptr;
+        continue;
+      }
+      auto lock = std::unique_lock<std::mutex>{sleep_mtx_};
+      wake_.wait(lock, [this]() { return stopping_ || pending_.load() > 0; });
+      if (stopping_ && pending_.load() == 0) { break; }
+    }
+  }
+};
+
+namespace detail {
+struct thread_pool_holder {
+  std::mutex mtx{};
+  std::size_t thread_count{ThreadPool::default_thread_count()};
+  std::shared_ptr<ThreadPool> pool{};
+};
+
+inline auto& get_thread_pool_holder()
+{
+  static auto holder = thread_pool_holder{};
+  return holder;
+}
+}  // namespace detail
+
+/**
+ * @brief Set the number of threads in the backend-wide thread pool
+ *
+ * The pool itself is only started on first use, so backends which never use
+ * it pay nothing for it. If the pool has already been started, it is
+ * replaced; callers still holding the old pool may continue to use it.
+ */
+inline void setup_thread_pool(std::size_t thread_count)
+{
+  thread_count = std::max(thread_count, std::size_t{1});
+  auto& holder = detail::get_thread_pool_holder();
+  auto lock    = std::lock_guard<std::mutex>{holder.mtx};
+  if (holder.pool && holder.pool->size() != thread_count) { holder.pool.reset(); }
+  holder.thread_count = thread_count;
+}
+
+/**
+ * @brief Return the backend-wide thread pool, starting it if necessary
+ */
+inline auto get_thread_pool()
+{
+  auto& holder = detail::get_thread_pool_holder();
+  auto lock    = std::lock_guard<std::mutex>{holder.mtx};
+  if (!holder.pool) { holder.pool = std::make_shared<ThreadPool>(holder.thread_count); }
+  return holder.pool;
+}
+
+}  // namespace backend
+}  // namespace developer_tools
+}  // namespace triton
@@ -73,25 +73,38 @@ struct ToolsModel : backend::Model<ToolsSharedState> {
    * a predict function requires four steps:
    * 1. Call `get_input` on the provided `Batch` object for each of the input
    *    tensors named in the config file for this backend. This provides a
-   *    `Tensor` object containing the input data.
+   *    `Tensor` object containing the input data. Models with several inputs
+   *    can instead call `get_inputs` once to collect all of them together,
+   *    e.g. `auto [x, mask] = get_inputs<float, bool>(batch, "x", "mask");`
    * 2. Call `get_output` on the provided `Batch` object for each of the output
    *    tensors named in the config file for this backend. This provides a
-   *    `Tensor` object to which output values can be written.
+   *    `Tensor` object to which output values can be written. Output memory
+   *    is recycled across batches and is not zero-initialized, so every
+   *    element must be written, unless the `output_buffer_pool` parameter is
+   *    set to false in the config file.
    * 3. Perform inference based on the input Tensors and store the results in
    *    the output Tensors. `some_tensor.data()` can be used to retrieve a raw
-   *    pointer to the underlying data.
+   *    pointer to the underlying data. An output which simply forwards an
+   *    input, or a reshaped view of one, can instead be obtained with
+   *    `get_output_alias(batch, "output__0", input)`, which sends the input's
+   *    data without an intermediate copy.
    * 4. Call the `finalize` method on all output tensors.
+   *
+   * Models with `model_transaction_policy { decoupled: true }` in their config
+   * may also stream results: outputs from `get_streamed_output` are sent to
+   * each request as a partial response by `send_streamed_outputs(batch)`, as
+   * many times as needed, and every request is completed when predict
+   * returns.
    **************************************************************************/
   void predict(backend::Batch& batch) const
   {
     // 1. Acquire a tensor representing the input named "input__0"
     auto input = get_input<float>(batch, "input__0");
-    // 2. Acquire a tensor representing the output named "output__0"
-    auto output = get_output<float>(batch, "output__0");
-
-    // 3. Perform inference. In this example, we simply copy the data from the
-    // input to the output tensor.
-    backend::copy(output, input);
+    // 2 and 3. Perform inference. In this example, the output named
+    // "output__0" is simply the input, so rather than acquiring an output
+    // tensor and copying the input into it, we acquire an output which
+    // shares the input's memory.
+    auto output = get_output_alias(batch, "output__0", input);
 
     // 4. Call finalize on all output tensors. In this case, we have just one
     // output, so we call finalize on it.
@@ -14,4 +14,251 @@
  * limitations under the License.
  */
 
+#ifdef TRITON_ENABLE_GPU
+#include <cuda_runtime_api.h>
+#else
+#include <triton/developer_tools/cpu_only/cuda_runtime_replacement.hpp>
+#endif
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <stubs/triton_backend.hpp>
 #include <triton/developer_tools/batch/batch.hpp>
+#include <triton/developer_tools/exceptions.hpp>
+#include <triton/developer_tools/stream/stream_pool.hpp>
+#include <vector>
+
+namespace triton {
+namespace developer_tools {
+namespace backend {
+namespace {
+/* A batch of the given requests whose outputs have a single column, or the
+ * given shape in the model config if their shape is requested */
+auto make_batch(std::vector<TRITONBACKEND_Request*>& raw_requests,
+                std::vector<std::int64_t> config_shape = {-1, 1})
+{
+  return Batch(
+    raw_requests.data(),
+    static_cast<request_size_t>(raw_requests.size()),
+    *reinterpret_cast<TRITONBACKEND_MemoryManager*>(raw_requests.data()),
+    [](std::string const&, Batch::size_type batch_dim) {
+      return std::vector<Batch::size_type>{batch_dim, 1};
+    },
+    [](TRITONBACKEND_Request*,
+       time_point const&,
+       time_point const&,
+       time_point const&,
+       time_point const&) {},
+    false,
+    false,
+    Batch::size_type{4},
+    cudaStream_t{},
+    nullptr,
+    false,
+    [config_shape](std::string const&) { return config_shape; });
+}
+
+/* The Triton error code of the exception thrown by `fn`, if any */
+auto thrown_error_code(std::function<void()> const& fn)
+{
+  try {
+    fn();
+  } catch (TritonException const& err) {
+    return TRITONSERVER_ErrorCode(err.error());
+  }
+  return Error::Unknown;
+}
+}  // namespace
+
+TEST(BackendTools, batch_output_alias)
+{
+  stubs::reset_triton_records();
+  auto requests =
+    std::vector<TRITONBACKEND_Request>{TRITONBACKEND_Request{0, {{1, 2}}, {"y"}},
+                                       TRITONBACKEND_Request{1, {{2, 2}}, {"y"}}};
+  auto raw_requests = std::vector<TRITONBACKEND_Request*>{&requests[0], &requests[1]};
+  auto data         = std::vector<float>{0, 1, 2, 3, 4, 5};
+  {
+    auto batch = make_batch(raw_requests);
+    auto input = Tensor<float>(std::vector<std::size_t>{3, 2},
+                               Buffer<float>{data.data(), data.size(), HostMemory});
+
+    // An alias is only valid once the batch size is known from an input
+    EXPECT_EQ(thrown_error_code([&]() { batch.get_output_alias("y", input); }), Error::InvalidArg);
+    batch.get_input_shape<float>("x");
+
+    // It must keep the batch size and view every element of its input
+    EXPECT_EQ(thrown_error_code([&]() { batch.get_output_alias("y", input, {2, 3}); }),
+              Error::InvalidArg);
+    EXPECT_EQ(thrown_error_code([&]() { batch.get_output_alias("y", input, {3, 1}); }),
+              Error::InvalidArg);
+
+    auto output = batch.get_output_alias("y", input, {3, 2, 1});
+    EXPECT_EQ(output.data(), data.data());
+    EXPECT_THAT(output.shape(), ::testing::ElementsAre(3, 2, 1));
+    output.finalize();
+    batch.finalize(nullptr);
+  }
+
+  // Each request is sent its own rows of the input
+  ASSERT_EQ(stubs::sent_responses.size(), 2);
+  ASSERT_EQ(stubs::sent_responses[0].outputs.size(), 1);
+  ASSERT_EQ(stubs::sent_responses[1].outputs.size(), 1);
+  EXPECT_THAT(stubs::sent_responses[0].outputs[0]->shape, ::testing::ElementsAre(1, 2, 1));
+  EXPECT_THAT(stubs::sent_responses[0].outputs[0]->data, ::testing::ElementsAre(0.0f, 1.0f));
+  EXPECT_THAT(stubs::sent_responses[1].outputs[0]->shape, ::testing::ElementsAre(2, 2, 1));
+  EXPECT_THAT(stubs::sent_responses[1].outputs[0]->data,
+              ::testing::ElementsAre(2.0f, 3.0f, 4.0f, 5.0f));
+  EXPECT_EQ(stubs::released_requests, 2);
+}
+TEST(BackendTools, batch_request_views)
+{
+  stubs::reset_triton_records();
+  auto requests     = std::vector<TRITONBACKEND_Request>{TRITONBACKEND_Request{0, {{1, 2}}},
+                                                     TRITONBACKEND_Request{1, {{3, 2}}},
+                                                     TRITONBACKEND_Request{2, {{2, 2}}}};
+  auto raw_requests = std::vector<TRITONBACKEND_Request*>{&requests[0], &requests[1], &requests[2]};
+  auto batch        = make_batch(raw_requests);
+
+  auto shapes = batch.get_request_shapes<float>("x");
+  ASSERT_EQ(shapes.size(), 3);
+  EXPECT_THAT(shapes[0], ::testing::ElementsAre(1, 2));
+  EXPECT_THAT(shapes[1], ::testing::ElementsAre(3, 2));
+  EXPECT_THAT(shapes[2], ::testing::ElementsAre(2, 2));
+
+  // Request boundaries are only known once an input has been retrieved
+  EXPECT_THROW(batch.get_request_row_offsets(), TritonException);
+  EXPECT_THAT(batch.get_input_shape<float>("x"), ::testing::ElementsAre(6, 2));
+  EXPECT_THAT(batch.get_request_batch_dims(), ::testing::ElementsAre(1, 3, 2));
+  EXPECT_THAT(batch.get_request_row_offsets(), ::testing::ElementsAre(0, 1, 4));
+  batch.finalize(nullptr);
+}
+
+TEST(BackendTools, batch_inconsistent_input_shape)
+{
+  stubs::reset_triton_records();
+  auto requests     = std::vector<TRITONBACKEND_Request>{TRITONBACKEND_Request{0, {{1, 2}}},
+                                                     TRITONBACKEND_Request{1, {{1, 3}}}};
+  auto raw_requests = std::vector<TRITONBACKEND_Request*>{&requests[0], &requests[1]};
+  auto batch        = make_batch(raw_requests);
+
+  EXPECT_EQ(thrown_error_code([&]() { batch.get_input_shape<float>("x"); }), Error::InvalidArg);
+  batch.finalize(nullptr);
+}
+
+TEST(BackendTools, batch_ragged_input)
+{
+  stubs::reset_triton_records();
+  auto requests     = std::vector<TRITONBACKEND_Request>{
+    TRITONBACKEND_Request{0, {{1, 2}, {0.0f, 1.0f}}},
+    TRITONBACKEND_Request{1, {{1, 3}, {2.0f, 3.0f, 4.0f}}},
+    TRITONBACKEND_Request{2, {{2, 1}, {5.0f, 6.0f}}}};
+  auto raw_requests = std::vector<TRITONBACKEND_Request*>{&requests[0], &requests[1], &requests[2]};
+  auto batch        = make_batch(raw_requests);
+  auto pool         = StreamPool{1};
+
+  auto ragged = batch.get_ragged_input<float const>("x", HostMemory, 0, pool[0]);
+  ASSERT_EQ(ragged.request_count(), 3);
+  EXPECT_THAT(ragged.shapes()[0], ::testing::ElementsAre(1, 2));
+  EXPECT_THAT(ragged.shapes()[1], ::testing::ElementsAre(1, 3));
+  EXPECT_THAT(ragged.shapes()[2], ::testing::ElementsAre(2, 1));
+
+  auto values = std::vector<float>(ragged.values().data(),
+                                   ragged.values().data() + ragged.values().size());
+  EXPECT_THAT(values, ::testing::ElementsAre(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f));
+  auto offsets = std::vector<std::int64_t>(ragged.offsets().data(),
+                                           ragged.offsets().data() + ragged.offsets().size());
+  EXPECT_THAT(offsets, ::testing::ElementsAre(0, 2, 5, 7));
+  EXPECT_EQ(ragged.offsets().mem_type(), HostMemory);
+  EXPECT_EQ(ragged.offsets().stream(), pool[0]);
+
+  // The rows of the requests still define the batch
+  EXPECT_THAT(batch.get_request_row_offsets(), ::testing::ElementsAre(0, 1, 2));
+  batch.finalize(nullptr);
+}
+TEST(BackendTools, batch_request_rows_output)
+{
+  stubs::reset_triton_records();
+  auto requests     = std::vector<TRITONBACKEND_Request>{TRITONBACKEND_Request{0, {{1, 2}}},
+                                                     TRITONBACKEND_Request{1, {{1, 2}}},
+                                                     TRITONBACKEND_Request{2, {{1, 2}}}};
+  auto raw_requests = std::vector<TRITONBACKEND_Request*>{&requests[0], &requests[1], &requests[2]};
+  {
+    auto batch = make_batch(raw_requests, {-1, -1, 2});
+    auto rows  = std::vector<std::size_t>{3, 0, 1};
+
+    // The rows must add up to the first dimension, one entry per request
+    EXPECT_EQ(thrown_error_code([&]() {
+                batch.get_output<float>("y", {4, 1, 2}, {3, 0, 0}, HostMemory, 0);
+              }),
+              Error::InvalidArg);
+    EXPECT_EQ(thrown_error_code([&]() {
+                batch.get_output<float>("y", {4, 1, 2}, {3, 1}, HostMemory, 0);
+              }),
+              Error::InvalidArg);
+    // The shape must have the rank and fixed dimensions of the config
+    EXPECT_EQ(
+      thrown_error_code([&]() { batch.get_output<float>("y", {4, 2}, rows, HostMemory, 0); }),
+      Error::InvalidArg);
+    EXPECT_EQ(
+      thrown_error_code([&]() { batch.get_output<float>("y", {4, 1, 3}, rows, HostMemory, 0); }),
+      Error::InvalidArg);
+
+    auto output = batch.get_output<float>("y", {4, 1, 2}, rows, HostMemory, 0);
+    for (auto i = std::size_t{}; i < output.size(); ++i) {
+      output.data()[i] = static_cast<float>(i);
+    }
+    output.finalize();
+    batch.finalize(nullptr);
+  }
+
+  // Each request is sent its own rows, even if it has none
+  ASSERT_EQ(stubs::sent_responses.size(), 3);
+  for (auto const& response : stubs::sent_responses) {
+    ASSERT_EQ(response.outputs.size(), 1);
+  }
+  EXPECT_THAT(stubs::sent_responses[0].outputs[0]->shape, ::testing::ElementsAre(3, 1, 2));
+  EXPECT_THAT(stubs::sent_responses[0].outputs[0]->data,
+              ::testing::ElementsAre(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f));
+  EXPECT_THAT(stubs::sent_responses[1].outputs[0]->shape, ::testing::ElementsAre(0, 1, 2));
+  EXPECT_TRUE(stubs::sent_responses[1].outputs[0]->data.empty());
+  EXPECT_THAT(stubs::sent_responses[2].outputs[0]->shape, ::testing::ElementsAre(1, 1, 2));
+  EXPECT_THAT(stubs::sent_responses[2].outputs[0]->data, ::testing::ElementsAre(6.0f, 7.0f));
+}
+
+TEST(BackendTools, output_tensor_rows_skip_failed_requests)
+{
+  stubs::reset_triton_records();
+  auto request   = TRITONBACKEND_Request{0, {{1}}};
+  auto* response = static_cast<TRITONBACKEND_Response*>(nullptr);
+  TRITONBACKEND_ResponseNew(&response, &request);
+  // The response to a request which has already failed is null
+  auto responses = std::vector<TRITONBACKEND_Response*>{nullptr, response};
+  auto data      = std::vector<float>{0, 1, 2};
+
+  auto output = OutputTensor<float>(std::vector<std::size_t>{3},
+                                    Buffer<float>{data.data(), data.size(), HostMemory},
+                                    "y",
+                                    &responses,
+                                    std::vector<std::size_t>{2, 1});
+  output.finalize();
+
+  ASSERT_EQ(response->outputs.size(), 1);
+  EXPECT_THAT(response->outputs[0]->shape, ::testing::ElementsAre(1));
+  EXPECT_THAT(response->outputs[0]->data, ::testing::ElementsAre(2.0f));
+  TRITONBACKEND_ResponseDelete(response);
+
+  // Rows which do not add up to the tensor are a misuse
+  auto mismatched = OutputTensor<float>(std::vector<std::size_t>{3},
+                                        Buffer<float>{data.data(), data.size(), HostMemory},
+                                        "y",
+                                        &responses,
+                                        std::vector<std::size_t>{1, 1});
+  EXPECT_EQ(thrown_error_code([&]() { mismatched.finalize(); }), Error::InvalidArg);
+}
+}  // namespace backend
+}  // namespace developer_tools
+}  // namespace triton
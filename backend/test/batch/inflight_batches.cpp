@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <triton/developer_tools/batch/inflight_batches.hpp>
+#include <triton/developer_tools/exceptions.hpp>
+#include <vector>
+
+namespace triton {
+namespace developer_tools {
+namespace backend {
+TEST(BackendTools, inflight_batches_complete_in_order)
+{
+  auto inflight  = InflightBatches{4};
+  auto promises  = std::vector<std::promise<void>>(3);
+  auto completed = std::vector<int>{};
+  for (auto i = 0; i < 3; ++i) {
+    inflight.submit(promises[i].get_future(),
+                    [&completed, i](std::exception_ptr) { completed.push_back(i); });
+  }
+  EXPECT_EQ(inflight.inflight(), 3);
+
+  // Completing a later batch first does not reorder completions
+  promises[2].set_value();
+  promises[0].set_value();
+  promises[1].set_value();
+  inflight.wait_all();
+
+  EXPECT_EQ(inflight.inflight(), 0);
+  EXPECT_EQ(completed, (std::vector<int>{0, 1, 2}));
+}
+
+TEST(BackendTools, inflight_batches_forward_errors)
+{
+  auto inflight = InflightBatches{1};
+  auto done     = std::promise<void>{};
+  auto message  = std::string{};
+  inflight.submit(done.get_future(), [&message](std::exception_ptr error) {
+    try {
+      if (error) { std::rethrow_exception(error); }
+    } catch (std::exception& err) {
+      message = err.what();
+    }
+  });
+  done.set_exception(std::make_exception_ptr(std::runtime_error("predict failed")));
+  inflight.wait_all();
+  EXPECT_EQ(message, "predict failed");
+}
+
+TEST(BackendTools, inflight_batches_limit)
+{
+  auto inflight = InflightBatches{1};
+  auto first    = std::promise<void>{};
+  inflight.submit(first.get_future(), [](std::exception_ptr) {});
+
+  auto submitted = std::atomic<bool>{false};
+  auto submitter = std::async(std::launch::async, [&inflight, &submitted]() {
+    auto second = std::promise<void>{};
+    second.set_value();
+    inflight.submit(second.get_future(), [](std::exception_ptr) {});
+    submitted = true;
+  });
+
+  // The second submission must wait for the first batch to complete
+  EXPECT_EQ(submitter.wait_for(std::chrono::milliseconds(20)), std::future_status::timeout);
+  EXPECT_FALSE(submitted);
+  first.set_value();
+  submitter.get();
+  EXPECT_TRUE(submitted);
+  inflight.wait_all();
+}
+
+TEST(BackendTools, inflight_batches_empty)
+{
+  EXPECT_THROW(InflightBatches{0}, TritonException);
+}
+
+}  // namespace backend
+}  // namespace developer_tools
+}  // namespace triton
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifdef TRITON_ENABLE_GPU
+#include <cuda_runtime_api.h>
+#else
+#include <triton/developer_tools/cpu_only/cuda_runtime_replacement.hpp>
+#endif
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <stubs/triton_backend.hpp>
+#include <triton/developer_tools/batch/batch.hpp>
+#include <triton/developer_tools/batch/response_sender.hpp>
+#include <triton/developer_tools/exceptions.hpp>
+#include <utility>
+#include <vector>
+
+namespace triton {
+namespace developer_tools {
+namespace backend {
+namespace {
+/* A decoupled batch of two requests with one and two rows respectively in
+ * input "x"; every output has a single column */
+struct DecoupledBatch {
+  DecoupledBatch()
+    : requests{TRITONBACKEND_Request{0, {{1, 1}}}, TRITONBACKEND_Request{1, {{2, 1}}}},
+      raw_requests{&requests[0], &requests[1]},
+      batch{raw_requests.data(),
+            static_cast<request_size_t>(raw_requests.size()),
+            *reinterpret_cast<TRITONBACKEND_MemoryManager*>(&requests[0]),
+            [](std::string const&, Batch::size_type batch_dim) {
+              return std::vector<Batch::size_type>{batch_dim, 1};
+            },
+            [](TRITONBACKEND_Request*,
+               time_point const&,
+               time_point const&,
+               time_point const&,
+               time_point const&) {},
+            false,
+            false,
+            Batch::size_type{2},
+            cudaStream_t{},
+            nullptr,
+            true}
+  {
+  }
+
+  std::vector<TRITONBACKEND_Request> requests;
+  std::vector<TRITONBACKEND_Request*> raw_requests;
+  Batch batch;
+};
+
+template <typename T>
+void fill_output(OutputTensor<T>& output)
+{
+  for (auto i = std::size_t{}; i < output.size(); ++i) {
+    output.data()[i] = static_cast<T>(i);
+  }
+  output.finalize();
+}
+}  // namespace
+
+TEST(BackendTools, response_sender_streams_then_batch_sends_final)
+{
+  stubs::reset_triton_records();
+  {
+    auto decoupled = DecoupledBatch{};
+    auto& batch    = decoupled.batch;
+    batch.get_input_shape<float>("x");
+
+    auto& sender  = batch.get_response_sender();
+    auto streamed = sender.get_output<float>("y", HostMemory, 0, cudaStream_t{});
+    fill_output(streamed);
+    sender.send();
+
+    auto last = batch.get_output<float>("y", {3, 1}, {1, 2}, HostMemory, 0, cudaStream_t{});
+    fill_output(last);
+    batch.finalize(nullptr);
+  }
+
+  ASSERT_EQ(stubs::sent_responses.size(), 4);
+  EXPECT_EQ(stubs::sent_responses[0].flags, 0);
+  EXPECT_EQ(stubs::sent_responses[1].flags, 0);
+  EXPECT_THAT(stubs::sent_responses[1].outputs[0]->shape, ::testing::ElementsAre(2, 1));
+  EXPECT_THAT(stubs::sent_responses[1].outputs[0]->data, ::testing::ElementsAre(1.0f, 2.0f));
+  for (auto i = std::size_t{2}; i < stubs::sent_responses.size(); ++i) {
+    EXPECT_EQ(stubs::sent_responses[i].flags, TRITONSERVER_RESPONSE_COMPLETE_FINAL);
+    EXPECT_FALSE(stubs::sent_responses[i].error);
+    EXPECT_EQ(stubs::sent_responses[i].outputs.size(), 1);
+  }
+  EXPECT_TRUE(stubs::sent_flags.empty());
+  EXPECT_EQ(stubs::released_requests, 2);
+  EXPECT_EQ(stubs::live_factories, 0);
+}
+
+TEST(BackendTools, response_sender_discards_on_error)
+{
+  stubs::reset_triton_records();
+  {
+    auto decoupled = DecoupledBatch{};
+    auto& batch    = decoupled.batch;
+    auto& sender   = batch.get_response_sender();
+    auto streamed  = sender.get_output<float>("y", {3, 1}, {1, 2}, HostMemory, 0, cudaStream_t{});
+    fill_output(streamed);
+
+    auto* err = TritonException(Error::Internal, "predict failed").error();
+    batch.finalize(err, true);
+    TRITONSERVER_ErrorDelete(err);
+  }
+
+  // The unsent streamed responses are deleted, and each request receives an
+  // error in its final response
+  EXPECT_EQ(stubs::deleted_responses, 2);
+  ASSERT_EQ(stubs::sent_responses.size(), 2);
+  for (auto& response : stubs::sent_responses) {
+    EXPECT_EQ(response.flags, TRITONSERVER_RESPONSE_COMPLETE_FINAL);
+    EXPECT_TRUE(response.error);
+    EXPECT_TRUE(response.outputs.empty());
+  }
+  EXPECT_TRUE(stubs::sent_flags.empty());
+  EXPECT_EQ(stubs::released_requests, 2);
+  EXPECT_EQ(stubs::live_factories, 0);
+}
+
+TEST(BackendTools, response_sender_without_outputs_sends_flags)
+{
+  stubs::reset_triton_records();
+  {
+    auto decoupled = DecoupledBatch{};
+    decoupled.batch.finalize(nullptr);
+  }
+
+  // The batch's own empty responses are dropped in favor of the final flag
+  EXPECT_EQ(stubs::deleted_responses, 2);
+  EXPECT_TRUE(stubs::sent_responses.empty());
+  ASSERT_EQ(stubs::sent_flags.size(), 2);
+  EXPECT_EQ(stubs::sent_flags[0].request_id, 0);
+  EXPECT_EQ(stubs::sent_flags[1].request_id, 1);
+  EXPECT_EQ(stubs::sent_flags[0].flags, TRITONSERVER_RESPONSE_COMPLETE_FINAL);
+  EXPECT_EQ(stubs::sent_flags[1].flags, TRITONSERVER_RESPONSE_COMPLETE_FINAL);
+  EXPECT_EQ(stubs::released_requests, 2);
+  EXPECT_EQ(stubs::live_factories, 0);
+}
+
+TEST(BackendTools, response_sender_created_before_inputs)
+{
+  stubs::reset_triton_records();
+  {
+    auto decoupled = DecoupledBatch{};
+    auto& batch    = decoupled.batch;
+    auto& sender   = batch.get_response_sender();
+    EXPECT_THROW(sender.get_output<float>("y", HostMemory, 0, cudaStream_t{}), TritonException);
+
+    // Rows are split using the batch sizes recorded once an input is read
+    batch.get_input_shape<float>("x");
+    auto streamed = sender.get_output<float>("y", HostMemory, 0, cudaStream_t{});
+    EXPECT_THAT(streamed.shape(), ::testing::ElementsAre(3, 1));
+    fill_output(streamed);
+    batch.finalize(nullptr);
+  }
+
+  // Streamed outputs still pending when the batch completes carry the final
+  // flag themselves
+  ASSERT_EQ(stubs::sent_responses.size(), 2);
+  EXPECT_EQ(stubs::sent_responses[0].flags, TRITONSERVER_RESPONSE_COMPLETE_FINAL);
+  EXPECT_THAT(stubs::sent_responses[0].outputs[0]->data, ::testing::ElementsAre(0.0f));
+  EXPECT_THAT(stubs::sent_responses[1].outputs[0]->data, ::testing::ElementsAre(1.0f, 2.0f));
+  EXPECT_EQ(stubs::deleted_responses, 2);
+  EXPECT_TRUE(stubs::sent_flags.empty());
+  EXPECT_EQ(stubs::live_factories, 0);
+}
+
+TEST(BackendTools, response_sender_requires_decoupled_batch)
+{
+  stubs::reset_triton_records();
+  auto requests     = std::vector<TRITONBACKEND_Request>{TRITONBACKEND_Request{0, {{1, 1}}}};
+  auto raw_requests = std::vector<TRITONBACKEND_Request*>{&requests[0]};
+  auto batch        = Batch(
+    raw_requests.data(),
+    1,
+    *reinterpret_cast<TRITONBACKEND_MemoryManager*>(&requests[0]),
+    [](std::string const&, Batch::size_type batch_dim) {
+      return std::vector<Batch::size_type>{batch_dim, 1};
+    },
+    [](TRITONBACKEND_Request*,
+       time_point const&,
+       time_point const&,
+       time_point const&,
+       time_point const&) {},
+    false,
+    false,
+    Batch::size_type{1},
+    cudaStream_t{});
+  EXPECT_THROW(batch.get_response_sender(), TritonException);
+  batch.finalize(nullptr);
+}
+}  // namespace backend
+}  // namespace developer_tools
+}  // namespace triton
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <triton/developer_tools/build_control.hpp>
+#include <triton/developer_tools/exceptions.hpp>
+#include <triton/developer_tools/memory/buffer_pool.hpp>
+#include <triton/developer_tools/memory/types.hpp>
+
+namespace triton {
+namespace developer_tools {
+namespace backend {
+TEST(BackendTools, buffer_pool_size_class)
+{
+  auto pool = BufferPool::create();
+  EXPECT_EQ(pool->size_class(0), 256);
+  EXPECT_EQ(pool->size_class(256), 256);
+  EXPECT_EQ(pool->size_class(257), 512);
+  EXPECT_EQ(pool->size_class(3000), 4096);
+}
+
+TEST(BackendTools, buffer_pool_reuse)
+{
+  auto pool = BufferPool::create();
+
+  auto lease = pool->acquire(1000, HostMemory, 0);
+  ASSERT_NE(lease->data(), nullptr);
+  EXPECT_EQ(lease->bytes(), 1024);
+  EXPECT_EQ(lease->mem_type(), HostMemory);
+  auto* data = lease->data();
+  EXPECT_EQ(pool->cached_bytes(), 0);
+
+  lease.reset();
+  EXPECT_EQ(pool->cached_bytes(), 1024);
+
+  // A request in the same size class reuses the released block
+  lease = pool->acquire(600, HostMemory, 0);
+  EXPECT_EQ(lease->data(), data);
+  EXPECT_EQ(pool->cached_bytes(), 0);
+
+  // A request in another size class does not
+  auto other = pool->acquire(2000, HostMemory, 0);
+  EXPECT_NE(other->data(), data);
+  EXPECT_EQ(other->bytes(), 2048);
+}
+
+TEST(BackendTools, buffer_pool_limit)
+{
+  auto pool = BufferPool::create(1024);
+
+  auto first  = pool->acquire(1024, HostMemory, 0);
+  auto second = pool->acquire(1024, HostMemory, 0);
+  first.reset();
+  second.reset();
+  EXPECT_EQ(pool->cached_bytes(), 1024);
+
+  pool->clear();
+  EXPECT_EQ(pool->cached_bytes(), 0);
+}
+
+TEST(BackendTools, buffer_pool_outlived)
+{
+  auto pool  = BufferPool::create();
+  auto lease = pool->acquire(16, HostMemory, 0);
+  pool.reset();
+  EXPECT_NO_THROW(lease.reset());
+}
+
+TEST(BackendTools, buffer_pool_device)
+{
+#ifdef TRITON_ENABLE_GPU
+  auto pool  = BufferPool::create();
+  auto lease = pool->acquire(1000, DeviceMemory, 0);
+  ASSERT_NE(lease->data(), nullptr);
+  EXPECT_EQ(lease->mem_type(), DeviceMemory);
+#else
+  auto pool = BufferPool::create();
+  EXPECT_THROW(pool->acquire(1000, DeviceMemory, 0), TritonException);
+#endif
+}
+
+}  // namespace backend
+}  // namespace developer_tools
+}  // namespace triton
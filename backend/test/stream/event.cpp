@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <triton/developer_tools/stream/event.hpp>
+#include <triton/developer_tools/stream/stream.hpp>
+#include <triton/developer_tools/stream/stream_pool.hpp>
+
+namespace triton {
+namespace developer_tools {
+namespace backend {
+TEST(BackendTools, event_orders_streams)
+{
+  auto pool     = StreamPool{2};
+  auto producer = pool[0];
+  auto consumer = pool[1];
+
+  auto produced = std::atomic<bool>{false};
+  auto observed = std::atomic<bool>{false};
+  enqueue(producer, [&produced]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    produced = true;
+  });
+  auto ready = Event{};
+  ready.record(producer);
+  ready.wait(consumer);
+  enqueue(consumer, [&produced, &observed]() { observed = produced.load(); });
+
+  stream_synchronize(consumer);
+  EXPECT_TRUE(observed);
+}
+
+TEST(BackendTools, event_synchronize)
+{
+  auto pool = StreamPool{1};
+  auto done = std::atomic<bool>{false};
+  enqueue(pool[0], [&done]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    done = true;
+  });
+  auto event = Event{};
+  event.record(pool[0]);
+  event.synchronize();
+  EXPECT_TRUE(done);
+}
+
+TEST(BackendTools, event_wait_uses_latest_record)
+{
+  auto pool  = StreamPool{2};
+  auto count = std::atomic<int>{0};
+  auto event = Event{};
+
+  enqueue(pool[0], [&count]() { ++count; });
+  event.record(pool[0]);
+  enqueue(pool[0], [&count]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ++count;
+  });
+  event.record(pool[0]);
+
+  auto observed = std::atomic<int>{0};
+  event.wait(pool[1]);
+  enqueue(pool[1], [&count, &observed]() { observed = count.load(); });
+  stream_synchronize(pool[1]);
+  EXPECT_EQ(observed, 2);
+}
+
+}  // namespace backend
+}  // namespace developer_tools
+}  // namespace triton
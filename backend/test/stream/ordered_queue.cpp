@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <triton/developer_tools/stream/ordered_queue.hpp>
+#include <vector>
+
+namespace triton {
+namespace developer_tools {
+namespace backend {
+TEST(BackendTools, ordered_queue_order)
+{
+  auto queue  = OrderedQueue{};
+  auto result = std::vector<int>{};
+  for (auto i = 0; i < 100; ++i) {
+    queue.enqueue([&result, i]() { result.push_back(i); });
+  }
+  queue.synchronize();
+  ASSERT_EQ(result.size(), 100);
+  for (auto i = 0; i < 100; ++i) {
+    EXPECT_EQ(result[i], i);
+  }
+}
+
+TEST(BackendTools, ordered_queue_synchronize_waits)
+{
+  auto queue = OrderedQueue{};
+  auto done  = std::atomic<bool>{false};
+  queue.enqueue([&done]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    done = true;
+  });
+  queue.synchronize();
+  EXPECT_TRUE(done);
+}
+
+TEST(BackendTools, ordered_queue_exception)
+{
+  auto queue = OrderedQueue{};
+  auto ran   = std::atomic<bool>{false};
+  queue.enqueue([]() { throw std::runtime_error("task failed"); });
+  queue.enqueue([&ran]() { ran = true; });
+  EXPECT_THROW(queue.synchronize(), std::runtime_error);
+  // Later tasks still run, and the error is only reported once
+  EXPECT_TRUE(ran);
+  EXPECT_NO_THROW(queue.synchronize());
+}
+
+TEST(BackendTools, ordered_queue_drains_on_destruction)
+{
+  auto count = std::atomic<int>{0};
+  {
+    auto queue = OrderedQueue{};
+    for (auto i = 0; i < 10; ++i) {
+      queue.enqueue([&count]() { ++count; });
+    }
+  }
+  EXPECT_EQ(count, 10);
+}
+
+}  // namespace backend
+}  // namespace developer_tools
+}  // namespace triton
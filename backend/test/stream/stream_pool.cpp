@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <set>
+#include <triton/developer_tools/exceptions.hpp>
+#include <triton/developer_tools/stream/stream.hpp>
+#include <triton/developer_tools/stream/stream_pool.hpp>
+
+namespace triton {
+namespace developer_tools {
+namespace backend {
+TEST(BackendTools, stream_pool_round_robin)
+{
+  auto pool = StreamPool{3};
+  EXPECT_EQ(pool.size(), 3);
+
+  auto distinct = std::set<cudaStream_t>{};
+  for (auto i = 0; i < 3; ++i) {
+    distinct.insert(pool.get());
+  }
+  EXPECT_EQ(distinct.size(), 3);
+  EXPECT_EQ(pool.get(), pool[0]);
+  EXPECT_EQ(pool.get(), pool[1]);
+}
+
+TEST(BackendTools, stream_pool_synchronize)
+{
+  auto pool  = StreamPool{4};
+  auto count = std::atomic<int>{0};
+  for (auto i = 0; i < 40; ++i) {
+    enqueue(pool.get(), [&count]() { ++count; });
+  }
+  pool.synchronize();
+  EXPECT_EQ(count, 40);
+}
+
+TEST(BackendTools, stream_pool_empty)
+{
+  EXPECT_THROW(StreamPool{0}, TritonException);
+}
+
+}  // namespace backend
+}  // namespace developer_tools
+}  // namespace triton
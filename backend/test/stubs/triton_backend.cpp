@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stubs/triton_backend.hpp>
+
+#include <cstdlib>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace triton {
+namespace developer_tools {
+namespace backend {
+namespace stubs {
+
+std::vector<SentResponse> sent_responses{};
+std::vector<SentFlags> sent_flags{};
+int deleted_responses = 0;
+int live_factories    = 0;
+int released_requests = 0;
+
+void reset_triton_records()
+{
+  sent_responses.clear();
+  sent_flags.clear();
+  deleted_responses = 0;
+  live_factories    = 0;
+  released_requests = 0;
+}
+
+}  // namespace stubs
+}  // namespace backend
+}  // namespace developer_tools
+}  // namespace triton
+
+namespace stubs = triton::developer_tools::backend::stubs;
+
+extern "C" {
+TRITONSERVER_Error* TRITONBACKEND_RequestInput(TRITONBACKEND_Request* request,
+                                               const char* name,
+                                               TRITONBACKEND_Input** input)
+{
+  *input = &request->input;
+  return nullptr;
+}
+
+TRITONSERVER_Error* TRITONBACKEND_RequestInputByIndex(TRITONBACKEND_Request* request,
+                                                      const uint32_t index,
+                                                      TRITONBACKEND_Input** input)
+{
+  *input = &request->input;
+  return nullptr;
+}
+
+TRITONSERVER_Error* TRITONBACKEND_RequestOutputCount(TRITONBACKEND_Request* request,
+                                                     uint32_t* count)
+{
+  *count = request->requested_outputs.size();
+  return nullptr;
+}
+
+TRITONSERVER_Error* TRITONBACKEND_RequestOutputName(TRITONBACKEND_Request* request,
+                                                    const uint32_t index,
+                                                    const char** output_name)
+{
+  *output_name = request->requested_outputs[index].c_str();
+  return nullptr;
+}
+
+TRITONSERVER_Error* TRITONBACKEND_InputProperties(TRITONBACKEND_Input* input,
+                                                  const char** name,
+                                                  TRITONSERVER_DataType* datatype,
+                                                  const int64_t** shape,
+                                                  uint32_t* dims_count,
+                                                  uint64_t* byte_size,
+                                                  uint32_t* buffer_count)
+{
+  if (name != nullptr) { *name = "x"; }
+  if (datatype != nullptr) { *datatype = TRITONSERVER_TYPE_FP32; }
+  if (shape != nullptr) { *shape = input->shape.data(); }
+  if (dims_count != nullptr) { *dims_count = input->shape.size(); }
+  if (byte_size != nullptr) { *byte_size = input->data.size() * sizeof(float); }
+  if (buffer_count != nullptr) { *buffer_count = 1; }
+  return nullptr;
+}
+
+TRITONSERVER_Error* TRITONBACKEND_InputPropertiesForHostPolicy(TRITONBACKEND_Input* input,
+                                                               const char* host_policy_name,
+                                                               const char** name,
+                                                               TRITONSERVER_DataType* datatype,
+                                                               const int64_t** shape,
+                                                               uint32_t* dims_count,
+                                                               uint64_t* byte_size,
+                                                               uint32_t* buffer_count)
+{
+  return TRITONBACKEND_InputProperties(
+    input, name, datatype, shape, dims_count, byte_size, buffer_count);
+}
+
+TRITONSERVER_Error* TRITONBACKEND_InputBuffer(TRITONBACKEND_Input* input,
+                                              const uint32_t index,
+                                              const void** buffer,
+                                              uint64_t* buffer_byte_size,
+                                              TRITONSERVER_MemoryType* memory_type,
+                                              int64_t* memory_type_id)
+{
+  *buffer           = input->data.data();
+  *buffer_byte_size = input->data.size() * sizeof(float);
+  *memory_type      = TRITONSERVER_MEMORY_CPU;
+  *memory_type_id   = 0;
+  return nullptr;
+}
+
+TRITONSERVER_Error* TRITONBACKEND_InputBufferForHostPolicy(TRITONBACKEND_Input* input,
+                                                           const char* host_policy_name,
+                                                           const uint32_t index,
+                                                           const void** buffer,
+                                                           uint64_t* buffer_byte_size,
+                                                           TRITONSERVER_MemoryType* memory_type,
+                                                           int64_t* memory_type_id)
+{
+  return TRITONBACKEND_InputBuffer(
+    input, index, buffer, buffer_byte_size, memory_type, memory_type_id);
+}
+
+TRITONSERVER_Error* TRITONBACKEND_MemoryManagerAllocate(TRITONBACKEND_MemoryManager* manager,
+                                                        void** buffer,
+                                                        const TRITONSERVER_MemoryType memory_type,
+                                                        const int64_t memory_type_id,
+                                                        const uint64_t byte_size)
+{
+  *buffer = std::malloc(byte_size);
+  return nullptr;
+}
+
+TRITONSERVER_Error* TRITONBACKEND_MemoryManagerFree(TRITONBACKEND_MemoryManager* manager,
+                                                    void* buffer,
+                                                    const TRITONSERVER_MemoryType memory_type,
+                                                    const int64_t memory_type_id)
+{
+  std::free(buffer);
+  return nullptr;
+}
+
+TRITONSERVER_Error* TRITONBACKEND_RequestRelease(TRITONBACKEND_Request* request,
+                                                 uint32_t release_flags)
+{
+  ++stubs::released_requests;
+  return nullptr;
+}
+
+TRITONSERVER_Error* TRITONBACKEND_ResponseFactoryNew(TRITONBACKEND_ResponseFactory** factory,
+                                                     TRITONBACKEND_Request* request)
+{
+  *factory = new TRITONBACKEND_ResponseFactory{request};
+  ++stubs::live_factories;
+  return nullptr;
+}
+
+TRITONSERVER_Error* TRITONBACKEND_ResponseFactoryDelete(TRITONBACKEND_ResponseFactory* factory)
+{
+  delete factory;
+  --stubs::live_factories;
+  return nullptr;
+}
+
+TRITONSERVER_Error* TRITONBACKEND_ResponseFactorySendFlags(TRITONBACKEND_ResponseFactory* factory,
+                                                           const uint32_t send_flags)
+{
+  stubs::sent_flags.push_back(stubs::SentFlags{factory->request->id, send_flags});
+  return nullptr;
+}
+
+TRITONSERVER_Error* TRITONBACKEND_ResponseNew(TRITONBACKEND_Response** response,
+                                              TRITONBACKEND_Request* request)
+{
+  *response = new TRITONBACKEND_Response{request, {}};
+  return nullptr;
+}
+
+TRITONSERVER_Error* TRITONBACKEND_ResponseNewFromFactory(TRITONBACKEND_Response** response,
+                                                         TRITONBACKEND_ResponseFactory* factory)
+{
+  return TRITONBACKEND_ResponseNew(response, factory->request);
+}
+
+TRITONSERVER_Error* TRITONBACKEND_ResponseDelete(TRITONBACKEND_Response* response)
+{
+  delete response;
+  ++stubs::deleted_responses;
+  return nullptr;
+}
+
+TRITONSERVER_Error* TRITONBACKEND_ResponseOutput(TRITONBACKEND_Response* response,
+                                                 TRITONBACKEND_Output** output,
+                                                 const char* name,
+                                                 const TRITONSERVER_DataType datatype,
+                                                 const int64_t* shape,
+                                                 const uint32_t dims_count)
+{
+  response->outputs.push_back(std::make_unique<TRITONBACKEND_Output>(
+    TRITONBACKEND_Output{name, std::vector<int64_t>(shape, shape + dims_count), {}}));
+  *output = response->outputs.back().get();
+  return nullptr;
+}
+
+TRITONSERVER_Error* TRITONBACKEND_OutputBuffer(TRITONBACKEND_Output* output,
+                                               void** buffer,
+                                               const uint64_t buffer_byte_size,
+                                               TRITONSERVER_MemoryType* memory_type,
+                                               int64_t* memory_type_id)
+{
+  output->data.resize(buffer_byte_size / sizeof(float));
+  *buffer         = output->data.data();
+  *memory_type    = TRITONSERVER_MEMORY_CPU;
+  *memory_type_id = 0;
+  return nullptr;
+}
+
+TRITONSERVER_Error* TRITONBACKEND_ResponseSend(TRITONBACKEND_Response* response,
+                                               const uint32_t send_flags,
+                                               TRITONSERVER_Error* error)
+{
+  stubs::sent_responses.push_back(stubs::SentResponse{
+    response->request->id, send_flags, error != nullptr, std::move(response->outputs)});
+  if (error != nullptr) { TRITONSERVER_ErrorDelete(error); }
+  delete response;
+  return nullptr;
+}
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <triton/core/tritonbackend.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/* Minimal stand-ins for the Triton objects used by the stubbed Triton API in
+ * stubs/triton_backend.cpp, which record what is sent so that tests can check
+ * it. These are only linked into the test_developer_tools_backend_stubs
+ * executable, so that the rest of the tests use the Triton server stub. */
+struct TRITONBACKEND_Input {
+  std::vector<int64_t> shape;
+  std::vector<float> data{};
+};
+struct TRITONBACKEND_Request {
+  int id;
+  TRITONBACKEND_Input input;
+  std::vector<std::string> requested_outputs{};
+};
+struct TRITONBACKEND_ResponseFactory {
+  TRITONBACKEND_Request* request;
+};
+struct TRITONBACKEND_Output {
+  std::string name;
+  std::vector<int64_t> shape;
+  std::vector<float> data;
+};
+struct TRITONBACKEND_Response {
+  TRITONBACKEND_Request* request;
+  std::vector<std::unique_ptr<TRITONBACKEND_Output>> outputs;
+};
+
+namespace triton {
+namespace developer_tools {
+namespace backend {
+namespace stubs {
+
+struct SentResponse {
+  int request_id;
+  uint32_t flags;
+  bool error;
+  std::vector<std::unique_ptr<TRITONBACKEND_Output>> outputs;
+};
+
+struct SentFlags {
+  int request_id;
+  uint32_t flags;
+};
+
+extern std::vector<SentResponse> sent_responses;
+extern std::vector<SentFlags> sent_flags;
+extern int deleted_responses;
+extern int live_factories;
+extern int released_requests;
+
+/* Clear everything recorded by the stubbed Triton API */
+void reset_triton_records();
+
+}  // namespace stubs
+}  // namespace backend
+}  // namespace developer_tools
+}  // namespace triton
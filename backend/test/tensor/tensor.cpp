@@ -22,6 +22,12 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <future>
+#include <memory>
+#include <triton/backend/backend_output_responder.h>
+#include <triton/developer_tools/stream/stream.hpp>
+#include <triton/developer_tools/stream/stream_pool.hpp>
 #include <triton/developer_tools/tensor/dtype.hpp>
 #include <triton/developer_tools/tensor/tensor.hpp>
 #include <vector>
@@ -140,6 +146,132 @@ TEST(BackendTools, tensor_multi_copy)
   EXPECT_THROW(backend::copy(receivers.begin(), receivers.end(), tensor1), TritonException);
 }
 
+TEST(BackendTools, direct_output_tensor)
+{
+  auto shape = std::vector<std::size_t>{3, 2};
+  auto data  = std::vector<int>{1, 2, 3, 4, 5, 6};
+  auto src   = Tensor<int>(shape, Buffer<int>{data.data(), data.size(), HostMemory});
+
+  auto first   = std::vector<int>(2);
+  auto second  = std::vector<int>(4);
+  auto regions = std::vector<Buffer<int>>{};
+  regions.emplace_back(first.data(), first.size(), HostMemory);
+  regions.emplace_back(second.data(), second.size(), HostMemory);
+  auto direct = DirectOutputTensor<int>(
+    std::vector<std::size_t>{shape}, std::move(regions), std::vector<std::size_t>{0, 1});
+
+  EXPECT_EQ(direct.size(), data.size());
+  EXPECT_FALSE(direct.is_contiguous());
+  EXPECT_THAT(direct.row_offsets(), ::testing::ElementsAre(0, 1));
+  EXPECT_THROW(direct.buffer(), TritonException);
+
+  backend::copy(direct, src);
+  direct.finalize();
+  EXPECT_THAT(first, ::testing::ElementsAre(1, 2));
+  EXPECT_THAT(second, ::testing::ElementsAre(3, 4, 5, 6));
+
+  auto single_regions = std::vector<Buffer<int>>{};
+  single_regions.emplace_back(std::size_t{6}, HostMemory);
+  auto single = DirectOutputTensor<int>(
+    std::vector<std::size_t>{shape}, std::move(single_regions), std::vector<std::size_t>{0});
+  EXPECT_TRUE(single.is_contiguous());
+  backend::copy(single, src);
+  auto data_out = std::vector<int>(single.data(), single.data() + single.size());
+  EXPECT_THAT(data_out, ::testing::ElementsAreArray(data));
+}
+
+TEST(BackendTools, direct_output_tensor_from_device)
+{
+  auto shape    = std::vector<std::size_t>{2, 2};
+  auto data     = std::vector<int>{1, 2, 3, 4};
+  auto mem_type = HostMemory;
+  if constexpr (IS_GPU_BUILD) { mem_type = DeviceMemory; }
+  auto stream = cudaStream_t{};
+#ifdef TRITON_ENABLE_GPU
+  cudaStreamCreate(&stream);
+#endif
+
+  auto first  = std::vector<int>(2);
+  auto second = std::vector<int>(2);
+  {
+    auto host_src = Buffer<int>{data.data(), data.size(), HostMemory, 0, stream};
+    auto src      = Tensor<int>(shape, Buffer<int>{host_src, mem_type});
+
+    auto regions = std::vector<Buffer<int>>{};
+    regions.emplace_back(first.data(), first.size(), HostMemory, 0, stream);
+    regions.emplace_back(second.data(), second.size(), HostMemory, 0, stream);
+    auto direct = DirectOutputTensor<int>(
+      std::vector<std::size_t>{shape}, std::move(regions), std::vector<std::size_t>{0, 1});
+
+    backend::copy(direct, src);
+    direct.finalize();
+    EXPECT_THAT(first, ::testing::ElementsAre(1, 2));
+    EXPECT_THAT(second, ::testing::ElementsAre(3, 4));
+  }
+
+#ifdef TRITON_ENABLE_GPU
+  cudaStreamDestroy(stream);
+#endif
+}
+
+TEST(BackendTools, output_tensor_host_syncs)
+{
+  auto pool      = StreamPool{1};
+  auto stream    = pool[0];
+  auto responses = std::vector<TRITONBACKEND_Response*>{};
+  auto responder = std::make_shared<triton::backend::BackendOutputResponder>(
+    nullptr, 0, &responses, 0, nullptr, false, stream);
+
+  // Hold the stream until `fn` has either returned or had the chance to, and
+  // count a synchronization if `fn` was waiting on the stream.
+  auto host_syncs      = 0;
+  auto count_host_sync = [&stream, &host_syncs](auto&& fn) {
+    auto gate = std::promise<void>{};
+    enqueue(stream, [released = gate.get_future().share()]() { released.wait(); });
+    auto result = std::async(std::launch::async, fn);
+    if (result.wait_for(std::chrono::milliseconds(200)) != std::future_status::ready) {
+      ++host_syncs;
+    }
+    gate.set_value();
+    result.get();
+  };
+
+  auto host_output = OutputTensor<float>(std::vector<std::size_t>{2, 2},
+                                         Buffer<float>{4, HostMemory, 0, stream},
+                                         "y",
+                                         responder,
+                                         stream);
+  count_host_sync([&host_output]() { host_output.finalize(); });
+  EXPECT_EQ(host_syncs, 1);
+
+  if constexpr (IS_GPU_BUILD) {
+    auto device_output = OutputTensor<float>(std::vector<std::size_t>{2, 2},
+                                             Buffer<float>{4, DeviceMemory, 0, stream},
+                                             "y",
+                                             responder,
+                                             stream);
+    count_host_sync([&device_output]() { device_output.finalize(); });
+    EXPECT_EQ(host_syncs, 1);
+  }
+}
+
+TEST(BackendTools, ragged_tensor)
+{
+  auto data    = std::vector<int>{1, 2, 3, 4, 5, 6};
+  auto offsets = std::vector<std::int64_t>{0, 1, 6};
+  auto ragged  = RaggedTensor<int>(
+    Buffer<int>{data.data(), data.size(), HostMemory},
+    Buffer<std::int64_t>{offsets.data(), offsets.size(), HostMemory},
+    std::vector<std::vector<std::size_t>>{{1, 1}, {1, 5}});
+
+  EXPECT_EQ(ragged.request_count(), 2);
+  EXPECT_EQ(ragged.values().data(), data.data());
+  EXPECT_EQ(ragged.values().size(), data.size());
+  EXPECT_THAT(ragged.values().shape(), ::testing::ElementsAre(data.size()));
+  EXPECT_EQ(ragged.offsets().data()[1], 1);
+  EXPECT_THAT(ragged.shapes()[1], ::testing::ElementsAre(1, 5));
+}
+
 }  // namespace backend
 }  // namespace developer_tools
 }  // namespace triton
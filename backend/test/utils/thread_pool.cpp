@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <numeric>
+#include <stdexcept>
+#include <triton/developer_tools/utils/thread_pool.hpp>
+#include <vector>
+
+namespace triton {
+namespace developer_tools {
+namespace backend {
+TEST(BackendTools, thread_pool_submit)
+{
+  auto pool  = ThreadPool{4};
+  auto count = std::atomic<int>{0};
+  auto done  = std::promise<void>{};
+  for (auto i = 0; i < 100; ++i) {
+    pool.submit([&count, &done]() {
+      if (++count == 100) { done.set_value(); }
+    });
+  }
+  done.get_future().wait();
+  EXPECT_EQ(count, 100);
+}
+
+TEST(BackendTools, thread_pool_parallel_for)
+{
+  auto pool = ThreadPool{4};
+  auto data = std::vector<int>(10000);
+  pool.parallel_for(0, data.size(), [&data](std::size_t begin, std::size_t end) {
+    for (auto i = begin; i < end; ++i) {
+      data[i] += static_cast<int>(i);
+    }
+  });
+  for (auto i = std::size_t{}; i < data.size(); ++i) {
+    ASSERT_EQ(data[i], static_cast<int>(i));
+  }
+}
+
+TEST(BackendTools, thread_pool_parallel_for_grain)
+{
+  auto pool   = ThreadPool{2};
+  auto chunks = std::atomic<int>{0};
+  pool.parallel_for(
+    3,
+    103,
+    [&chunks](std::size_t begin, std::size_t end) {
+      EXPECT_LE(end - begin, 10);
+      EXPECT_EQ((begin - 3) % 10, 0);
+      ++chunks;
+    },
+    10);
+  EXPECT_EQ(chunks, 10);
+}
+
+TEST(BackendTools, thread_pool_parallel_for_nested)
+{
+  auto pool  = ThreadPool{2};
+  auto count = std::atomic<int>{0};
+  pool.parallel_for(
+    0,
+    8,
+    [&pool, &count](std::size_t begin, std::size_t end) {
+      for (auto i = begin; i < end; ++i) {
+        pool.parallel_for(
+          0,
+          100,
+          [&count](std::size_t inner_begin, std::size_t inner_end) {
+            count += static_cast<int>(inner_end - inner_begin);
+          },
+          10);
+      }
+    },
+    1);
+  EXPECT_EQ(count, 800);
+}
+
+TEST(BackendTools, thread_pool_parallel_for_exception)
+{
+  auto pool = ThreadPool{4};
+  EXPECT_THROW(pool.parallel_for(
+                 0,
+                 100,
+                 [](std::size_t begin, std::size_t end) {
+                   if (begin <= 50 && 50 < end) { throw std::runtime_error("bad index"); }
+                 },
+                 1),
+               std::runtime_error);
+}
+
+TEST(BackendTools, thread_pool_parallel_reduce)
+{
+  auto pool = ThreadPool{4};
+  auto data = std::vector<double>(12345);
+  std::iota(data.begin(), data.end(), 0.0);
+
+  auto sum = pool.parallel_reduce(
+    0,
+    data.size(),
+    0.0,
+    [&data](std::size_t begin, std::size_t end) {
+      return std::accumulate(data.begin() + begin, data.begin() + end, 0.0);
+    },
+    [](double lhs, double rhs) { return lhs + rhs; });
+  EXPECT_EQ(sum, 12344.0 * 12345.0 / 2.0);
+
+  auto empty = pool.parallel_reduce(
+    5,
+    5,
+    7,
+    [](std::size_t, std::size_t) { return 1; },
+    [](int lhs, int rhs) { return lhs + rhs; });
+  EXPECT_EQ(empty, 7);
+}
+
+TEST(BackendTools, thread_pool_global)
+{
+  setup_thread_pool(3);
+  auto pool = get_thread_pool();
+  EXPECT_EQ(pool->size(), 3);
+  EXPECT_EQ(get_thread_pool(), pool);
+}
+
+}  // namespace backend
+}  // namespace developer_tools
+}  // namespace triton
@@ -59,11 +59,13 @@ RET=0
 set +e
 # Must explicitly set LD_LIBRARY_PATH so that the test can find
 # libtritonserver.so.
-LD_LIBRARY_PATH=/opt/tritonserver/lib:${LD_LIBRARY_PATH} ./build/test_developer_tools_backend >> ${TEST_LOG} 2>&1
-if [ $? -ne 0 ]; then
-    cat ${TEST_LOG}
-    RET=1
-fi
+for TEST in test_developer_tools_backend test_developer_tools_backend_stubs; do
+    LD_LIBRARY_PATH=/opt/tritonserver/lib:${LD_LIBRARY_PATH} ./build/${TEST} >> ${TEST_LOG} 2>&1
+    if [ $? -ne 0 ]; then
+        cat ${TEST_LOG}
+        RET=1
+    fi
+done
 set -e
 
 if [ $RET -eq 0 ]; then
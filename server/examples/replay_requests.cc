@@ -0,0 +1,130 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <unistd.h>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "triton/developer_tools/server_wrapper.h"
+
+namespace tds = triton::developer_tools::server;
+
+namespace {
+
+void
+Usage(char** argv, const std::string& msg = std::string())
+{
+  if (!msg.empty()) {
+    std::cerr << msg << std::endl;
+  }
+
+  std::cerr << "Usage: " << argv[0] << " -l <request log> [options]"
+            << std::endl;
+  std::cerr << "\t-l <path> The request log written by"
+            << " 'TritonServer::StartRecording'." << std::endl;
+  std::cerr << "\t-r <path> The model repository. Default is './models'."
+            << std::endl;
+  std::cerr << "\t-f Send the requests as fast as possible instead of"
+            << " preserving the recorded inter-arrival times." << std::endl;
+  std::cerr << "\t-c <count> The maximum number of requests inflight with -f."
+            << " Default is 16." << std::endl;
+  std::cerr << "\t-v Enable verbose logging" << std::endl;
+
+  exit(1);
+}
+
+double
+ToMs(const uint64_t ns)
+{
+  return ns / 1e6;
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  int verbose_level = 0;
+  std::string log_path;
+  std::string model_repository = "./models";
+  tds::ReplayOptions replay_options;
+
+  // Parse commandline...
+  int opt;
+  while ((opt = getopt(argc, argv, "vfl:r:c:")) != -1) {
+    switch (opt) {
+      case 'l':
+        log_path = optarg;
+        break;
+      case 'r':
+        model_repository = optarg;
+        break;
+      case 'f':
+        replay_options.preserve_timing_ = false;
+        break;
+      case 'c':
+        replay_options.max_inflight_ = std::atoi(optarg);
+        break;
+      case 'v':
+        verbose_level = 1;
+        break;
+      case '?':
+        Usage(argv);
+        break;
+    }
+  }
+  if (log_path.empty()) {
+    Usage(argv, "-l must be used to specify the request log");
+  }
+
+  try {
+    tds::ServerOptions options({model_repository});
+    options.logging_.verbose_ =
+        tds::LoggingOptions::VerboseLevel(verbose_level);
+    auto server = tds::TritonServer::Create(options);
+
+    // Read the whole log before starting so that reading the file does not
+    // affect the timing of the replay.
+    auto replayer = tds::RequestReplayer::Create(log_path);
+    std::cout << "Replaying " << replayer->RequestCount() << " requests from "
+              << log_path << std::endl;
+
+    tds::ReplayStats stats = replayer->Run(*server, replay_options);
+    std::cout << "Requests: " << stats.requests_ << " (" << stats.failed_
+              << " failed) in " << ToMs(stats.elapsed_ns_) << " ms"
+              << std::endl;
+    std::cout << "Latency (ms): mean " << ToMs(stats.mean_ns_) << ", p50 "
+              << ToMs(stats.p50_ns_) << ", p90 " << ToMs(stats.p90_ns_)
+              << ", p99 " << ToMs(stats.p99_ns_) << ", max "
+              << ToMs(stats.max_ns_) << std::endl;
+  }
+  catch (const tds::TritonException& ex) {
+    std::cerr << "Error: " << ex.what();
+    exit(1);
+  }
+
+  return 0;
+}
@@ -25,16 +25,27 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <atomic>
 #include <climits>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <future>
 #include <iostream>
+#include <iterator>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <unordered_map>
 #include <vector>
+#include "../src/allocation_tracker.h"
 #include "../src/infer_requested_output.h"
+#include "../src/mapped_file.h"
+#include "../src/request_recorder.h"
+#include "../src/residency_manager.h"
+#include "../src/slot_list.h"
 #include "../src/tracer.h"
 #include "common.h"
 #include "triton/core/tritonserver.h"
@@ -42,17 +53,25 @@
 #include <cuda_runtime_api.h>
 #endif  // TRITON_ENABLE_GPU
 
+struct DLManagedTensor;
+
 namespace triton { namespace developer_tools { namespace server {
 
 class Allocator;
+class BulkInferenceSource;
 class InferResult;
+class RequestReplayer;
 class InferRequest;
+class Pipeline;
+class ResponseStream;
+class ShardedServer;
 struct ResponseParameters;
 class TraceManager;
 
 using TensorAllocMap = std::unordered_map<
     std::string,
     std::tuple<const void*, size_t, TRITONSERVER_MemoryType, int64_t>>;
+using BufferOwnerMap = std::unordered_map<std::string, std::shared_ptr<void>>;
 
 //==============================================================================
 /// Structure to hold logging options for setting 'ServerOptions'.
@@ -105,6 +124,9 @@ struct MetricsOptions {
   bool allow_cpu_metrics_;
   // The interval for metrics collection. Default is 2000.
   uint64_t metrics_interval_ms_;
+  // Enable or disable the custom metrics of the output buffers allocated by
+  // the wrapper, see 'TritonServer::AllocationStatistics'. Default is false.
+  bool allow_allocation_metrics_;
 };
 
 //==============================================================================
@@ -240,6 +262,40 @@ struct Trace {
   uint32_t log_frequency_;
 };
 
+//==============================================================================
+/// Structure to hold the model residency setting for 'ServerOptions'. When
+/// set, models are loaded on demand when 'TritonServer::AsyncInfer' targets a
+/// model that is not loaded, and the least recently used models without
+/// inflight requests are unloaded when the memory budget is exceeded. This
+/// setting is only available in "EXPLICIT" model control mode.
+///
+struct ModelResidency {
+  ModelResidency(
+      const uint64_t host_budget_byte_size,
+      const uint64_t device_budget_byte_size);
+
+  ModelResidency(
+      const uint64_t host_budget_byte_size,
+      const uint64_t device_budget_byte_size,
+      const std::unordered_map<std::string, uint64_t>& host_byte_sizes,
+      const std::unordered_map<std::string, uint64_t>& device_byte_sizes);
+
+  // The host memory budget for the loaded models in bytes. "0" means no
+  // limit.
+  uint64_t host_budget_byte_size_;
+  // The device memory budget for the loaded models in bytes, summed over all
+  // GPUs. "0" means no limit.
+  uint64_t device_budget_byte_size_;
+  // The estimated host memory usage of each model in bytes. For models
+  // without an estimate, the growth of the process resident memory observed
+  // while loading the model is used. Default is empty.
+  std::unordered_map<std::string, uint64_t> host_byte_sizes_;
+  // The estimated device memory usage of each model in bytes. For models
+  // without an estimate, the growth of the used device memory observed while
+  // loading the model is used. Default is empty.
+  std::unordered_map<std::string, uint64_t> device_byte_sizes_;
+};
+
 //==============================================================================
 /// Server options that are used to initialize Triton Server.
 ///
@@ -354,6 +410,10 @@ struct ServerOptions {
   // The global trace setting. Default is nullptr, meaning that tracing is not
   // enabled. See the 'Trace' structure for more information.
   std::shared_ptr<Trace> trace_;
+  // The model residency setting. Default is nullptr, meaning that models are
+  // only loaded and unloaded explicitly. See the 'ModelResidency' structure for
+  // more information.
+  std::shared_ptr<ModelResidency> model_residency_;
 };
 
 //==============================================================================
@@ -399,6 +459,43 @@ struct Tensor {
 
   ~Tensor();
 
+  /// Create a 'Tensor' object from a DLPack tensor without copying the data.
+  /// The returned object, and all the copies of it such as the ones added to
+  /// an inference request, share the ownership of 'dl_tensor'. The deleter of
+  /// 'dl_tensor' is called once the last of them is destroyed. Only compact
+  /// row-major tensors on CPU, CUDA host or CUDA devices are supported.
+  /// \param dl_tensor The DLPack tensor to be used. If an exception is
+  /// thrown, the ownership of 'dl_tensor' remains with the caller.
+  /// \return Returns a 'Tensor' object that refers to the data of
+  /// 'dl_tensor'.
+  static Tensor FromDLPack(DLManagedTensor* dl_tensor);
+
+  /// Create a 'Tensor' object whose buffer is a read-only memory mapping of a
+  /// region of a raw binary file, so the data is read from the page cache
+  /// without being copied. The mapping is advised for sequential access and
+  /// is released once the returned object and all the copies of it are
+  /// destroyed.
+  /// \param path The path to the file.
+  /// \param data_type The data type of the tensor. 'BYTES' is not supported.
+  /// \param shape The shape of the tensor. The region of the file has the
+  /// byte size of the tensor.
+  /// \param offset The offset of the region in bytes. Default is 0.
+  /// \return Returns a 'Tensor' object in CPU memory that refers to the
+  /// mapped region.
+  static Tensor FromFile(
+      const std::string& path, const DataType& data_type,
+      const std::vector<int64_t>& shape, const size_t offset = 0);
+
+  /// Create a 'Tensor' object whose buffer is a read-only memory mapping of
+  /// the data of a NumPy '.npy' file. The data type and the shape are read
+  /// from the header of the file. Only C-ordered arrays of numeric and
+  /// boolean types are supported. See 'FromFile' for the lifetime of the
+  /// mapping.
+  /// \param path The path to the file.
+  /// \return Returns a 'Tensor' object in CPU memory that refers to the
+  /// mapped data.
+  static Tensor FromNpyFile(const std::string& path);
+
   // The pointer to the start of the buffer.
   char* buffer_;
   // The size of buffer in bytes.
@@ -415,6 +512,11 @@ struct Tensor {
   int64_t memory_type_id_;
 
   friend class InternalResult;
+  friend class Pipeline;
+  friend class BulkInferenceSource;
+  friend class InferRequest;
+  friend class OutputBufferRing;
+  friend class PinnedInputArena;
 
  private:
   // Store the custom allocator object in case we need to use it to release
@@ -424,6 +526,11 @@ struct Tensor {
   bool is_pre_alloc_;
   // Indicate if thie tensor is an output from inference.
   bool is_output_;
+  // The object that owns the buffer, such as the DLPack tensor passed to
+  // 'FromDLPack', the file mapped by 'FromFile' or the output of a previous
+  // pipeline stage. It is kept alive as long as the tensor or any copy of it
+  // exists.
+  std::shared_ptr<void> buffer_owner_;
 };
 
 //==============================================================================
@@ -449,6 +556,121 @@ struct NewModelRepo {
   std::string override_name_;
 };
 
+//==============================================================================
+/// Structure to hold warm-up options for a model. This object is used for
+/// calling 'TritonServer::WarmupModel' or 'TritonServer::LoadModel' to run
+/// warm-up inferences before the model is reported as ready.
+///
+struct WarmupOptions {
+  WarmupOptions();
+
+  WarmupOptions(
+      const int64_t model_version, const std::vector<int64_t>& batch_sizes,
+      const uint32_t iterations,
+      const std::unordered_map<std::string, std::shared_ptr<Tensor>>&
+          samples);
+
+  // The version of the model to warm up. The default value is "-1" which
+  // means the server will select the version of the model based on its
+  // internal policy.
+  int64_t model_version_;
+  // The batch sizes to run warm-up inferences with. Batch sizes larger than
+  // the 'max_batch_size' of the model are ignored. If empty, the powers of two
+  // up to and including 'max_batch_size' are used. For models that do not
+  // support batching, a single pass without batch dimension is run. Default is
+  // empty.
+  std::vector<int64_t> batch_sizes_;
+  // The number of warm-up inferences to run for each batch size. Default is 5.
+  uint32_t iterations_;
+  // User-provided sample input tensors, keyed by input name. Each sample must
+  // hold the input of a batch of size 1 in CPU memory and is repeated to fill
+  // larger batches. Inputs without a sample are synthesized as zero-filled
+  // tensors from the shape and datatype reported in the model metadata.
+  // Variable-size dimensions are set to 1. Default is empty.
+  std::unordered_map<std::string, std::shared_ptr<Tensor>> samples_;
+};
+
+//==============================================================================
+/// Structure to hold the warm-up latency of a model for one batch size. A
+/// vector of this object is returned by calling 'TritonServer::WarmupModel'.
+///
+struct WarmupStats {
+  WarmupStats(const int64_t batch_size);
+
+  // The batch size of the warm-up inferences. The value is "0" for models that
+  // do not support batching.
+  int64_t batch_size_;
+  // The number of warm-up inferences run with this batch size.
+  uint32_t count_;
+  // The latency of the first warm-up inference in nanoseconds. This is usually
+  // the one paying for lazy initialization in the backend.
+  uint64_t first_ns_;
+  // The minimum latency of the warm-up inferences in nanoseconds.
+  uint64_t min_ns_;
+  // The maximum latency of the warm-up inferences in nanoseconds.
+  uint64_t max_ns_;
+  // The total latency of the warm-up inferences in nanoseconds.
+  uint64_t total_ns_;
+};
+
+//==============================================================================
+/// Structure to hold the statistics of on-demand model loading. This object is
+/// returned by calling 'TritonServer::ModelResidencyStatistics'.
+///
+struct ModelResidencyStats {
+  ModelResidencyStats();
+
+  // The number of requests targeting a model that was already loaded.
+  uint64_t hits_;
+  // The number of requests queued behind the load of their model.
+  uint64_t load_stalls_;
+  // The number of models loaded on demand.
+  uint64_t loads_;
+  // The number of failed on-demand model loads.
+  uint64_t load_failures_;
+  // The number of models unloaded to stay within the memory budget.
+  uint64_t evictions_;
+  // The total time spent loading models on demand in nanoseconds.
+  uint64_t load_ns_;
+  // The number of models currently tracked as loaded.
+  uint64_t resident_models_;
+  // The estimated host memory usage of the loaded models in bytes.
+  uint64_t resident_host_byte_size_;
+  // The estimated device memory usage of the loaded models in bytes.
+  uint64_t resident_device_byte_size_;
+};
+
+//==============================================================================
+/// Structure to hold the accounting of the output buffers allocated by the
+/// default allocator of the wrapper for a model in a memory type. A vector of
+/// this object is returned by calling 'TritonServer::AllocationStatistics'.
+///
+struct AllocationStats {
+  AllocationStats();
+
+  // The name of the model the outputs were allocated for.
+  std::string model_name_;
+  // The memory type of the output buffers.
+  MemoryType memory_type_;
+  // The bytes of the output buffers held by results that are not destroyed
+  // yet.
+  uint64_t live_byte_size_;
+  // The maximum of 'live_byte_size_' since the server was created.
+  uint64_t peak_byte_size_;
+  // The number of output buffers allocated.
+  uint64_t allocation_count_;
+  // The total bytes of the output buffers allocated.
+  uint64_t allocated_byte_size_;
+  // The number of output buffers allocated per second since the server was
+  // created.
+  double allocations_per_sec_;
+  // The histogram of the byte sizes of the output buffers. Bucket 0 counts
+  // the buffers of at most 1 KiB, bucket 'i' the ones of at most 1 KiB << i
+  // bytes that are larger than the previous bucket, and the last bucket all
+  // the larger buffers.
+  std::vector<uint64_t> size_histogram_;
+};
+
 //==============================================================================
 /// Object that encapsulates in-process C API functionalities.
 ///
@@ -464,11 +686,54 @@ class TritonServer {
   /// \param model_name The name of the model.
   void LoadModel(const std::string& model_name);
 
+  /// Load the requested model and run warm-up inferences on it. The model is
+  /// not reported as ready by 'IsModelReady' and 'LoadedModels' until the
+  /// warm-up is completed.
+  /// \param model_name The name of the model.
+  /// \param warmup_options The 'WarmupOptions' object contains the settings
+  /// of the warm-up inferences.
+  /// \return Returns a vector of 'WarmupStats' object representing the warm-up
+  /// latency per batch size.
+  std::vector<WarmupStats> LoadModel(
+      const std::string& model_name, const WarmupOptions& warmup_options);
+
+  /// Run warm-up inferences on a loaded model. The inputs are taken from the
+  /// samples in 'warmup_options' or synthesized from the model metadata. The
+  /// model is not reported as ready by 'IsModelReady' and 'LoadedModels'
+  /// while the warm-up is running.
+  /// \param model_name The name of the model.
+  /// \param warmup_options The 'WarmupOptions' object contains the settings
+  /// of the warm-up inferences. This field is optional.
+  /// \return Returns a vector of 'WarmupStats' object representing the warm-up
+  /// latency per batch size.
+  std::vector<WarmupStats> WarmupModel(
+      const std::string& model_name,
+      const WarmupOptions& warmup_options = WarmupOptions());
+
+  /// Get the warm-up latency recorded by the last warm-up of a model.
+  /// \param model_name The name of the model.
+  /// \return Returns a vector of 'WarmupStats' object representing the warm-up
+  /// latency per batch size. Empty if the model has not been warmed up.
+  std::vector<WarmupStats> WarmupStatistics(const std::string& model_name);
+
   /// Unload the requested model. Unloading a model that is not loaded
   /// on server has no affect.
   /// \param model_name The name of the model.
   void UnloadModel(const std::string& model_name);
 
+  /// Get the statistics of on-demand model loading. Only available if
+  /// 'model_residency_' is set in 'ServerOptions'.
+  /// \return Returns a 'ModelResidencyStats' object representing the
+  /// statistics.
+  ModelResidencyStats ModelResidencyStatistics();
+
+  /// Get the accounting of the output buffers allocated by the default
+  /// allocator, per model and memory type. Outputs written to pre-allocated
+  /// buffers or allocated by a custom allocator are not accounted.
+  /// \return Returns a vector of 'AllocationStats' object, one per model and
+  /// memory type that outputs were allocated for.
+  std::vector<AllocationStats> AllocationStatistics();
+
   /// Get the set of names of models that are loaded and ready for inference.
   /// \return Returns the set of names of models that are
   /// loaded and ready for inference.
@@ -498,6 +763,21 @@ class TritonServer {
   virtual std::future<std::unique_ptr<InferResult>> AsyncInfer(
       InferRequest& infer_request) = 0;
 
+  /// Run asynchronous inference on server and stream the responses. This is
+  /// the preferred way to retrieve the responses of a decoupled model, as the
+  /// responses are passed through a bounded queue instead of a chain of
+  /// futures.
+  /// \param infer_request The InferRequest object contains
+  /// the inputs, outputs and infer options for an inference request. The
+  /// object must not be destroyed or reused until the stream is finished.
+  /// \param capacity The maximum number of responses buffered in the stream.
+  /// The server is blocked from sending more responses while the stream is
+  /// full. Default is 1024.
+  /// \return Returns a 'ResponseStream' object for retrieving the responses.
+  /// The stream is cancelled once all the references to it are released.
+  virtual std::shared_ptr<ResponseStream> InferStream(
+      InferRequest& infer_request, const size_t capacity = 1024) = 0;
+
   /// Is the server live?
   /// \return Returns true if server is live, false otherwise.
   bool IsServerLive();
@@ -553,7 +833,31 @@ class TritonServer {
   /// \param repo_path The full path to the model repository.
   void UnregisterModelRepo(const std::string& repo_path);
 
+  /// Start recording the requests sent by 'AsyncInfer' to a request log. The
+  /// options, the input tensors and the arrival time of the sampled requests
+  /// are recorded, so that they can be replayed by 'RequestReplayer'. Only
+  /// requests whose inputs are in CPU memory are recorded. Any previous
+  /// recording is stopped.
+  /// \param path The path to the request log. The file is truncated if it
+  /// exists.
+  /// \param rate One out of every 'rate' requests is recorded. Default is 1,
+  /// which records every request.
+  void StartRecording(const std::string& path, const uint32_t rate = 1);
+
+  /// Stop recording the requests. The request log is closed once the
+  /// requests being recorded are written.
+  void StopRecording();
+
+  friend class Pipeline;
+  friend class ShardedServer;
+  friend class RequestReplayer;
+
  protected:
+  // Send the inference request to the server. The result is delivered
+  // through the promise, the response stream or the completion callback set
+  // in 'infer_request'.
+  virtual void StartInfer(InferRequest& infer_request) = 0;
+
   void PrepareInferenceRequest(
       TRITONSERVER_InferenceRequest** irequest, const InferRequest& request);
 
@@ -567,12 +871,45 @@ class TritonServer {
       TRITONSERVER_InferenceRequest** irequest,
       const InferRequest& infer_request);
 
+  // Write 'infer_request' to the request log if recording is started and the
+  // request is sampled.
+  void RecordRequest(const InferRequest& infer_request);
+
   // The server object.
   std::shared_ptr<TRITONSERVER_Server> server_;
   // The allocator object allocating output tensor.
   TRITONSERVER_ResponseAllocator* allocator_;
   // The trace manager.
   std::shared_ptr<TraceManager> trace_manager_;
+  // The mutex protecting the warm-up state below.
+  std::mutex warmup_mu_;
+  // The names of the models that are being warmed up, once per warm-up in
+  // progress.
+  std::multiset<std::string> warming_up_models_;
+  // The warm-up latency recorded by the last warm-up of each model.
+  std::unordered_map<std::string, std::vector<WarmupStats>> warmup_stats_;
+  // The manager loading models on demand. nullptr if model residency is not
+  // enabled.
+  std::shared_ptr<ResidencyManager> residency_manager_;
+  // The recorder of the requests. nullptr if recording is not started. Only
+  // accessed through the atomic functions of 'std::shared_ptr'.
+  std::shared_ptr<RequestRecorder> recorder_;
+  // The accounting of the output buffers allocated by the default allocator.
+  std::shared_ptr<AllocationTracker> allocation_tracker_;
+};
+
+//==============================================================================
+/// Structure to hold the preferred placement of an output tensor.
+///
+struct OutputPlacement {
+  OutputPlacement(
+      const MemoryType& memory_type, const int64_t memory_type_id = 0);
+
+  // The memory type of the output. 'CPU_PINNED' requests pinned host memory.
+  MemoryType memory_type_;
+  // The ID of the memory for the output. (e.g. '0' is the memory type id of
+  // 'GPU-0')
+  int64_t memory_type_id_;
 };
 
 //==============================================================================
@@ -640,6 +977,13 @@ struct InferOptions {
   // trace setting in 'ServerOptions' for tracing if tracing is enabled in
   // 'ServerOptions'. Default is nullptr.
   std::shared_ptr<Trace> trace_;
+  // The preferred placement of the outputs, keyed by output name. The
+  // placement is reported to the backends before they produce the outputs,
+  // so that they can write directly into the memory the consumer wants. An
+  // output without an entry keeps the placement preferred by the backend.
+  // Ignored if 'custom_allocator_' is set or for outputs with a
+  // pre-allocated buffer. Default is empty.
+  std::unordered_map<std::string, OutputPlacement> output_placements_;
 };
 
 //==============================================================================
@@ -660,6 +1004,17 @@ class InferRequest {
   /// \param input A Tensor object that describes an input tensor.
   void AddInput(const std::string& name, const Tensor& input) noexcept;
 
+  /// Add an input tensor to be sent within an InferRequest object by moving
+  /// the shape of 'input' into the request instead of copying it. 'input' is
+  /// left with the storage of the shape previously held by the request, so
+  /// that a caller reusing the same 'Tensor' objects for every request does
+  /// not allocate, and with a null buffer. The buffer of an output moved in
+  /// this way is released by the request. The same lifetime requirements as
+  /// the other 'AddInput' functions apply to the input data buffer.
+  /// \param name The name of the input tensor.
+  /// \param input A Tensor object that describes an input tensor.
+  void AddInput(const std::string& name, Tensor&& input) noexcept;
+
   /// Add an input tensor to be sent within an InferRequest object. This
   /// function is for containers holding 'non-string' data elements. Data in the
   /// container should be contiguous, and the the container must not be modified
@@ -709,7 +1064,9 @@ class InferRequest {
   /// Calling this function is optional. If no output(s) are specifically
   /// requested then all outputs defined by the model will be calculated and
   /// returned. Pre-allocated buffer for each output should be specified within
-  /// the 'Tensor' object.
+  /// the 'Tensor' object. The byte size of the buffer is a capacity, the
+  /// actual byte size of the output is reported by the output tensor returned
+  /// in the result.
   /// \param name The name of the output tensor.
   /// \param output A Tensor object that describes an output tensor containing
   /// its pre-allocated buffer.
@@ -723,23 +1080,44 @@ class InferRequest {
   void AddRequestedOutput(const std::string& name);
 
   /// Clear inputs and outputs of the request. This allows users to reuse the
-  /// InferRequest object if needed.
+  /// InferRequest object if needed. The storage of the inputs and the outputs
+  /// is kept, so that building a request with the same inputs and outputs as
+  /// a previous one does not allocate.
   void Reset();
 
   friend class TritonServer;
   friend class InternalServer;
+  friend class SequenceStream;
+  friend class Pipeline;
+  friend class ShardedServer;
+  friend class RequestReplayer;
+  friend class PinnedInputArena;
 
  protected:
   InferRequest();
 
   std::unique_ptr<InferOptions> infer_options_;
   std::list<std::string> str_bufs_;
-  std::unordered_map<std::string, std::unique_ptr<Tensor>> inputs_;
-  std::vector<std::unique_ptr<InferRequestedOutput>> outputs_;
+  // The number of 'str_bufs_' used by the current inputs. The others are
+  // kept to be reused after 'Reset'.
+  size_t str_buf_count_;
+  SlotList<Tensor> inputs_;
+  SlotList<InferRequestedOutput> outputs_;
 
   // The map for each output tensor and a tuple of it's pre-allocated buffer,
   // byte size, memory type and memory type id.
   TensorAllocMap tensor_alloc_map_;
+  // The owners of the pre-allocated output buffers, such as the buffers
+  // acquired from an 'OutputBufferRing'. The output tensors in the results
+  // share the ownership.
+  BufferOwnerMap buffer_owners_;
+  // The owners of the input buffers that are released as soon as the server
+  // releases the request, such as the buffers of a 'PinnedInputArena'. The
+  // ownership is passed to the server when the request is sent.
+  std::vector<std::shared_ptr<void>> input_release_owners_;
+  // The accounting of the output buffers of the server the request is sent
+  // to.
+  std::shared_ptr<AllocationTracker> allocation_tracker_;
   // The updated trace setting for the specified model set within
   // 'InferOptions'. If set, the lifetime of this 'TraceManager::Trace' object
   // should be long enough until the trace associated with this request is
@@ -752,6 +1130,14 @@ class InferRequest {
   bool is_decoupled_;
   // The promise object used for setting value to the result future.
   std::unique_ptr<std::promise<std::unique_ptr<InferResult>>> prev_promise_;
+  // The stream receiving the responses if the request is sent by
+  // 'TritonServer::InferStream'. nullptr if the results are returned through
+  // 'prev_promise_'.
+  std::shared_ptr<ResponseStream> response_stream_;
+  // The callback receiving the result if the request is sent by a 'Pipeline'.
+  // The callback is called once, on the thread completing the request, and
+  // takes precedence over 'prev_promise_'.
+  std::function<void(std::unique_ptr<InferResult>&&)> completion_fn_;
 };
 
 //==============================================================================
@@ -785,6 +1171,16 @@ class InferResult {
   /// \return Returns the output result as a shared pointer of 'Tensor' object.
   std::shared_ptr<Tensor> Output(const std::string& name);
 
+  /// Get the result output as a DLPack tensor without copying the data. The
+  /// returned DLPack tensor holds a reference to the output, so the output
+  /// buffer stays valid after this 'InferResult' object is destroyed and is
+  /// released when the deleter of the DLPack tensor is called. 'BYTES'
+  /// outputs are not supported.
+  /// \param name The name of the output tensor to be retrieved.
+  /// \return Returns the output result as a DLPack tensor. The caller takes
+  /// the ownership of it.
+  DLManagedTensor* OutputAsDLPack(const std::string& name);
+
   /// Get the result data as a vector of strings. The vector will
   /// receive a copy of result data. An exception will be thrown if
   /// the data type of output is not 'BYTES'.
@@ -829,6 +1225,81 @@ class InferResult {
   TRITONSERVER_InferenceResponse* completed_response_;
 };
 
+//==============================================================================
+/// Object to retrieve the responses of an inference request sent by
+/// 'TritonServer::InferStream'. The responses are passed from the server
+/// through a bounded single-producer single-consumer ring, so retrieving a
+/// response that is already available does not take any lock. The functions
+/// of this object must be called from a single thread.
+///
+class ResponseStream {
+ public:
+  ~ResponseStream();
+
+  /// Get the next response, blocking until it is available.
+  /// \return Returns the next response, or nullptr if all the responses have
+  /// been retrieved.
+  std::unique_ptr<InferResult> Next();
+
+  /// Get the next response if it is available without blocking.
+  /// \param result Returns the next response if available.
+  /// \return Returns true if a response is returned, false otherwise.
+  bool TryNext(std::unique_ptr<InferResult>* result);
+
+  /// Get all the responses that are available without blocking.
+  /// \param results The vector the available responses are appended to.
+  /// \param max_count The maximum number of responses to retrieve. Default is
+  /// 0 which means no limit.
+  /// \return Returns the number of responses appended to 'results'.
+  size_t Drain(
+      std::vector<std::unique_ptr<InferResult>>* results,
+      const size_t max_count = 0);
+
+  /// Whether all the responses have been retrieved.
+  /// \return Returns true if the final response has been received and there
+  /// is no response left to retrieve, false otherwise.
+  bool IsFinished();
+
+  /// Stop retrieving the responses. The responses not yet retrieved and the
+  /// ones sent by the server afterwards are released, so the server is no
+  /// longer blocked by a full stream. 'Next' returns nullptr once the stream
+  /// is cancelled. Releasing all the references to the stream also cancels
+  /// it.
+  void Cancel();
+
+  friend class InternalServer;
+
+ private:
+  ResponseStream(const size_t capacity);
+
+  // Called by the server for each response. Blocks while the ring is full,
+  // unless the stream is cancelled, in which case the response is released.
+  void Push(std::unique_ptr<InferResult>&& result);
+  // Called by the server after the final response.
+  void Finish();
+
+  // The ring of responses. The capacity is a power of two.
+  std::vector<std::unique_ptr<InferResult>> ring_;
+  const size_t mask_;
+  // The index of the next response to retrieve, only written by the consumer.
+  // The indices are padded apart so that the producer and the consumer do not
+  // contend on the same cache line.
+  std::atomic<size_t> head_;
+  char head_padding_[64 - sizeof(std::atomic<size_t>)];
+  // The index of the next response to push, only written by the producer.
+  std::atomic<size_t> tail_;
+  char tail_padding_[64 - sizeof(std::atomic<size_t>)];
+  std::atomic<bool> finished_;
+  std::atomic<bool> cancelled_;
+
+  // Used only when the consumer waits on an empty ring or the producer waits
+  // on a full ring.
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::atomic<bool> consumer_waiting_;
+  std::atomic<bool> producer_waiting_;
+};
+
 //==============================================================================
 /// Custom Allocator object for providing custom functions for allocator.
 /// If there is no custom allocator provided, will use the default allocator.
@@ -888,16 +1359,736 @@ class Allocator {
   {
   }
 
+  virtual ~Allocator() = default;
+
   ResponseAllocatorAllocFn_t AllocFn() { return alloc_fn_; }
   OutputBufferReleaseFn_t ReleaseFn() { return release_fn_; }
   ResponseAllocatorStartFn_t StartFn() { return start_fn_; }
 
+  /// Allocate a buffer for an output tensor. The parameters are the same as
+  /// 'ResponseAllocatorAllocFn_t'. The default implementation calls
+  /// 'AllocFn()', allocator presets override it.
+  virtual void Allocate(
+      const char* tensor_name, size_t byte_size,
+      MemoryType preferred_memory_type, int64_t preferred_memory_type_id,
+      void** buffer, MemoryType* actual_memory_type,
+      int64_t* actual_memory_type_id);
+
+  /// Release a buffer allocated by 'Allocate'. The parameters are the same as
+  /// 'OutputBufferReleaseFn_t'. The default implementation calls
+  /// 'ReleaseFn()', allocator presets override it.
+  virtual void Release(
+      void* buffer, size_t byte_size, MemoryType memory_type,
+      int64_t memory_type_id);
+
  private:
   ResponseAllocatorAllocFn_t alloc_fn_;
   OutputBufferReleaseFn_t release_fn_;
   ResponseAllocatorStartFn_t start_fn_;
 };
 
+//==============================================================================
+/// Allocator preset that writes the outputs into a memory-mapped file, so the
+/// results of bulk inference go to the page cache without being copied. The
+/// outputs are placed one after another in the order they are allocated,
+/// each aligned to 64 bytes. The buffers are not released individually, and
+/// the file is truncated to the used size once the allocator and all the
+/// output tensors referring to it are destroyed.
+///
+class MappedFileAllocator : public Allocator {
+ public:
+  ///  Create a MappedFileAllocator instance.
+  /// \param path The path to the output file. The file is created, or
+  /// truncated if it exists.
+  /// \param capacity The maximum byte size of the file. An allocation that
+  /// does not fit in the remaining capacity fails the inference.
+  static std::shared_ptr<MappedFileAllocator> Create(
+      const std::string& path, const size_t capacity);
+
+  ~MappedFileAllocator();
+
+  void Allocate(
+      const char* tensor_name, size_t byte_size,
+      MemoryType preferred_memory_type, int64_t preferred_memory_type_id,
+      void** buffer, MemoryType* actual_memory_type,
+      int64_t* actual_memory_type_id) override;
+
+  void Release(
+      void* buffer, size_t byte_size, MemoryType memory_type,
+      int64_t memory_type_id) override;
+
+  /// Get the offset of an output in the file.
+  /// \param output An output tensor allocated by this allocator.
+  /// \return Returns the offset of the output buffer in bytes.
+  size_t Offset(const Tensor& output);
+
+  /// Get the number of bytes used in the file.
+  /// \return Returns the used byte size, including the alignment padding.
+  size_t UsedByteSize() { return used_byte_size_.load(); }
+
+  /// Flush the outputs written so far to the file.
+  void Sync();
+
+ private:
+  MappedFileAllocator(std::shared_ptr<MappedFile> file);
+
+  std::shared_ptr<MappedFile> file_;
+  std::atomic<size_t> used_byte_size_;
+};
+
+//==============================================================================
+/// Object that hands out a rotating set of reusable pre-allocated output
+/// buffers per output name, so that the outputs of steady-state inferences
+/// are written without allocation. A buffer returns to the ring once the
+/// tensor returned by 'Acquire', the output tensor in the result and all the
+/// copies of them are destroyed, and the request it was added to is
+/// destroyed or reset.
+///
+class OutputBufferRing : public std::enable_shared_from_this<OutputBufferRing> {
+ public:
+  ///  Create an OutputBufferRing instance.
+  /// \param buffer_count The number of buffers per output name. The buffers
+  /// of an output name are allocated when the first buffer is acquired.
+  /// \param byte_size The byte size of each buffer. It is the capacity of the
+  /// outputs written to the buffers.
+  /// \param memory_type The memory type of the buffers. Default is 'CPU'.
+  /// \param memory_type_id The ID of the memory of the buffers. Default is 0.
+  static std::shared_ptr<OutputBufferRing> Create(
+      const size_t buffer_count, const size_t byte_size,
+      const MemoryType& memory_type = MemoryType::CPU,
+      const int64_t memory_type_id = 0);
+
+  ~OutputBufferRing();
+
+  /// Acquire the next free buffer of an output. Block until a buffer is
+  /// released if all the buffers of the output are in use.
+  /// \param output_name The name of the output.
+  /// \return Returns a 'Tensor' object referring to the buffer, to be passed
+  /// to 'InferRequest::AddRequestedOutput'.
+  Tensor Acquire(const std::string& output_name);
+
+  /// Acquire the next free buffer of an output and add it to a request as a
+  /// requested output.
+  /// \param infer_request The request to add the requested output to.
+  /// \param output_name The name of the output.
+  void AddRequestedOutput(
+      InferRequest& infer_request, const std::string& output_name);
+
+  /// Get the number of free buffers of an output.
+  /// \param output_name The name of the output.
+  /// \return Returns the number of buffers that can be acquired without
+  /// blocking.
+  size_t FreeBufferCount(const std::string& output_name);
+
+ private:
+  OutputBufferRing(
+      const size_t buffer_count, const size_t byte_size,
+      const MemoryType& memory_type, const int64_t memory_type_id);
+
+  // Return a buffer of 'output_name' to the ring.
+  void Release(const std::string& output_name, char* buffer);
+
+  // Allocate or free one buffer in the memory of the ring. Must be called
+  // without holding 'mu_'.
+  char* AllocateBuffer(const std::string& output_name);
+  void FreeBuffer(char* buffer);
+
+  struct Ring {
+    // All the buffers of the output.
+    std::vector<char*> buffers_;
+    // The free buffers, in the order they are handed out.
+    std::deque<char*> free_buffers_;
+  };
+
+  const size_t buffer_count_;
+  const size_t byte_size_;
+  const MemoryType memory_type_;
+  const int64_t memory_type_id_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::unordered_map<std::string, Ring> rings_;
+};
+
+//==============================================================================
+/// Object that hands out pinned host buffers for building inputs from a
+/// preallocated pool, so that the server transfers the inputs to the GPU
+/// directly from the buffers instead of staging them through its own pinned
+/// memory. A buffer added with 'AddInput' returns to the pool as soon as the
+/// server releases the request, so a request whose inputs come from the
+/// arena must not be sent again without adding new inputs. Without GPU
+/// support, the buffers are aligned host memory in 'CPU' memory.
+///
+class PinnedInputArena : public std::enable_shared_from_this<PinnedInputArena> {
+ public:
+  ///  Create a PinnedInputArena instance.
+  /// \param buffer_count The number of buffers in the pool.
+  /// \param byte_size The byte size of each buffer.
+  static std::shared_ptr<PinnedInputArena> Create(
+      const size_t buffer_count, const size_t byte_size);
+
+  ~PinnedInputArena();
+
+  /// Acquire a free buffer. Block until a buffer is returned if all the
+  /// buffers are in use. The buffer returns to the pool once the returned
+  /// tensor and all the copies of it are destroyed, or once the server
+  /// releases the request it was added to by 'AddInput'.
+  /// \return Returns a 'Tensor' object referring to the buffer, whose byte
+  /// size is the capacity of the buffer. The data type, the shape and the
+  /// byte size must be set before adding it to a request.
+  Tensor Acquire();
+
+  /// Add a tensor returned by 'Acquire' to a request as an input. The
+  /// ownership of the buffer is moved from 'input' to the request.
+  /// \param infer_request The request to add the input to.
+  /// \param name The name of the input.
+  /// \param input The tensor returned by 'Acquire'.
+  void AddInput(
+      InferRequest& infer_request, const std::string& name, Tensor& input);
+
+  /// Copy data into a free buffer and add it to a request as an input.
+  /// \param infer_request The request to add the input to.
+  /// \param name The name of the input.
+  /// \param data The data of the input in host memory.
+  /// \param byte_size The byte size of the data. It must not exceed the byte
+  /// size of the buffers.
+  /// \param data_type The data type of the input.
+  /// \param shape The shape of the input.
+  void AddInput(
+      InferRequest& infer_request, const std::string& name, const char* data,
+      const size_t byte_size, const DataType& data_type,
+      const std::vector<int64_t>& shape);
+
+  /// Get the number of free buffers.
+  /// \return Returns the number of buffers that can be acquired without
+  /// blocking.
+  size_t FreeBufferCount();
+
+ private:
+  PinnedInputArena(const size_t byte_size);
+
+  // Return a buffer to the pool.
+  void Release(char* buffer);
+
+  const size_t byte_size_;
+  // The memory type of the buffers, 'CPU_PINNED' if GPU support is enabled.
+  const MemoryType memory_type_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  // All the buffers of the pool.
+  std::vector<char*> buffers_;
+  // The free buffers, in the order they are handed out.
+  std::deque<char*> free_buffers_;
+};
+
+//==============================================================================
+/// Object that sends the steps of a sequence to a stateful model. All the
+/// steps share the correlation ID set in 'InferOptions', and the sequence
+/// start and end flags are set automatically. Multiple steps can be inflight
+/// at the same time and their results are received in the order the steps
+/// were sent. The request objects and the input buffers are reused between
+/// steps. This object is not thread-safe and does not support decoupled
+/// models.
+///
+class SequenceStream {
+ public:
+  ///  Create a SequenceStream instance.
+  /// \param server The server to send the steps to. The server must outlive
+  /// the 'SequenceStream' object.
+  /// \param infer_options The inference options shared by all the steps.
+  /// Either 'correlation_id_' or 'correlation_id_str_' must be set. The
+  /// 'sequence_start_' and 'sequence_end_' fields are ignored.
+  /// \param max_inflight The maximum number of steps sent but not yet
+  /// completed. Default is 4.
+  static std::unique_ptr<SequenceStream> Create(
+      TritonServer& server, const InferOptions& infer_options,
+      const size_t max_inflight = 4);
+
+  /// Wait for the inflight steps to complete before destroying the object.
+  ~SequenceStream();
+
+  /// Send the next step of the sequence. The data of the input tensors in CPU
+  /// memory is copied into buffers owned by the stream, so the buffers of the
+  /// caller can be reused once this function returns. The buffers of input
+  /// tensors in GPU memory must not be modified until the result of the step
+  /// is received. If 'max_inflight' steps are already inflight, this
+  /// function waits for the oldest one to complete and keeps its result for
+  /// 'Receive'.
+  /// \param inputs The input tensors of the step, keyed by input name.
+  /// \param is_last Whether this step is the last step of the sequence. No
+  /// step can be sent after the last step. Default is false.
+  void Send(
+      const std::unordered_map<std::string, Tensor>& inputs,
+      const bool is_last = false);
+
+  /// Receive the result of the oldest step that has not been received yet.
+  /// This function blocks until the step is completed.
+  /// \return Returns the result of the step, or nullptr if there is no step
+  /// to be received.
+  std::unique_ptr<InferResult> Receive();
+
+  /// Get the number of steps that are sent but not yet received.
+  /// \return Returns the number of pending steps.
+  size_t Pending() { return pending_.size(); }
+
+  /// Whether the last step of the sequence has been sent.
+  /// \return Returns true if the last step has been sent, false otherwise.
+  bool IsEnded() { return ended_; }
+
+ private:
+  SequenceStream(
+      TritonServer& server, const InferOptions& infer_options,
+      const size_t max_inflight);
+
+  // A request object and the input buffers reused by every
+  // 'max_inflight'-th step.
+  struct Slot {
+    std::unique_ptr<InferRequest> request_;
+    std::unordered_map<std::string, std::vector<char>> buffers_;
+    bool inflight_;
+  };
+
+  // A step that has been sent but not yet received.
+  struct Step {
+    size_t slot_;
+    std::future<std::unique_ptr<InferResult>> future_;
+    std::unique_ptr<InferResult> result_;
+    bool completed_;
+  };
+
+  // Wait for the step to complete and make its slot available.
+  void Complete(Step& step);
+
+  TritonServer& server_;
+  std::vector<Slot> slots_;
+  std::deque<Step> pending_;
+  size_t next_slot_;
+  bool started_;
+  bool ended_;
+};
+
+//==============================================================================
+/// Object that chains the inferences of several models in process. Each stage
+/// of the pipeline is an inference on one model, and the outputs of a stage
+/// can be connected to the inputs of any later stage. Once a stage completes,
+/// the next stage is sent from the completion callback of the server, without
+/// waking up any caller thread, and the connected outputs are passed as inputs
+/// without copying. The output buffers are reference counted and released
+/// once no remaining stage uses them. The stages must not be decoupled
+/// models. The stages and connections must be set up before the first call to
+/// 'AsyncInfer', after which 'AsyncInfer' can be called from multiple threads.
+///
+class Pipeline {
+ public:
+  ///  Create a Pipeline instance.
+  /// \param server The server to run the stages on. The server must outlive
+  /// the 'Pipeline' object.
+  static std::unique_ptr<Pipeline> Create(TritonServer& server);
+
+  /// Wait for the runs in flight to complete before destroying the object.
+  ~Pipeline();
+
+  /// Add a stage to the pipeline. The stages run in the order they are added.
+  /// \param infer_options The inference options of the stage.
+  /// \return Returns the index of the stage.
+  size_t AddStage(const InferOptions& infer_options);
+
+  /// Connect an output of a stage to an input of a later stage.
+  /// \param from_stage The index of the stage producing the output.
+  /// \param output_name The name of the output.
+  /// \param to_stage The index of the stage consuming the input. Must be
+  /// greater than 'from_stage'.
+  /// \param input_name The name of the input.
+  void Connect(
+      const size_t from_stage, const std::string& output_name,
+      const size_t to_stage, const std::string& input_name);
+
+  /// Run the pipeline asynchronously.
+  /// \param inputs The input tensors of the first stage, keyed by input name.
+  /// The input data buffers must not be modified until the result is
+  /// returned.
+  /// \return Returns the result of the last stage as a future of a unique
+  /// pointer of InferResult object. If a stage fails, the result of the
+  /// failed stage is returned and the remaining stages are not run.
+  std::future<std::unique_ptr<InferResult>> AsyncInfer(
+      const std::unordered_map<std::string, Tensor>& inputs);
+
+ private:
+  Pipeline(TritonServer& server);
+
+  // An output of a stage connected to an input of a later stage.
+  struct Connection {
+    size_t from_stage_;
+    std::string output_name_;
+    size_t to_stage_;
+    std::string input_name_;
+  };
+
+  // The state of one run of the pipeline, shared by the completion callbacks
+  // of its stages.
+  struct Run;
+
+  // Send a stage of the run. The result is passed to 'CompleteStage'.
+  void SendStage(const std::shared_ptr<Run>& run, const size_t stage);
+
+  // Pass the outputs of a completed stage to the later stages and send the
+  // next stage, or return the result if it is the last stage or has failed.
+  void CompleteStage(
+      const std::shared_ptr<Run>& run, const size_t stage,
+      std::unique_ptr<InferResult>&& result);
+
+  // Return the result of the run and mark the run as completed.
+  void Finish(
+      const std::shared_ptr<Run>& run, std::unique_ptr<InferResult>&& result);
+
+  TritonServer& server_;
+  std::vector<InferOptions> stages_;
+  std::vector<Connection> connections_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  // The number of runs in flight.
+  size_t inflight_;
+};
+
+//==============================================================================
+/// Structure to hold the options of a shard of 'ShardedServer'. Each shard is
+/// a separate server whose model instances are bound to the given NUMA node
+/// and CPU cores through host policies.
+///
+struct ShardOptions {
+  ShardOptions(const int32_t numa_node);
+
+  ShardOptions(
+      const int32_t numa_node, const std::string& cpu_cores,
+      const std::vector<std::string>& host_policy_names);
+
+  // The NUMA node the shard is bound to. -1 means that the shard is not bound
+  // to a NUMA node.
+  int32_t numa_node_;
+  // The CPU cores the shard is bound to, as a comma-separated list of core
+  // IDs and ranges (e.g. "0-15,32-47"). Default is an empty string, meaning
+  // that the shard is not bound to CPU cores.
+  std::string cpu_cores_;
+  // The names of the host policies to apply the binding to. A model instance
+  // uses the host policy named by the 'host_policy' field of its instance
+  // group, which defaults to "cpu" for CPU instances and "gpu_<device_id>"
+  // for GPU instances. Default is {"cpu"}.
+  std::vector<std::string> host_policy_names_;
+};
+
+//==============================================================================
+/// Object that owns several 'TritonServer' objects, each bound to a NUMA
+/// node, and routes the inference requests among them, so that the model
+/// instances and the scheduling of each shard stay on one socket.
+///
+/// Every shard is a separate server that loads its own copy of the models,
+/// so the host and device memory used by the models is multiplied by the
+/// number of shards. The pinned memory pool is shared by all the servers of
+/// the process. When only the placement of the model instances matters, a
+/// single 'TritonServer' with one host policy per NUMA node avoids the extra
+/// copies.
+///
+class ShardedServer {
+ public:
+  // The policy to select the shard for a request.
+  // * ROUND_ROBIN: The shards are used in turn.
+  // * LEAST_OUTSTANDING: The shard with the fewest requests in flight is used.
+  enum class Routing { ROUND_ROBIN, LEAST_OUTSTANDING };
+
+  // Function to select the shard for a request, e.g. by a key the caller
+  // associates with the request or with the NUMA node of the calling thread.
+  // It is given the request and the number of requests in flight on each
+  // shard, and returns the index of the shard.
+  using RoutingFn = std::function<size_t(
+      const InferRequest& request, const std::vector<uint64_t>& outstanding)>;
+
+  ///  Create a ShardedServer instance.
+  /// \param options The server options shared by all the shards. The host
+  /// policies of each shard are appended to 'host_policy_'.
+  /// \param shards The options of each shard.
+  /// \param routing The policy to select the shard for a request. Default is
+  /// 'LEAST_OUTSTANDING'.
+  static std::unique_ptr<ShardedServer> Create(
+      const ServerOptions& options, const std::vector<ShardOptions>& shards,
+      const Routing routing = Routing::LEAST_OUTSTANDING);
+
+  ///  Create a ShardedServer instance whose requests are routed by a
+  /// caller-supplied function.
+  /// \param options The server options shared by all the shards. The host
+  /// policies of each shard are appended to 'host_policy_'.
+  /// \param shards The options of each shard.
+  /// \param routing_fn The function to select the shard for a request. It may
+  /// be called concurrently by the threads calling 'AsyncInfer'.
+  static std::unique_ptr<ShardedServer> Create(
+      const ServerOptions& options, const std::vector<ShardOptions>& shards,
+      RoutingFn routing_fn);
+
+  /// Load the requested model on every shard. See
+  /// 'TritonServer::LoadModel'.
+  /// \param model_name The name of the model.
+  void LoadModel(const std::string& model_name);
+
+  /// Unload the requested model on every shard. See
+  /// 'TritonServer::UnloadModel'.
+  /// \param model_name The name of the model.
+  void UnloadModel(const std::string& model_name);
+
+  /// Are all the shards ready?
+  /// \return Returns true if all the shards are ready, false otherwise.
+  bool IsServerReady();
+
+  /// Is the model ready on all the shards? See 'TritonServer::IsModelReady'.
+  /// \return Returns true if the model is ready on all the shards, false
+  /// otherwise.
+  bool IsModelReady(
+      const std::string& model_name, const int64_t model_version = -1);
+
+  /// Run asynchronous inference on one of the shards, selected by the routing
+  /// policy or function. Decoupled models are not supported.
+  /// \param infer_request The InferRequest object contains
+  /// the inputs, outputs and infer options for an inference request.
+  /// \return Returns the result of inference as a future of
+  /// a unique pointer of InferResult object.
+  std::future<std::unique_ptr<InferResult>> AsyncInfer(
+      InferRequest& infer_request);
+
+  /// Get the number of shards.
+  /// \return Returns the number of shards.
+  size_t ShardCount() { return shards_.size(); }
+
+  /// Get a shard for the functions not provided by 'ShardedServer'.
+  /// \param index The index of the shard.
+  /// \return Returns the 'TritonServer' object of the shard.
+  TritonServer& Shard(const size_t index);
+
+  /// Get the number of requests in flight on each shard.
+  /// \return Returns the number of requests in flight, indexed by shard.
+  std::vector<uint64_t> OutstandingRequests();
+
+ private:
+  ShardedServer(const Routing routing, RoutingFn routing_fn);
+
+  // Create a server for each shard.
+  void CreateShards(
+      const ServerOptions& options, const std::vector<ShardOptions>& shards);
+
+  // Select the shard for the request.
+  size_t Route(const InferRequest& infer_request);
+
+  struct ShardState {
+    std::unique_ptr<TritonServer> server_;
+    // The number of requests in flight. Shared with the completion callbacks
+    // of the requests.
+    std::shared_ptr<std::atomic<uint64_t>> outstanding_;
+  };
+
+  const Routing routing_;
+  // The caller-supplied routing function, if any. Takes precedence over
+  // 'routing_'.
+  RoutingFn routing_fn_;
+  std::vector<ShardState> shards_;
+  std::atomic<size_t> next_shard_;
+};
+
+//==============================================================================
+/// Structure to hold the statistics of a 'BulkInferenceRunner' run.
+///
+struct BulkInferenceStats {
+  BulkInferenceStats();
+
+  // The number of rows whose results have been passed to the sink.
+  uint64_t rows_;
+  // The number of batches whose results have been passed to the sink.
+  uint64_t batches_;
+  // The time since the start of the run in nanoseconds.
+  uint64_t elapsed_ns_;
+  // The cumulative time spent reading the batches from the source in
+  // nanoseconds.
+  uint64_t source_ns_;
+  // The cumulative time spent in the sink in nanoseconds.
+  uint64_t sink_ns_;
+  // The throughput of the run in rows per second.
+  double rows_per_sec_;
+};
+
+//==============================================================================
+/// Source of the rows of a 'BulkInferenceRunner' run. A source produces
+/// batches of rows, with the rows stacked along the first dimension of each
+/// input tensor.
+///
+class BulkInferenceSource {
+ public:
+  virtual ~BulkInferenceSource() = default;
+
+  /// Create a source that slices whole tensors along their first dimension.
+  /// The batches refer to the buffers of the tensors without copying, so
+  /// tensors created by 'Tensor::FromFile' or 'Tensor::FromNpyFile' are read
+  /// directly from the page cache. 'BYTES' tensors are not supported.
+  /// \param tensors The input tensors, keyed by input name. The tensors must
+  /// have the same first dimension, which is the number of rows.
+  /// \return Returns the source.
+  static std::unique_ptr<BulkInferenceSource> FromTensors(
+      const std::unordered_map<std::string, Tensor>& tensors);
+
+  /// Create a source that reads the rows one at a time from a function. The
+  /// rows are copied into the buffers of the batch, so the buffers of a row
+  /// can be reused once the function returns.
+  /// \param next_row The function filling the input tensors of the next row,
+  /// keyed by input name, without the batch dimension. The tensors must be in
+  /// CPU memory and have the same shape for every row. Returns false if there
+  /// is no more row.
+  /// \return Returns the source.
+  static std::unique_ptr<BulkInferenceSource> FromRows(
+      std::function<bool(std::unordered_map<std::string, Tensor>* row)>
+          next_row);
+
+  /// Get the next batch of rows.
+  /// \param max_rows The maximum number of rows in the batch.
+  /// \param batch Returns the input tensors of the batch, keyed by input
+  /// name.
+  /// \return Returns the number of rows in the batch, or 0 if there is no
+  /// more row.
+  virtual size_t Next(
+      const size_t max_rows,
+      std::unordered_map<std::string, Tensor>* batch) = 0;
+
+ protected:
+  // Make 'tensor' share the ownership of 'owner', which owns its buffer.
+  static void SetBufferOwner(Tensor& tensor, std::shared_ptr<void> owner)
+  {
+    tensor.buffer_owner_ = owner;
+  }
+};
+
+//==============================================================================
+/// Object that runs inference on a whole dataset. The rows of the source are
+/// grouped into batches, and up to 'max_inflight' batches are inferenced at
+/// the same time. Reading the next batches from the source, the inference,
+/// and passing the results to the sink overlap, while the results are passed
+/// to the sink in the order of the rows. Decoupled models are not supported.
+///
+class BulkInferenceRunner {
+ public:
+  // The function receiving the result of a batch. 'first_row' is the index of
+  // the first row of the batch in the source. The function is called on a
+  // separate thread, in the order of the rows.
+  using SinkFn = std::function<void(
+      const uint64_t first_row, const size_t row_count, InferResult& result)>;
+  // The function receiving the statistics of the run so far.
+  using ProgressFn = std::function<void(const BulkInferenceStats& stats)>;
+
+  ///  Create a BulkInferenceRunner instance.
+  /// \param server The server to run the inferences on. The server must
+  /// outlive the 'BulkInferenceRunner' object.
+  /// \param infer_options The inference options of the requests.
+  /// \param max_inflight The maximum number of batches inferenced at the
+  /// same time. Default is 4.
+  /// \param batch_size The maximum number of rows in a batch. Default is 0,
+  /// which means the 'max_batch_size' of the model. The model must support
+  /// batching.
+  static std::unique_ptr<BulkInferenceRunner> Create(
+      TritonServer& server, const InferOptions& infer_options,
+      const size_t max_inflight = 4, const size_t batch_size = 0);
+
+  /// Run inference on all the rows of a source. If a batch fails, no more
+  /// batches are sent and an exception is thrown once the batches in flight
+  /// complete.
+  /// \param source The source of the rows.
+  /// \param sink The function receiving the result of each batch.
+  /// \param progress The function receiving the statistics every
+  /// 'progress_interval' batches. Default is nullptr.
+  /// \param progress_interval The number of batches between two calls of
+  /// 'progress'. Default is 100.
+  /// \return Returns the statistics of the run.
+  BulkInferenceStats Run(
+      BulkInferenceSource& source, SinkFn sink, ProgressFn progress = nullptr,
+      const uint64_t progress_interval = 100);
+
+  /// Get the maximum number of rows in a batch.
+  /// \return Returns the batch size.
+  size_t BatchSize() { return batch_size_; }
+
+ private:
+  BulkInferenceRunner(
+      TritonServer& server, const InferOptions& infer_options,
+      const size_t max_inflight, const size_t batch_size);
+
+  TritonServer& server_;
+  InferOptions infer_options_;
+  const size_t max_inflight_;
+  const size_t batch_size_;
+};
+
+//==============================================================================
+/// Structure to hold options for replaying a request log.
+///
+struct ReplayOptions {
+  ReplayOptions();
+
+  ReplayOptions(const bool preserve_timing, const size_t max_inflight);
+
+  // If true, the requests are sent with the inter-arrival times they were
+  // recorded with. If false, the requests are sent as fast as possible.
+  // Default is true.
+  bool preserve_timing_;
+  // The maximum number of requests inflight when the requests are sent as
+  // fast as possible. Ignored if 'preserve_timing_' is true. Default is 16.
+  size_t max_inflight_;
+};
+
+//==============================================================================
+/// Structure to hold the statistics of a replay. The latency of a request is
+/// measured from sending the request to receiving its result.
+///
+struct ReplayStats {
+  ReplayStats();
+
+  // The number of requests sent.
+  uint64_t requests_;
+  // The number of requests that returned an error.
+  uint64_t failed_;
+  // The duration of the replay in nanoseconds.
+  uint64_t elapsed_ns_;
+  // The latency distribution of the requests in nanoseconds.
+  uint64_t mean_ns_;
+  uint64_t p50_ns_;
+  uint64_t p90_ns_;
+  uint64_t p99_ns_;
+  uint64_t max_ns_;
+};
+
+//==============================================================================
+/// Object that replays a request log written by 'TritonServer::StartRecording'
+/// against a server, turning the recorded traffic into a repeatable
+/// benchmark.
+///
+class RequestReplayer {
+ public:
+  ///  Create a RequestReplayer instance. All the records of the request log
+  /// are read in memory.
+  /// \param path The path to the request log.
+  static std::unique_ptr<RequestReplayer> Create(const std::string& path);
+
+  /// Send the recorded requests to a server and wait for their results.
+  /// \param server The server to send the requests to.
+  /// \param replay_options The options of the replay. This field is optional.
+  /// \return Returns the statistics of the replay.
+  ReplayStats Run(
+      TritonServer& server,
+      const ReplayOptions& replay_options = ReplayOptions());
+
+  /// Get the number of recorded requests.
+  /// \return Returns the number of requests in the request log.
+  size_t RequestCount() { return records_.size(); }
+
+ private:
+  RequestReplayer() = default;
+
+  std::vector<RecordedRequest> records_;
+};
+
 //==============================================================================
 /// Helper functions to convert Wrapper enum to string.
 ///
@@ -921,8 +2112,11 @@ InferRequest::AddInput(
   // Serialize the strings into a "raw" buffer. The first 4-bytes are
   // the length of the string length. Next are the actual string
   // characters. There is *not* a null-terminator on the string.
-  str_bufs_.emplace_back();
-  std::string& sbuf = str_bufs_.back();
+  if (str_buf_count_ == str_bufs_.size()) {
+    str_bufs_.emplace_back();
+  }
+  std::string& sbuf = *std::next(str_bufs_.begin(), str_buf_count_++);
+  sbuf.clear();
 
   Iterator it;
   for (it = begin; it != end; it++) {
@@ -0,0 +1,181 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "allocation_tracker.h"
+
+#include <algorithm>
+#include "../include/triton/developer_tools/server_wrapper.h"
+
+namespace triton { namespace developer_tools { namespace server {
+
+#define IGNORE_ERROR(X)                   \
+  do {                                    \
+    TRITONSERVER_Error* ie_err__ = (X);   \
+    if (ie_err__ != nullptr) {            \
+      TRITONSERVER_ErrorDelete(ie_err__); \
+    }                                     \
+  } while (false)
+
+constexpr size_t AllocationTracker::kHistogramBucketCount;
+
+namespace {
+
+size_t
+HistogramBucket(const size_t byte_size)
+{
+  size_t bucket = 0;
+  size_t bound = 1024;
+  while ((byte_size > bound) &&
+         (bucket < AllocationTracker::kHistogramBucketCount - 1)) {
+    bound <<= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+}  // namespace
+
+AllocationTracker::AllocationTracker(const bool enable_metrics)
+    : start_(std::chrono::steady_clock::now()), live_family_(nullptr),
+      allocation_family_(nullptr)
+{
+  if (enable_metrics) {
+    // Metrics are best effort, the counters are still available through
+    // 'Statistics' if the families can not be created.
+    IGNORE_ERROR(TRITONSERVER_MetricFamilyNew(
+        &live_family_, TRITONSERVER_METRIC_KIND_GAUGE,
+        "tds_output_live_bytes",
+        "Bytes of output buffers held by results, per model and memory "
+        "type"));
+    IGNORE_ERROR(TRITONSERVER_MetricFamilyNew(
+        &allocation_family_, TRITONSERVER_METRIC_KIND_COUNTER,
+        "tds_output_allocations_total",
+        "Number of output buffers allocated, per model and memory type"));
+  }
+}
+
+AllocationTracker::~AllocationTracker()
+{
+  for (auto& counters : counters_) {
+    if (counters.second.live_metric_ != nullptr) {
+      IGNORE_ERROR(TRITONSERVER_MetricDelete(counters.second.live_metric_));
+    }
+    if (counters.second.allocation_metric_ != nullptr) {
+      IGNORE_ERROR(
+          TRITONSERVER_MetricDelete(counters.second.allocation_metric_));
+    }
+  }
+  if (live_family_ != nullptr) {
+    IGNORE_ERROR(TRITONSERVER_MetricFamilyDelete(live_family_));
+  }
+  if (allocation_family_ != nullptr) {
+    IGNORE_ERROR(TRITONSERVER_MetricFamilyDelete(allocation_family_));
+  }
+}
+
+void
+AllocationTracker::Allocated(
+    const std::string& model_name, const MemoryType& memory_type,
+    const size_t byte_size)
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  Counters& counters = Find(model_name, memory_type);
+  counters.live_byte_size_ += byte_size;
+  if (counters.live_byte_size_ > counters.peak_byte_size_) {
+    counters.peak_byte_size_ = counters.live_byte_size_;
+  }
+  counters.allocation_count_++;
+  counters.allocated_byte_size_ += byte_size;
+  counters.histogram_[HistogramBucket(byte_size)]++;
+  if (counters.live_metric_ != nullptr) {
+    IGNORE_ERROR(TRITONSERVER_MetricSet(
+        counters.live_metric_, counters.live_byte_size_));
+  }
+  if (counters.allocation_metric_ != nullptr) {
+    IGNORE_ERROR(TRITONSERVER_MetricIncrement(counters.allocation_metric_, 1));
+  }
+}
+
+void
+AllocationTracker::Released(
+    const std::string& model_name, const MemoryType& memory_type,
+    const size_t byte_size)
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  Counters& counters = Find(model_name, memory_type);
+  counters.live_byte_size_ -= std::min<uint64_t>(
+      byte_size, counters.live_byte_size_);
+  if (counters.live_metric_ != nullptr) {
+    IGNORE_ERROR(TRITONSERVER_MetricSet(
+        counters.live_metric_, counters.live_byte_size_));
+  }
+}
+
+std::map<std::pair<std::string, MemoryType>, AllocationTracker::Counters>
+AllocationTracker::Statistics()
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  return counters_;
+}
+
+uint64_t
+AllocationTracker::ElapsedNs() const
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start_)
+      .count();
+}
+
+AllocationTracker::Counters&
+AllocationTracker::Find(
+    const std::string& model_name, const MemoryType& memory_type)
+{
+  auto key = std::make_pair(model_name, memory_type);
+  auto it = counters_.find(key);
+  if (it != counters_.end()) {
+    return it->second;
+  }
+
+  Counters& counters = counters_[key];
+  if ((live_family_ != nullptr) && (allocation_family_ != nullptr)) {
+    const std::string memory_type_str = MemoryTypeString(memory_type);
+    TRITONSERVER_Parameter* model_label = TRITONSERVER_ParameterNew(
+        "model", TRITONSERVER_PARAMETER_STRING, model_name.c_str());
+    TRITONSERVER_Parameter* memory_type_label = TRITONSERVER_ParameterNew(
+        "memory_type", TRITONSERVER_PARAMETER_STRING,
+        memory_type_str.c_str());
+    const TRITONSERVER_Parameter* labels[] = {model_label, memory_type_label};
+    IGNORE_ERROR(TRITONSERVER_MetricNew(
+        &counters.live_metric_, live_family_, labels, 2));
+    IGNORE_ERROR(TRITONSERVER_MetricNew(
+        &counters.allocation_metric_, allocation_family_, labels, 2));
+    TRITONSERVER_ParameterDelete(model_label);
+    TRITONSERVER_ParameterDelete(memory_type_label);
+  }
+  return counters;
+}
+
+}}}  // namespace triton::developer_tools::server
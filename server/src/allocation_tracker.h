@@ -0,0 +1,107 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../include/triton/developer_tools/common.h"
+#include "triton/core/tritonserver.h"
+
+namespace triton { namespace developer_tools { namespace server {
+
+//==============================================================================
+/// Accounts the output buffers allocated by the default response allocator
+/// per model and memory type. Optionally exposes the counters as custom
+/// metrics of the server.
+///
+class AllocationTracker {
+ public:
+  // The number of buckets of the size histogram. Bucket 0 counts the
+  // allocations of at most 1 KiB, bucket 'i' the ones of at most 1 KiB << i
+  // bytes that are larger than the previous bucket, and the last bucket all
+  // the larger allocations.
+  static constexpr size_t kHistogramBucketCount = 22;
+
+  struct Counters {
+    Counters()
+        : live_byte_size_(0), peak_byte_size_(0), allocation_count_(0),
+          allocated_byte_size_(0), histogram_(kHistogramBucketCount, 0),
+          live_metric_(nullptr), allocation_metric_(nullptr)
+    {
+    }
+
+    uint64_t live_byte_size_;
+    uint64_t peak_byte_size_;
+    uint64_t allocation_count_;
+    uint64_t allocated_byte_size_;
+    std::vector<uint64_t> histogram_;
+    // The custom metrics of the counters, nullptr if metrics are disabled.
+    TRITONSERVER_Metric* live_metric_;
+    TRITONSERVER_Metric* allocation_metric_;
+  };
+
+  // Create a tracker. If 'enable_metrics' is true, the live byte size and the
+  // allocation count are reported as custom metrics labeled by model and
+  // memory type.
+  explicit AllocationTracker(const bool enable_metrics);
+
+  ~AllocationTracker();
+
+  // Account an output buffer of 'byte_size' bytes allocated for
+  // 'model_name'.
+  void Allocated(
+      const std::string& model_name, const MemoryType& memory_type,
+      const size_t byte_size);
+
+  // Account the release of a buffer accounted by 'Allocated'.
+  void Released(
+      const std::string& model_name, const MemoryType& memory_type,
+      const size_t byte_size);
+
+  // Return a copy of the counters, keyed by model name and memory type.
+  std::map<std::pair<std::string, MemoryType>, Counters> Statistics();
+
+  // Return the time since the tracker was created in nanoseconds.
+  uint64_t ElapsedNs() const;
+
+ private:
+  // Return the counters of 'model_name' and 'memory_type', creating them
+  // if needed. Must be called with 'mu_' held.
+  Counters& Find(const std::string& model_name, const MemoryType& memory_type);
+
+  const std::chrono::steady_clock::time_point start_;
+  TRITONSERVER_MetricFamily* live_family_;
+  TRITONSERVER_MetricFamily* allocation_family_;
+
+  std::mutex mu_;
+  std::map<std::pair<std::string, MemoryType>, Counters> counters_;
+};
+
+}}}  // namespace triton::developer_tools::server
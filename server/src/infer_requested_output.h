@@ -83,6 +83,25 @@ class InferRequestedOutput {
   /// \return The memory type id of the tensor.
   const int64_t& MemoryTypeId() const { return memory_type_id_; }
 
+  /// Update the object to describe another requested output in place,
+  /// reusing the storage of the name.
+  /// \param name The name of output being requested.
+  /// \param buffer The pointer to the start of the pre-allocated buffer, or
+  /// nullptr if the output has no pre-allocated buffer.
+  /// \param byte_size The size of buffer in bytes.
+  /// \param memory_type The memory type of the output.
+  /// \param memory_type_id The memory type id of the output.
+  void Reset(
+      const std::string& name, const char* buffer, size_t byte_size,
+      MemoryType memory_type, int64_t memory_type_id)
+  {
+    name_.assign(name);
+    buffer_ = buffer;
+    byte_size_ = byte_size;
+    memory_type_ = memory_type;
+    memory_type_id_ = memory_type_id;
+  }
+
   InferRequestedOutput(const std::string& name)
       : name_(name), buffer_(nullptr), byte_size_(0),
         memory_type_(MemoryType::CPU), memory_type_id_(0)
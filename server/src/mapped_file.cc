@@ -0,0 +1,174 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "mapped_file.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // !_WIN32
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include "../include/triton/developer_tools/common.h"
+
+namespace triton { namespace developer_tools { namespace server {
+
+#ifndef _WIN32
+namespace {
+
+std::string
+ErrnoString(const std::string& action, const std::string& path)
+{
+  return "failed to " + action + " '" + path + "': " + std::strerror(errno);
+}
+
+}  // namespace
+#endif  // !_WIN32
+
+std::shared_ptr<MappedFile>
+MappedFile::OpenRead(
+    const std::string& path, const size_t offset, const size_t byte_size)
+{
+#ifdef _WIN32
+  throw TritonException("Memory-mapped files are not supported on Windows.");
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw TritonException(ErrnoString("open", path));
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    std::string msg = ErrnoString("stat", path);
+    close(fd);
+    throw TritonException(msg);
+  }
+  const size_t file_size = st.st_size;
+  if ((offset > file_size) ||
+      ((byte_size != 0) && ((file_size - offset) < byte_size))) {
+    close(fd);
+    throw TritonException(
+        "the region of " + std::to_string(byte_size) + " bytes at offset " +
+        std::to_string(offset) + " exceeds the size of '" + path + "' (" +
+        std::to_string(file_size) + " bytes)");
+  }
+  const size_t region_size =
+      (byte_size == 0) ? (file_size - offset) : byte_size;
+
+  // The offset of a mapping must be a multiple of the page size.
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  const size_t map_offset = offset - (offset % page_size);
+  const size_t map_length = region_size + (offset - map_offset);
+  void* base = nullptr;
+  if (map_length != 0) {
+    base = mmap(nullptr, map_length, PROT_READ, MAP_PRIVATE, fd, map_offset);
+    if (base == MAP_FAILED) {
+      std::string msg = ErrnoString("map", path);
+      close(fd);
+      throw TritonException(msg);
+    }
+    // The advice is only a hint, so a failure is not an error.
+    madvise(base, map_length, MADV_SEQUENTIAL);
+  }
+
+  return std::shared_ptr<MappedFile>(new MappedFile(
+      path, fd, base, map_length,
+      reinterpret_cast<char*>(base) + (offset - map_offset), region_size,
+      false /* writable */));
+#endif  // _WIN32
+}
+
+std::shared_ptr<MappedFile>
+MappedFile::CreateWrite(const std::string& path, const size_t byte_size)
+{
+#ifdef _WIN32
+  throw TritonException("Memory-mapped files are not supported on Windows.");
+#else
+  int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    throw TritonException(ErrnoString("create", path));
+  }
+  if (ftruncate(fd, byte_size) != 0) {
+    std::string msg = ErrnoString("resize", path);
+    close(fd);
+    throw TritonException(msg);
+  }
+  void* base = nullptr;
+  if (byte_size != 0) {
+    base = mmap(
+        nullptr, byte_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+        0 /* offset */);
+    if (base == MAP_FAILED) {
+      std::string msg = ErrnoString("map", path);
+      close(fd);
+      throw TritonException(msg);
+    }
+    madvise(base, byte_size, MADV_SEQUENTIAL);
+  }
+
+  return std::shared_ptr<MappedFile>(new MappedFile(
+      path, fd, base, byte_size, reinterpret_cast<char*>(base), byte_size,
+      true /* writable */));
+#endif  // _WIN32
+}
+
+MappedFile::MappedFile(
+    const std::string& path, const int fd, void* base, const size_t map_length,
+    char* data, const size_t byte_size, const bool writable)
+    : path_(path), fd_(fd), base_(base), map_length_(map_length), data_(data),
+      byte_size_(byte_size), writable_(writable), final_byte_size_(byte_size)
+{
+}
+
+MappedFile::~MappedFile()
+{
+#ifndef _WIN32
+  if (map_length_ != 0) {
+    munmap(base_, map_length_);
+  }
+  if (writable_ && (final_byte_size_ != byte_size_)) {
+    if (ftruncate(fd_, final_byte_size_) != 0) {
+      std::cerr << "error: " << ErrnoString("truncate", path_) << std::endl;
+    }
+  }
+  close(fd_);
+#endif  // !_WIN32
+}
+
+void
+MappedFile::Sync()
+{
+#ifndef _WIN32
+  if (writable_ && (map_length_ != 0) &&
+      (msync(base_, map_length_, MS_SYNC) != 0)) {
+    throw TritonException(ErrnoString("sync", path_));
+  }
+#endif  // !_WIN32
+}
+
+}}}  // namespace triton::developer_tools::server
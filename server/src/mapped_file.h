@@ -0,0 +1,84 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <memory>
+#include <string>
+
+namespace triton { namespace developer_tools { namespace server {
+
+//==============================================================================
+/// A memory mapping of a region of a file. The mapping is released when the
+/// object is destroyed. Errors are reported by throwing 'TritonException'.
+///
+class MappedFile {
+ public:
+  // Map 'byte_size' bytes of an existing file starting at 'offset' for
+  // reading. If 'byte_size' is 0, the region extends to the end of the file.
+  // The pages are advised to be read sequentially.
+  static std::shared_ptr<MappedFile> OpenRead(
+      const std::string& path, const size_t offset, const size_t byte_size);
+
+  // Create the file, or truncate it if it exists, with 'byte_size' bytes and
+  // map it for writing. Writes to the mapping are written to the file.
+  static std::shared_ptr<MappedFile> CreateWrite(
+      const std::string& path, const size_t byte_size);
+
+  ~MappedFile();
+
+  // The start of the requested region.
+  char* Data() { return data_; }
+  // The size of the requested region in bytes.
+  size_t ByteSize() const { return byte_size_; }
+
+  // Flush the written pages of the mapping to the file.
+  void Sync();
+
+  // Truncate the file to 'byte_size' bytes once the mapping is released.
+  // Only valid for a file created by 'CreateWrite'.
+  void SetFinalByteSize(const size_t byte_size)
+  {
+    final_byte_size_ = byte_size;
+  }
+
+ private:
+  MappedFile(
+      const std::string& path, const int fd, void* base,
+      const size_t map_length, char* data, const size_t byte_size,
+      const bool writable);
+
+  const std::string path_;
+  const int fd_;
+  // The mapping starts at a page boundary before the requested region.
+  void* const base_;
+  const size_t map_length_;
+  char* const data_;
+  const size_t byte_size_;
+  const bool writable_;
+  size_t final_byte_size_;
+};
+
+}}}  // namespace triton::developer_tools::server
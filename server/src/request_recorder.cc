@@ -0,0 +1,212 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "request_recorder.h"
+
+#include <cstring>
+
+namespace triton { namespace developer_tools { namespace server {
+
+namespace {
+
+// Identifies a request log and the version of its format.
+constexpr char kLogMagic[8] = {'T', 'D', 'S', 'R', 'E', 'Q', 'L', 'G'};
+constexpr uint32_t kLogVersion = 1;
+
+template <typename T>
+void
+AppendValue(std::string* record, const T value)
+{
+  record->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void
+AppendString(std::string* record, const std::string& value)
+{
+  AppendValue<uint64_t>(record, value.size());
+  record->append(value);
+}
+
+template <typename T>
+bool
+ReadValue(std::ifstream& file, T* value)
+{
+  return static_cast<bool>(
+      file.read(reinterpret_cast<char*>(value), sizeof(T)));
+}
+
+bool
+ReadString(std::ifstream& file, std::string* value)
+{
+  uint64_t size;
+  if (!ReadValue(file, &size)) {
+    return false;
+  }
+  value->resize(size);
+  return (size == 0) || static_cast<bool>(file.read(&(*value)[0], size));
+}
+
+}  // namespace
+
+RequestRecorder::RequestRecorder(const std::string& path, const uint32_t rate)
+    : rate_((rate == 0) ? 1 : rate), start_(std::chrono::steady_clock::now()),
+      count_(0), file_(path, std::ios::binary | std::ios::trunc)
+{
+  if (!file_.is_open()) {
+    throw TritonException("Failed to open request log '" + path + "'.");
+  }
+  file_.write(kLogMagic, sizeof(kLogMagic));
+  file_.write(
+      reinterpret_cast<const char*>(&kLogVersion), sizeof(kLogVersion));
+}
+
+bool
+RequestRecorder::Sample(uint64_t* arrival_ns)
+{
+  if ((count_.fetch_add(1) % rate_) != 0) {
+    return false;
+  }
+  *arrival_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start_)
+                    .count();
+  return true;
+}
+
+void
+RequestRecorder::Write(const RecordedRequest& request)
+{
+  // Serialize the record outside of the lock so that only the file write is
+  // serialized.
+  std::string record;
+  AppendValue<uint64_t>(&record, request.arrival_ns_);
+  AppendString(&record, request.model_name_);
+  AppendValue<int64_t>(&record, request.model_version_);
+  AppendString(&record, request.request_id_);
+  AppendValue<uint64_t>(&record, request.correlation_id_);
+  AppendString(&record, request.correlation_id_str_);
+  AppendValue<uint8_t>(&record, request.sequence_start_);
+  AppendValue<uint8_t>(&record, request.sequence_end_);
+  AppendValue<uint64_t>(&record, request.priority_);
+  AppendValue<uint64_t>(&record, request.request_timeout_);
+  AppendValue<uint32_t>(&record, request.inputs_.size());
+  for (const auto& input : request.inputs_) {
+    AppendString(&record, input.name_);
+    AppendValue<uint32_t>(&record, static_cast<uint32_t>(input.data_type_));
+    AppendValue<uint32_t>(&record, input.shape_.size());
+    for (const int64_t dim : input.shape_) {
+      AppendValue<int64_t>(&record, dim);
+    }
+    AppendString(&record, input.data_);
+  }
+  AppendValue<uint32_t>(&record, request.output_names_.size());
+  for (const auto& name : request.output_names_) {
+    AppendString(&record, name);
+  }
+
+  std::lock_guard<std::mutex> lk(mu_);
+  file_.write(record.data(), record.size());
+  if (!file_.good()) {
+    throw TritonException("Failed to write to the request log.");
+  }
+}
+
+RequestLogReader::RequestLogReader(const std::string& path)
+    : path_(path), file_(path, std::ios::binary)
+{
+  if (!file_.is_open()) {
+    throw TritonException("Failed to open request log '" + path + "'.");
+  }
+  char magic[sizeof(kLogMagic)];
+  uint32_t version = 0;
+  if (!file_.read(magic, sizeof(magic)) ||
+      (memcmp(magic, kLogMagic, sizeof(kLogMagic)) != 0) ||
+      !ReadValue(file_, &version)) {
+    throw TritonException("'" + path + "' is not a request log.");
+  }
+  if (version != kLogVersion) {
+    throw TritonException(
+        "Request log '" + path + "' has unsupported version " +
+        std::to_string(version) + ".");
+  }
+}
+
+bool
+RequestLogReader::Next(RecordedRequest* request)
+{
+  // The end of the log is only valid at a record boundary.
+  if (!ReadValue(file_, &request->arrival_ns_)) {
+    return false;
+  }
+
+  uint8_t sequence_start = 0;
+  uint8_t sequence_end = 0;
+  uint32_t input_count = 0;
+  bool ok = ReadString(file_, &request->model_name_) &&
+            ReadValue(file_, &request->model_version_) &&
+            ReadString(file_, &request->request_id_) &&
+            ReadValue(file_, &request->correlation_id_) &&
+            ReadString(file_, &request->correlation_id_str_) &&
+            ReadValue(file_, &sequence_start) &&
+            ReadValue(file_, &sequence_end) &&
+            ReadValue(file_, &request->priority_) &&
+            ReadValue(file_, &request->request_timeout_) &&
+            ReadValue(file_, &input_count);
+  request->sequence_start_ = (sequence_start != 0);
+  request->sequence_end_ = (sequence_end != 0);
+
+  request->inputs_.clear();
+  for (uint32_t i = 0; ok && (i < input_count); ++i) {
+    RecordedRequest::Input input;
+    uint32_t data_type = 0;
+    uint32_t dim_count = 0;
+    ok = ReadString(file_, &input.name_) && ReadValue(file_, &data_type) &&
+         ReadValue(file_, &dim_count);
+    for (uint32_t j = 0; ok && (j < dim_count); ++j) {
+      int64_t dim;
+      ok = ReadValue(file_, &dim);
+      input.shape_.push_back(dim);
+    }
+    ok = ok && ReadString(file_, &input.data_);
+    input.data_type_ = static_cast<DataType>(data_type);
+    request->inputs_.emplace_back(std::move(input));
+  }
+
+  uint32_t output_count = 0;
+  ok = ok && ReadValue(file_, &output_count);
+  request->output_names_.clear();
+  for (uint32_t i = 0; ok && (i < output_count); ++i) {
+    std::string name;
+    ok = ReadString(file_, &name);
+    request->output_names_.emplace_back(std::move(name));
+  }
+
+  if (!ok) {
+    throw TritonException("Request log '" + path_ + "' is truncated.");
+  }
+  return true;
+}
+
+}}}  // namespace triton::developer_tools::server
@@ -0,0 +1,110 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../include/triton/developer_tools/common.h"
+
+namespace triton { namespace developer_tools { namespace server {
+
+//==============================================================================
+/// An inference request as stored in a request log. The input data is copied
+/// so that the request can be replayed after the original buffers are gone.
+///
+struct RecordedRequest {
+  struct Input {
+    std::string name_;
+    DataType data_type_;
+    std::vector<int64_t> shape_;
+    std::string data_;
+  };
+
+  // The arrival time of the request since the start of the recording.
+  uint64_t arrival_ns_;
+  std::string model_name_;
+  int64_t model_version_;
+  std::string request_id_;
+  uint64_t correlation_id_;
+  std::string correlation_id_str_;
+  bool sequence_start_;
+  bool sequence_end_;
+  uint64_t priority_;
+  uint64_t request_timeout_;
+  std::vector<Input> inputs_;
+  std::vector<std::string> output_names_;
+};
+
+//==============================================================================
+/// Writes sampled inference requests to a request log. The log is a binary
+/// file in host byte order made of a header followed by one record per
+/// request. Errors are reported by throwing 'TritonException'.
+///
+class RequestRecorder {
+ public:
+  // Create the log at 'path', or truncate it if it exists. One out of every
+  // 'rate' requests is recorded.
+  RequestRecorder(const std::string& path, const uint32_t rate);
+
+  // Decide whether the next request is recorded. If so, return true and set
+  // 'arrival_ns' to the arrival time of the request since the start of the
+  // recording.
+  bool Sample(uint64_t* arrival_ns);
+
+  // Append 'request' to the log. Can be called from multiple threads.
+  void Write(const RecordedRequest& request);
+
+ private:
+  const uint32_t rate_;
+  const std::chrono::steady_clock::time_point start_;
+  std::atomic<uint64_t> count_;
+
+  std::mutex mu_;
+  std::ofstream file_;
+};
+
+//==============================================================================
+/// Reads the records of a request log written by 'RequestRecorder'. Errors are
+/// reported by throwing 'TritonException'.
+///
+class RequestLogReader {
+ public:
+  explicit RequestLogReader(const std::string& path);
+
+  // Read the next record into 'request'. Return false at the end of the log.
+  bool Next(RecordedRequest* request);
+
+ private:
+  const std::string path_;
+  std::ifstream file_;
+};
+
+}}}  // namespace triton::developer_tools::server
@@ -0,0 +1,368 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "residency_manager.h"
+
+#include <unistd.h>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include "../include/triton/developer_tools/common.h"
+#include "triton/core/tritonserver.h"
+#ifdef TRITON_ENABLE_GPU
+#include <cuda_runtime_api.h>
+#endif  // TRITON_ENABLE_GPU
+
+namespace triton { namespace developer_tools { namespace server {
+
+#define IGNORE_ERROR(X)                   \
+  do {                                    \
+    TRITONSERVER_Error* ie_err__ = (X);   \
+    if (ie_err__ != nullptr) {            \
+      TRITONSERVER_ErrorDelete(ie_err__); \
+    }                                     \
+  } while (false)
+
+#define LOG_MESSAGE(LEVEL, MSG)                                            \
+  do {                                                                     \
+    IGNORE_ERROR(TRITONSERVER_LogMessage(LEVEL, __FILE__, __LINE__, MSG)); \
+  } while (false)
+
+ResidencyManager::ResidencyManager(
+    const uint64_t host_budget_byte_size,
+    const uint64_t device_budget_byte_size,
+    const std::unordered_map<std::string, uint64_t>& host_byte_sizes,
+    const std::unordered_map<std::string, uint64_t>& device_byte_sizes,
+    LoadFn load_fn, UnloadFn unload_fn, IsReadyFn is_ready_fn)
+    : host_budget_byte_size_(host_budget_byte_size),
+      device_budget_byte_size_(device_budget_byte_size),
+      host_byte_sizes_(host_byte_sizes), device_byte_sizes_(device_byte_sizes),
+      load_fn_(load_fn), unload_fn_(unload_fn), is_ready_fn_(is_ready_fn),
+      exiting_(false), clock_(0)
+{
+  loader_thread_ = std::thread([this]() { LoaderThread(); });
+}
+
+ResidencyManager::~ResidencyManager()
+{
+  Stop();
+}
+
+bool
+ResidencyManager::Acquire(const std::string& model_name, ReadyFn ready_fn)
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  auto& state = models_[model_name];
+  if (state.resident_) {
+    state.inflight_++;
+    state.last_used_ = ++clock_;
+    counters_.hits_++;
+    return true;
+  }
+
+  if (exiting_) {
+    throw TritonException(
+        "Model '" + model_name + "' is not resident and the server is exiting");
+  }
+  counters_.load_stalls_++;
+  state.pending_.emplace_back(std::move(ready_fn));
+  if (!state.loading_) {
+    state.loading_ = true;
+    load_queue_.push_back(model_name);
+    cv_.notify_one();
+  }
+  return false;
+}
+
+void
+ResidencyManager::Release(const std::string& model_name)
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  auto it = models_.find(model_name);
+  if ((it != models_.end()) && (it->second.inflight_ > 0)) {
+    it->second.inflight_--;
+  }
+}
+
+void
+ResidencyManager::Forget(const std::string& model_name)
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  auto it = models_.find(model_name);
+  if ((it != models_.end()) && it->second.resident_) {
+    it->second.resident_ = false;
+    counters_.resident_models_--;
+    counters_.resident_host_byte_size_ -= it->second.host_byte_size_;
+    counters_.resident_device_byte_size_ -= it->second.device_byte_size_;
+  }
+}
+
+void
+ResidencyManager::Stop()
+{
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    exiting_ = true;
+    cv_.notify_all();
+  }
+  if (loader_thread_.joinable()) {
+    loader_thread_.join();
+  }
+
+  // Fail the requests that are still waiting for a model load.
+  std::list<ReadyFn> pending;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    for (auto& model : models_) {
+      model.second.loading_ = false;
+      pending.splice(pending.end(), model.second.pending_);
+    }
+    load_queue_.clear();
+  }
+  for (auto& ready_fn : pending) {
+    ready_fn("Server is exiting before the model is loaded");
+  }
+}
+
+ResidencyManager::Counters
+ResidencyManager::Statistics()
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  return counters_;
+}
+
+void
+ResidencyManager::LoaderThread()
+{
+  while (true) {
+    std::string model_name;
+    uint64_t host_byte_size = 0, device_byte_size = 0;
+    {
+      std::unique_lock<std::mutex> lk(mu_);
+      cv_.wait(lk, [this]() { return exiting_ || !load_queue_.empty(); });
+      if (exiting_) {
+        break;
+      }
+      model_name = load_queue_.front();
+      load_queue_.pop_front();
+
+      // Prefer the user-provided estimate over the usage measured by the
+      // previous load of the model.
+      auto& state = models_[model_name];
+      auto hit = host_byte_sizes_.find(model_name);
+      host_byte_size = (hit != host_byte_sizes_.end()) ? hit->second
+                                                       : state.host_byte_size_;
+      auto dit = device_byte_sizes_.find(model_name);
+      device_byte_size = (dit != device_byte_sizes_.end())
+                             ? dit->second
+                             : state.device_byte_size_;
+    }
+
+    std::string error;
+    bool loaded = false;
+    uint64_t load_ns = 0;
+    try {
+      // The model may have been loaded by the user directly.
+      if (!is_ready_fn_(model_name)) {
+        EvictForBudget(model_name, host_byte_size, device_byte_size);
+
+        const uint64_t host_before = HostMemoryUsage();
+        const uint64_t device_before = DeviceMemoryUsage();
+        auto start = std::chrono::steady_clock::now();
+        load_fn_(model_name);
+        load_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+        const uint64_t host_after = HostMemoryUsage();
+        const uint64_t device_after = DeviceMemoryUsage();
+        loaded = true;
+
+        if (host_byte_sizes_.find(model_name) == host_byte_sizes_.end()) {
+          host_byte_size =
+              (host_after > host_before) ? (host_after - host_before) : 0;
+        }
+        if (device_byte_sizes_.find(model_name) == device_byte_sizes_.end()) {
+          device_byte_size = (device_after > device_before)
+                                 ? (device_after - device_before)
+                                 : 0;
+        }
+      }
+    }
+    catch (const TritonException& ex) {
+      error = ex.what();
+    }
+    catch (const std::exception& ex) {
+      error = "Failed to load model '" + model_name + "': " + ex.what();
+    }
+    catch (...) {
+      error = "Failed to load model '" + model_name + "': unknown error";
+    }
+
+    std::list<ReadyFn> pending;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      auto& state = models_[model_name];
+      state.loading_ = false;
+      if (error.empty()) {
+        state.resident_ = true;
+        state.host_byte_size_ = host_byte_size;
+        state.device_byte_size_ = device_byte_size;
+        // Hand a reservation to each of the queued requests.
+        state.inflight_ += state.pending_.size();
+        state.last_used_ = ++clock_;
+        counters_.resident_models_++;
+        counters_.resident_host_byte_size_ += host_byte_size;
+        counters_.resident_device_byte_size_ += device_byte_size;
+        if (loaded) {
+          counters_.loads_++;
+          counters_.load_ns_ += load_ns;
+        }
+      } else {
+        counters_.load_failures_++;
+      }
+      pending.swap(state.pending_);
+    }
+
+    if (loaded) {
+      LOG_MESSAGE(
+          TRITONSERVER_LOG_VERBOSE,
+          ("Loaded model '" + model_name + "' on demand in " +
+           std::to_string(load_ns / 1000000) + " ms, using about " +
+           std::to_string(host_byte_size) + " bytes of host memory and " +
+           std::to_string(device_byte_size) + " bytes of device memory")
+              .c_str());
+    }
+    for (auto& ready_fn : pending) {
+      ready_fn(error);
+    }
+
+    // The measured usage may exceed the estimate used for making room.
+    if (loaded) {
+      EvictForBudget(model_name, 0, 0);
+    }
+  }
+}
+
+void
+ResidencyManager::EvictForBudget(
+    const std::string& incoming_model, const uint64_t incoming_host,
+    const uint64_t incoming_device)
+{
+  std::vector<std::string> victims;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    uint64_t host = counters_.resident_host_byte_size_ + incoming_host;
+    uint64_t device = counters_.resident_device_byte_size_ + incoming_device;
+    while (((host_budget_byte_size_ != 0) && (host > host_budget_byte_size_)) ||
+           ((device_budget_byte_size_ != 0) &&
+            (device > device_budget_byte_size_))) {
+      ModelState* lru = nullptr;
+      std::string lru_name;
+      for (auto& model : models_) {
+        const auto& state = model.second;
+        if (state.resident_ && (state.inflight_ == 0) &&
+            (model.first != incoming_model) &&
+            ((lru == nullptr) || (state.last_used_ < lru->last_used_))) {
+          lru = &model.second;
+          lru_name = model.first;
+        }
+      }
+      if (lru == nullptr) {
+        LOG_MESSAGE(
+            TRITONSERVER_LOG_WARN,
+            ("Memory budget is exceeded while loading model '" +
+             incoming_model + "' but no idle model can be evicted")
+                .c_str());
+        break;
+      }
+
+      // Mark the model as evicted before unloading so that new requests are
+      // queued behind a reload instead of racing with the unload.
+      lru->resident_ = false;
+      host -= lru->host_byte_size_;
+      device -= lru->device_byte_size_;
+      counters_.resident_models_--;
+      counters_.resident_host_byte_size_ -= lru->host_byte_size_;
+      counters_.resident_device_byte_size_ -= lru->device_byte_size_;
+      counters_.evictions_++;
+      victims.push_back(lru_name);
+    }
+  }
+
+  for (const auto& victim : victims) {
+    try {
+      unload_fn_(victim);
+      LOG_MESSAGE(
+          TRITONSERVER_LOG_VERBOSE,
+          ("Evicted least recently used model '" + victim + "'").c_str());
+    }
+    catch (const std::exception& ex) {
+      LOG_MESSAGE(
+          TRITONSERVER_LOG_ERROR,
+          ("Failed to evict model '" + victim + "': " + ex.what()).c_str());
+    }
+    catch (...) {
+      LOG_MESSAGE(
+          TRITONSERVER_LOG_ERROR,
+          ("Failed to evict model '" + victim + "': unknown error").c_str());
+    }
+  }
+}
+
+uint64_t
+ResidencyManager::HostMemoryUsage()
+{
+  // The resident set size of the process, which includes the host memory
+  // allocated by the backends for the model.
+  uint64_t size = 0, resident = 0;
+  std::ifstream statm("/proc/self/statm");
+  if (statm >> size >> resident) {
+    return resident * sysconf(_SC_PAGESIZE);
+  }
+  return 0;
+}
+
+uint64_t
+ResidencyManager::DeviceMemoryUsage()
+{
+  uint64_t used = 0;
+#ifdef TRITON_ENABLE_GPU
+  int device_count = 0;
+  if (cudaGetDeviceCount(&device_count) != cudaSuccess) {
+    return 0;
+  }
+  for (int device = 0; device < device_count; device++) {
+    size_t free_byte_size = 0, total_byte_size = 0;
+    if ((cudaSetDevice(device) == cudaSuccess) &&
+        (cudaMemGetInfo(&free_byte_size, &total_byte_size) == cudaSuccess)) {
+      used += total_byte_size - free_byte_size;
+    }
+  }
+#endif  // TRITON_ENABLE_GPU
+  return used;
+}
+
+}}}  // namespace triton::developer_tools::server
@@ -0,0 +1,174 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace triton { namespace developer_tools { namespace server {
+
+//==============================================================================
+/// Tracks which models are resident on the server and loads them on demand.
+/// Loads and evictions are serialized on a single loader thread so that the
+/// memory growth observed around a load can be attributed to the model being
+/// loaded. When the memory budget is exceeded, the least recently used models
+/// that have no inflight requests are unloaded.
+///
+class ResidencyManager {
+ public:
+  using LoadFn = std::function<void(const std::string& model_name)>;
+  // Must not return until the memory of the model is released, so that the
+  // next load is measured without it.
+  using UnloadFn = std::function<void(const std::string& model_name)>;
+  using IsReadyFn = std::function<bool(const std::string& model_name)>;
+  // Called on the loader thread once the model of a queued request is
+  // resident, or with a non-empty 'error' if the model failed to load.
+  using ReadyFn = std::function<void(const std::string& error)>;
+
+  // A reservation of a resident model held by an inflight request. The model
+  // will not be evicted until all of its reservations are released.
+  class Lease {
+   public:
+    Lease(
+        const std::shared_ptr<ResidencyManager>& manager,
+        const std::string& model_name)
+        : manager_(manager), model_name_(model_name)
+    {
+    }
+    ~Lease() { manager_->Release(model_name_); }
+
+   private:
+    std::shared_ptr<ResidencyManager> manager_;
+    std::string model_name_;
+  };
+
+  struct Counters {
+    Counters()
+        : hits_(0), load_stalls_(0), loads_(0), load_failures_(0),
+          evictions_(0), load_ns_(0), resident_models_(0),
+          resident_host_byte_size_(0), resident_device_byte_size_(0)
+    {
+    }
+
+    uint64_t hits_;
+    uint64_t load_stalls_;
+    uint64_t loads_;
+    uint64_t load_failures_;
+    uint64_t evictions_;
+    uint64_t load_ns_;
+    uint64_t resident_models_;
+    uint64_t resident_host_byte_size_;
+    uint64_t resident_device_byte_size_;
+  };
+
+  ResidencyManager(
+      const uint64_t host_budget_byte_size,
+      const uint64_t device_budget_byte_size,
+      const std::unordered_map<std::string, uint64_t>& host_byte_sizes,
+      const std::unordered_map<std::string, uint64_t>& device_byte_sizes,
+      LoadFn load_fn, UnloadFn unload_fn, IsReadyFn is_ready_fn);
+
+  ~ResidencyManager();
+
+  // Reserve the model for a request. Return true if the model is resident,
+  // in which case the caller owns a reservation that must be released by
+  // 'Release'. Otherwise 'ready_fn' is queued behind the load of the model
+  // and, if called without error, owns a reservation of the model.
+  bool Acquire(const std::string& model_name, ReadyFn ready_fn);
+
+  // Release a reservation obtained by 'Acquire'.
+  void Release(const std::string& model_name);
+
+  // Mark the model as no longer resident, e.g. after it is unloaded by the
+  // user.
+  void Forget(const std::string& model_name);
+
+  // Stop the loader thread. Requests still waiting for a model load are
+  // failed.
+  void Stop();
+
+  Counters Statistics();
+
+ private:
+  struct ModelState {
+    ModelState()
+        : resident_(false), loading_(false), inflight_(0), last_used_(0),
+          host_byte_size_(0), device_byte_size_(0)
+    {
+    }
+
+    bool resident_;
+    bool loading_;
+    // The number of reservations held on the model.
+    size_t inflight_;
+    // The logical time of the last reservation, used for LRU eviction.
+    uint64_t last_used_;
+    // The estimated memory usage of the model. The values are kept after the
+    // model is evicted so that the next load can make room in advance.
+    uint64_t host_byte_size_;
+    uint64_t device_byte_size_;
+    // Requests queued behind the load of the model.
+    std::list<ReadyFn> pending_;
+  };
+
+  void LoaderThread();
+
+  // Evict the least recently used idle models until the resident models plus
+  // the given incoming byte sizes fit in the budget.
+  void EvictForBudget(
+      const std::string& incoming_model, const uint64_t incoming_host,
+      const uint64_t incoming_device);
+
+  uint64_t HostMemoryUsage();
+  uint64_t DeviceMemoryUsage();
+
+  const uint64_t host_budget_byte_size_;
+  const uint64_t device_budget_byte_size_;
+  const std::unordered_map<std::string, uint64_t> host_byte_sizes_;
+  const std::unordered_map<std::string, uint64_t> device_byte_sizes_;
+  LoadFn load_fn_;
+  UnloadFn unload_fn_;
+  IsReadyFn is_ready_fn_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool exiting_;
+  uint64_t clock_;
+  std::unordered_map<std::string, ModelState> models_;
+  std::deque<std::string> load_queue_;
+  Counters counters_;
+  std::thread loader_thread_;
+};
+
+}}}  // namespace triton::developer_tools::server
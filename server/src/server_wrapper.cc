@@ -26,12 +26,19 @@
 
 #include "triton/developer_tools/server_wrapper.h"
 #include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <fstream>
 #include <iostream>
 #include <mutex>
 #include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
+#include "dlpack/dlpack.h"
 #define TRITONJSON_STATUSTYPE TRITONSERVER_Error*
 #define TRITONJSON_STATUSRETURN(M) \
   return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INTERNAL, (M).c_str())
@@ -84,7 +91,18 @@ namespace triton { namespace developer_tools { namespace server {
         ("failed to log message: "));                            \
   } while (false)
 
-using AllocInfo = std::pair<std::shared_ptr<Allocator>, TensorAllocMap>;
+using AllocInfo = std::tuple<
+    std::shared_ptr<Allocator>, TensorAllocMap, BufferOwnerMap,
+    std::shared_ptr<AllocationTracker>>;
+
+// The resources held by an inflight request until the server releases it.
+struct RequestReleaseInfo {
+  // The reservation of the model if model residency is enabled.
+  std::unique_ptr<ResidencyManager::Lease> lease_;
+  // The owners of the input buffers returned to their pool once the request
+  // is released.
+  std::vector<std::shared_ptr<void>> input_owners_;
+};
 
 //==============================================================================
 /// Helper functions
@@ -302,6 +320,94 @@ TritonToMemoryType(const TRITONSERVER_MemoryType& mem_type)
   }
 }
 
+DataType
+DLPackToDataType(const DLDataType& dtype) noexcept
+{
+  if (dtype.lanes != 1) {
+    return DataType::INVALID;
+  }
+  switch (dtype.code) {
+    case kDLBool:
+      return (dtype.bits == 8) ? DataType::BOOL : DataType::INVALID;
+    case kDLUInt:
+      switch (dtype.bits) {
+        case 8:
+          return DataType::UINT8;
+        case 16:
+          return DataType::UINT16;
+        case 32:
+          return DataType::UINT32;
+        case 64:
+          return DataType::UINT64;
+      }
+      break;
+    case kDLInt:
+      switch (dtype.bits) {
+        case 8:
+          return DataType::INT8;
+        case 16:
+          return DataType::INT16;
+        case 32:
+          return DataType::INT32;
+        case 64:
+          return DataType::INT64;
+      }
+      break;
+    case kDLFloat:
+      switch (dtype.bits) {
+        case 16:
+          return DataType::FP16;
+        case 32:
+          return DataType::FP32;
+        case 64:
+          return DataType::FP64;
+      }
+      break;
+    case kDLBfloat:
+      return (dtype.bits == 16) ? DataType::BF16 : DataType::INVALID;
+  }
+  return DataType::INVALID;
+}
+
+DLDataType
+DataTypeToDLPack(const DataType& dtype)
+{
+  DLDataType dl_dtype;
+  dl_dtype.lanes = 1;
+  switch (dtype) {
+    case DataType::BOOL:
+      dl_dtype.code = kDLBool;
+      break;
+    case DataType::UINT8:
+    case DataType::UINT16:
+    case DataType::UINT32:
+    case DataType::UINT64:
+      dl_dtype.code = kDLUInt;
+      break;
+    case DataType::INT8:
+    case DataType::INT16:
+    case DataType::INT32:
+    case DataType::INT64:
+      dl_dtype.code = kDLInt;
+      break;
+    case DataType::FP16:
+    case DataType::FP32:
+    case DataType::FP64:
+      dl_dtype.code = kDLFloat;
+      break;
+    case DataType::BF16:
+      dl_dtype.code = kDLBfloat;
+      break;
+
+    default:
+      throw TritonException(
+          "data type '" + DataTypeString(dtype) +
+          "' is not supported by DLPack.");
+  }
+  dl_dtype.bits = TRITONSERVER_DataTypeByteSize(ToTritonDataType(dtype)) * 8;
+  return dl_dtype;
+}
+
 ModelReadyState
 StringToModelReadyState(const std::string& state) noexcept
 {
@@ -373,6 +479,47 @@ struct ResponseParameters {
   const void* vvalue_;
 };
 
+//==============================================================================
+/// Structure to hold the description of a model input used for generating
+/// warm-up requests.
+struct WarmupInput {
+  explicit WarmupInput(
+      const std::string& name, const DataType& data_type,
+      const std::vector<int64_t>& shape, std::shared_ptr<Tensor> sample)
+      : name_(name), data_type_(data_type), shape_(shape), sample_(sample)
+  {
+  }
+
+  // The name of the input.
+  std::string name_;
+  // The data type of the input.
+  DataType data_type_;
+  // The shape of the input without batch dimension. Variable-size dimensions
+  // are set to 1.
+  std::vector<int64_t> shape_;
+  // The user-provided sample of the input. nullptr if the input is
+  // synthesized.
+  std::shared_ptr<Tensor> sample_;
+};
+
+//==============================================================================
+/// Structure to hold an output exported by 'InferResult::OutputAsDLPack'. The
+/// structure is the manager context of the DLPack tensor and is deleted by the
+/// deleter of it.
+struct DLPackOutput {
+  static void Deleter(DLManagedTensor* self)
+  {
+    delete reinterpret_cast<DLPackOutput*>(self->manager_ctx);
+  }
+
+  // The exported DLPack tensor.
+  DLManagedTensor dl_tensor_;
+  // The output tensor that owns the buffer.
+  std::shared_ptr<Tensor> output_;
+  // The shape referred by the DLPack tensor.
+  std::vector<int64_t> shape_;
+};
+
 //==============================================================================
 /// InternalServer class
 ///
@@ -396,6 +543,18 @@ class InternalServer : public TritonServer {
   static void InferResponseComplete(
       TRITONSERVER_InferenceResponse* response, const uint32_t flags,
       void* userp);
+  // Set 'memory_type' and 'memory_type_id' to the placement preferred in the
+  // 'InferOptions' of 'request' for output 'tensor_name'. Return false and
+  // leave them unchanged if there is no preference.
+  static bool PreferredPlacement(
+      InferRequest* request, const char* tensor_name,
+      TRITONSERVER_MemoryType* memory_type, int64_t* memory_type_id);
+  // Set 'memory_type' and 'memory_type_id' to the placement that
+  // 'ResponseAlloc' will use for output 'tensor_name' of 'request', given the
+  // placement requested by the backend.
+  static void AllocatedPlacement(
+      InferRequest* request, const char* tensor_name,
+      TRITONSERVER_MemoryType* memory_type, int64_t* memory_type_id);
   static void InferRequestComplete(
       TRITONSERVER_InferenceRequest* request, const uint32_t flags,
       void* userp);
@@ -403,7 +562,27 @@ class InternalServer : public TritonServer {
   std::future<std::unique_ptr<InferResult>> AsyncInfer(
       InferRequest& infer_request) override;
 
+  std::shared_ptr<ResponseStream> InferStream(
+      InferRequest& infer_request, const size_t capacity) override;
+
  private:
+  // Send the inference request to the server, after loading the model first
+  // if model residency is enabled.
+  void StartInfer(InferRequest& infer_request) override;
+
+  // Return an error result for a request that failed before reaching the
+  // server.
+  static void CompleteWithError(
+      InferRequest& infer_request, const std::string& error_msg);
+
+  // Send the inference request to the server. The promise of the first result
+  // must already be stored in 'infer_request'. 'lease' is the reservation of
+  // the model if model residency is enabled, and is released when the request
+  // is released by the server.
+  void SubmitInfer(
+      InferRequest& infer_request,
+      std::unique_ptr<ResidencyManager::Lease> lease);
+
   void StartRepoPollThread();
   void StopRepoPollThread();
 
@@ -441,6 +620,9 @@ class InternalResult : public InferResult {
 
   void FinalizeResponse(
       TRITONSERVER_InferenceResponse* response, const AllocInfo& alloc_info);
+
+  // Finalize a result for a request that failed before reaching the server.
+  void FinalizeError(const std::string& error_msg);
 };
 
 //==============================================================================
@@ -457,13 +639,15 @@ InternalServer::ResponseAlloc(
   auto p = reinterpret_cast<InferRequest*>(userp);
   if ((p->tensor_alloc_map_.find(tensor_name) != p->tensor_alloc_map_.end() &&
        std::get<0>(p->tensor_alloc_map_[tensor_name]) != nullptr)) {
-    if (byte_size != std::get<1>(p->tensor_alloc_map_[tensor_name])) {
+    // The byte size of the pre-allocated buffer is a capacity, the actual
+    // byte size of the output is reported in the response.
+    if (byte_size > std::get<1>(p->tensor_alloc_map_[tensor_name])) {
       return TRITONSERVER_ErrorNew(
           TRITONSERVER_ERROR_INTERNAL,
           std::string(
-              "Unexpected byte-size of pre-allocated buffer for '" +
-              std::string(tensor_name) + "'. Expected " +
-              std::to_string(byte_size) + ", got " +
+              "Pre-allocated buffer for '" + std::string(tensor_name) +
+              "' is too small. Expected at least " +
+              std::to_string(byte_size) + " bytes, got " +
               std::to_string(std::get<1>(p->tensor_alloc_map_[tensor_name])))
               .c_str());
     }
@@ -475,9 +659,12 @@ InternalServer::ResponseAlloc(
     *actual_memory_type_id = std::get<3>(p->tensor_alloc_map_[tensor_name]);
   } else {
     // Initially attempt to make the actual memory type and id that we
-    // allocate be the same as preferred memory type
+    // allocate be the same as preferred memory type, unless the request
+    // prefers another placement for the output.
     *actual_memory_type = preferred_memory_type;
     *actual_memory_type_id = preferred_memory_type_id;
+    PreferredPlacement(
+        p, tensor_name, actual_memory_type, actual_memory_type_id);
 
     // If 'byte_size' is zero just return 'buffer' == nullptr, we don't
     // need to do any other book-keeping.
@@ -555,6 +742,11 @@ InternalServer::ResponseAlloc(
       // releasing the buffer.
       if (allocated_ptr != nullptr) {
         *buffer = allocated_ptr;
+        if (p->allocation_tracker_ != nullptr) {
+          p->allocation_tracker_->Allocated(
+              p->infer_options_->model_name_,
+              TritonToMemoryType(*actual_memory_type), byte_size);
+        }
         LOG_MESSAGE(
             TRITONSERVER_LOG_VERBOSE,
             ("allocated " + std::to_string(byte_size) + " bytes in " +
@@ -568,6 +760,49 @@ InternalServer::ResponseAlloc(
   return nullptr;  // Success
 }
 
+bool
+InternalServer::PreferredPlacement(
+    InferRequest* request, const char* tensor_name,
+    TRITONSERVER_MemoryType* memory_type, int64_t* memory_type_id)
+{
+  if ((request == nullptr) || (tensor_name == nullptr)) {
+    return false;
+  }
+  const auto& placements = request->infer_options_->output_placements_;
+  auto it = placements.find(tensor_name);
+  if (it == placements.end()) {
+    return false;
+  }
+  *memory_type = ToTritonMemoryType(it->second.memory_type_);
+  *memory_type_id = it->second.memory_type_id_;
+  return true;
+}
+
+void
+InternalServer::AllocatedPlacement(
+    InferRequest* request, const char* tensor_name,
+    TRITONSERVER_MemoryType* memory_type, int64_t* memory_type_id)
+{
+  if ((request == nullptr) || (tensor_name == nullptr)) {
+    return;
+  }
+
+  // A pre-allocated buffer is used as is, wherever it lives.
+  auto it = request->tensor_alloc_map_.find(tensor_name);
+  if ((it != request->tensor_alloc_map_.end()) &&
+      (std::get<0>(it->second) != nullptr)) {
+    *memory_type = std::get<2>(it->second);
+    *memory_type_id = std::get<3>(it->second);
+    return;
+  }
+
+  PreferredPlacement(request, tensor_name, memory_type, memory_type_id);
+#ifndef TRITON_ENABLE_GPU
+  // Without GPU support every output is allocated on CPU.
+  *memory_type = TRITONSERVER_MEMORY_CPU;
+#endif  // TRITON_ENABLE_GPU
+}
+
 TRITONSERVER_Error*
 InternalServer::ResponseRelease(
     TRITONSERVER_ResponseAllocator* allocator, void* buffer, void* buffer_userp,
@@ -602,23 +837,17 @@ CustomAllocFn(
     void** buffer_userp, TRITONSERVER_MemoryType* actual_memory_type,
     int64_t* actual_memory_type_id)
 {
-  if (InternalRequest::custom_allocator_->AllocFn() != nullptr) {
-    try {
-      MemoryType preferred_mem_type = TritonToMemoryType(preferred_memory_type);
-      MemoryType actual_mem_type;
-      InternalRequest::custom_allocator_->AllocFn()(
-          tensor_name, byte_size, preferred_mem_type, preferred_memory_type_id,
-          buffer, &actual_mem_type, actual_memory_type_id);
+  try {
+    MemoryType preferred_mem_type = TritonToMemoryType(preferred_memory_type);
+    MemoryType actual_mem_type;
+    InternalRequest::custom_allocator_->Allocate(
+        tensor_name, byte_size, preferred_mem_type, preferred_memory_type_id,
+        buffer, &actual_mem_type, actual_memory_type_id);
 
-      *actual_memory_type = ToTritonMemoryType(actual_mem_type);
-    }
-    catch (const TritonException& ex) {
-      return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INTERNAL, ex.what());
-    }
-  } else {
-    return TRITONSERVER_ErrorNew(
-        TRITONSERVER_ERROR_INTERNAL,
-        "Custom response allocation function is not set.");
+    *actual_memory_type = ToTritonMemoryType(actual_mem_type);
+  }
+  catch (const TritonException& ex) {
+    return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INTERNAL, ex.what());
   }
   *buffer_userp = nullptr;
 
@@ -634,6 +863,11 @@ InternalServer::InferRequestComplete(
         TRITONSERVER_InferenceRequestDelete(request),
         "Failed to delete inference request.");
   }
+  // Release the reservation of the model and the input buffers held by the
+  // request.
+  if (userp != nullptr) {
+    delete reinterpret_cast<RequestReleaseInfo*>(userp);
+  }
 }
 
 void
@@ -646,9 +880,57 @@ InternalServer::InferResponseComplete(
   // the destructor of an output tensor, it will know how to clean the buffer
   // correctly.
   AllocInfo alloc_info(
-      p->infer_options_->custom_allocator_, p->tensor_alloc_map_);
+      p->infer_options_->custom_allocator_, p->tensor_alloc_map_,
+      p->buffer_owners_, p->allocation_tracker_);
   bool is_decoupled = p->is_decoupled_;
 
+  if (p->response_stream_ != nullptr) {
+    // Keep the stream alive as the request may be reused or destroyed once
+    // the final response is retrieved.
+    std::shared_ptr<ResponseStream> stream = p->response_stream_;
+    if (response != nullptr) {
+      std::unique_ptr<InternalResult> result =
+          std::make_unique<InternalResult>();
+      result->FinalizeResponse(response, alloc_info);
+      stream->Push(std::move(result));
+    }
+    if (!is_decoupled ||
+        ((flags & TRITONSERVER_RESPONSE_COMPLETE_FINAL) != 0)) {
+      stream->Finish();
+    }
+    return;
+  }
+
+  if (p->completion_fn_ != nullptr) {
+    std::unique_ptr<InternalResult> result = std::make_unique<InternalResult>();
+    if (response != nullptr) {
+      result->FinalizeResponse(response, alloc_info);
+    }
+    if (is_decoupled) {
+      // Only a single result can be passed to the callback. The responses are
+      // released and an error is reported once the final flag is received.
+      if ((flags & TRITONSERVER_RESPONSE_COMPLETE_FINAL) == 0) {
+        return;
+      }
+      result = std::make_unique<InternalResult>();
+      result->FinalizeError(
+          "Decoupled models are not supported with a completion callback.");
+    } else if (response == nullptr) {
+      result->FinalizeError("Unexpected empty response.");
+    }
+    // Take the callback out of the request as the request may be reused or
+    // destroyed by the callback.
+    std::function<void(std::unique_ptr<InferResult>&&)> completion_fn =
+        std::move(p->completion_fn_);
+    p->completion_fn_ = nullptr;
+    completion_fn(std::move(result));
+    return;
+  }
+
+  // Take the promise out of the request before fulfilling it, as the request
+  // may be reused or destroyed as soon as the result is received.
+  std::unique_ptr<std::promise<std::unique_ptr<InferResult>>> prev_promise =
+      std::move(p->prev_promise_);
   if (response != nullptr) {
     std::unique_ptr<InternalResult> result = std::make_unique<InternalResult>();
     result->FinalizeResponse(response, alloc_info);
@@ -656,8 +938,7 @@ InternalServer::InferResponseComplete(
 
     if (!is_decoupled) {
       infer_result->next_result_future_.reset();
-      p->prev_promise_->set_value(std::move(infer_result));
-      p->prev_promise_.reset();
+      prev_promise->set_value(std::move(infer_result));
     } else {
       if ((flags & TRITONSERVER_RESPONSE_COMPLETE_FINAL) == 0) {
         // Not the last reponse. Need to store the promise associated with the
@@ -666,23 +947,20 @@ InternalServer::InferResponseComplete(
         infer_result->next_result_future_ =
             std::make_unique<std::future<std::unique_ptr<InferResult>>>(
                 promise->get_future());
-        p->prev_promise_->set_value(std::move(infer_result));
         p->prev_promise_.reset(std::move(promise));
+        prev_promise->set_value(std::move(infer_result));
       } else {
         // The last response.
         infer_result->next_result_future_.reset();
-        p->prev_promise_->set_value(std::move(infer_result));
-        p->prev_promise_.reset();
+        prev_promise->set_value(std::move(infer_result));
       }
     }
   } else if (
       is_decoupled && (flags & TRITONSERVER_RESPONSE_COMPLETE_FINAL) != 0) {
     // An empty response may be the last reponse for decoupled models.
-    p->prev_promise_->set_value(nullptr);
-    p->prev_promise_.reset();
+    prev_promise->set_value(nullptr);
   } else {
-    p->prev_promise_->set_value(nullptr);
-    p->prev_promise_.reset();
+    prev_promise->set_value(nullptr);
     throw TritonException("Unexpected empty response.");
   }
 }
@@ -693,8 +971,12 @@ OutputBufferQuery(
     const char* tensor_name, size_t* byte_size,
     TRITONSERVER_MemoryType* memory_type, int64_t* memory_type_id)
 {
-  // Always attempt to return the memory in the requested memory_type and
-  // memory_type_id when using default allocator.
+  // Report the placement that the default allocator will use so that the
+  // backend can produce the output directly in that memory. 'userp' is
+  // nullptr for a custom allocator, which decides the placement itself.
+  InternalServer::AllocatedPlacement(
+      reinterpret_cast<InferRequest*>(userp), tensor_name, memory_type,
+      memory_type_id);
   return nullptr;  // Success
 }
 
@@ -719,7 +1001,7 @@ LoggingOptions::LoggingOptions(
 
 MetricsOptions::MetricsOptions()
     : allow_metrics_(true), allow_gpu_metrics_(true), allow_cpu_metrics_(true),
-      metrics_interval_ms_(2000)
+      metrics_interval_ms_(2000), allow_allocation_metrics_(false)
 {
 }
 
@@ -728,7 +1010,8 @@ MetricsOptions::MetricsOptions(
     const bool allow_cpu_metrics, const uint64_t metrics_interval_ms)
     : allow_metrics_(allow_metrics), allow_gpu_metrics_(allow_gpu_metrics),
       allow_cpu_metrics_(allow_cpu_metrics),
-      metrics_interval_ms_(metrics_interval_ms)
+      metrics_interval_ms_(metrics_interval_ms),
+      allow_allocation_metrics_(false)
 {
 }
 
@@ -794,7 +1077,7 @@ ServerOptions::ServerOptions(
       exit_timeout_secs_(30), buffer_manager_thread_count_(0),
       model_load_thread_count_(
           std::max(2u, 2 * std::thread::hardware_concurrency())),
-      trace_(nullptr)
+      trace_(nullptr), model_residency_(nullptr)
 {
   // FIXME: Use iterator instead of vector for 'model_repository_paths_'.
   be_config_.clear();
@@ -839,7 +1122,40 @@ ServerOptions::ServerOptions(
       buffer_manager_thread_count_(buffer_manager_thread_count),
       model_load_thread_count_(model_load_thread_count),
       model_load_gpu_limit_(model_load_gpu_limit), host_policy_(host_policy),
-      trace_(trace)
+      trace_(trace), model_residency_(nullptr)
+{
+}
+
+ModelResidency::ModelResidency(
+    const uint64_t host_budget_byte_size,
+    const uint64_t device_budget_byte_size)
+    : host_budget_byte_size_(host_budget_byte_size),
+      device_budget_byte_size_(device_budget_byte_size)
+{
+}
+
+ModelResidency::ModelResidency(
+    const uint64_t host_budget_byte_size,
+    const uint64_t device_budget_byte_size,
+    const std::unordered_map<std::string, uint64_t>& host_byte_sizes,
+    const std::unordered_map<std::string, uint64_t>& device_byte_sizes)
+    : host_budget_byte_size_(host_budget_byte_size),
+      device_budget_byte_size_(device_budget_byte_size),
+      host_byte_sizes_(host_byte_sizes), device_byte_sizes_(device_byte_sizes)
+{
+}
+
+ModelResidencyStats::ModelResidencyStats()
+    : hits_(0), load_stalls_(0), loads_(0), load_failures_(0), evictions_(0),
+      load_ns_(0), resident_models_(0), resident_host_byte_size_(0),
+      resident_device_byte_size_(0)
+{
+}
+
+AllocationStats::AllocationStats()
+    : model_name_(""), memory_type_(MemoryType::CPU), live_byte_size_(0),
+      peak_byte_size_(0), allocation_count_(0), allocated_byte_size_(0),
+      allocations_per_sec_(0)
 {
 }
 
@@ -922,23 +1238,228 @@ Tensor::~Tensor()
           break;
       }
     } else {
-      if (custom_allocator_->ReleaseFn() == nullptr) {
-        std::cerr << "error: ReleaseFn() is not set in custom allocator."
-                  << std::endl;
-      } else {
-        try {
-          custom_allocator_->ReleaseFn()(
-              reinterpret_cast<void*>(buffer_), byte_size_, memory_type_,
-              memory_type_id_);
-        }
-        catch (const TritonException& ex) {
-          LOG_MESSAGE(
-              TRITONSERVER_LOG_ERROR,
-              (std::string("error: using custom allocator - ") + ex.what())
-                  .c_str());
+      try {
+        custom_allocator_->Release(
+            reinterpret_cast<void*>(buffer_), byte_size_, memory_type_,
+            memory_type_id_);
+      }
+      catch (const TritonException& ex) {
+        LOG_MESSAGE(
+            TRITONSERVER_LOG_ERROR,
+            (std::string("error: using custom allocator - ") + ex.what())
+                .c_str());
+      }
+    }
+  }
+}
+
+Tensor
+Tensor::FromDLPack(DLManagedTensor* dl_tensor)
+{
+  try {
+    if (dl_tensor == nullptr) {
+      throw TritonException("The DLPack tensor is a nullptr.");
+    }
+    const DLTensor& tensor = dl_tensor->dl_tensor;
+
+    DataType data_type = DLPackToDataType(tensor.dtype);
+    if (data_type == DataType::INVALID) {
+      throw TritonException(
+          "Unsupported DLPack data type (code " +
+          std::to_string(tensor.dtype.code) + ", bits " +
+          std::to_string(tensor.dtype.bits) + ", lanes " +
+          std::to_string(tensor.dtype.lanes) + ").");
+    }
+
+    MemoryType memory_type;
+    int64_t memory_type_id = 0;
+    switch (tensor.device.device_type) {
+      case kDLCPU:
+        memory_type = MemoryType::CPU;
+        break;
+      case kDLCUDAHost:
+        memory_type = MemoryType::CPU_PINNED;
+        break;
+      case kDLCUDA:
+        memory_type = MemoryType::GPU;
+        memory_type_id = tensor.device.device_id;
+        break;
+
+      default:
+        throw TritonException(
+            "Unsupported DLPack device type " +
+            std::to_string(tensor.device.device_type) + ".");
+    }
+
+    std::vector<int64_t> shape(tensor.shape, tensor.shape + tensor.ndim);
+    size_t element_count = 1;
+    for (const auto dim : shape) {
+      if (dim < 0) {
+        throw TritonException("The DLPack tensor has a negative dimension.");
+      }
+      element_count *= dim;
+    }
+
+    // The strides are optional. If provided, they must describe a compact
+    // row-major tensor. The stride of a dimension of size 1 is not used.
+    if (tensor.strides != nullptr) {
+      int64_t expected_stride = 1;
+      for (int32_t i = tensor.ndim - 1; i >= 0; --i) {
+        if ((shape[i] != 1) && (tensor.strides[i] != expected_stride)) {
+          throw TritonException(
+              "Only compact row-major DLPack tensors are supported.");
         }
+        expected_stride *= shape[i];
+      }
+    }
+
+    Tensor result(
+        reinterpret_cast<char*>(tensor.data) + tensor.byte_offset,
+        element_count * (tensor.dtype.bits / 8), data_type, shape,
+        memory_type, memory_type_id);
+    result.buffer_owner_.reset(dl_tensor, [](DLManagedTensor* ptr) {
+      if (ptr->deleter != nullptr) {
+        ptr->deleter(ptr);
+      }
+    });
+
+    return result;
+  }
+  catch (const TritonException& ex) {
+    throw TritonException(std::string("Error - FromDLPack: ") + ex.what());
+  }
+}
+
+Tensor
+Tensor::FromFile(
+    const std::string& path, const DataType& data_type,
+    const std::vector<int64_t>& shape, const size_t offset)
+{
+  try {
+    const uint32_t element_byte_size =
+        TRITONSERVER_DataTypeByteSize(ToTritonDataType(data_type));
+    if (element_byte_size == 0) {
+      throw TritonException(
+          "Data type '" + DataTypeString(data_type) +
+          "' is not supported for memory-mapped files.");
+    }
+    size_t byte_size = element_byte_size;
+    for (const auto dim : shape) {
+      if (dim < 0) {
+        throw TritonException("The shape has a negative dimension.");
+      }
+      byte_size *= dim;
+    }
+    if (byte_size == 0) {
+      throw TritonException("The tensor is empty.");
+    }
+
+    std::shared_ptr<MappedFile> file =
+        MappedFile::OpenRead(path, offset, byte_size);
+    Tensor tensor(
+        file->Data(), byte_size, data_type, shape, MemoryType::CPU, 0);
+    tensor.buffer_owner_ = file;
+
+    return tensor;
+  }
+  catch (const TritonException& ex) {
+    throw TritonException(std::string("Error - FromFile: ") + ex.what());
+  }
+}
+
+Tensor
+Tensor::FromNpyFile(const std::string& path)
+{
+  try {
+    // The format is described in
+    // https://numpy.org/doc/stable/reference/generated/numpy.lib.format.html.
+    // The header is a Python dict literal such as
+    // "{'descr': '<f4', 'fortran_order': False, 'shape': (3, 4), }".
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+      throw TritonException("Failed to open '" + path + "'.");
+    }
+    char preamble[8];
+    if (!file.read(preamble, sizeof(preamble)) ||
+        (std::string(preamble, 6) != "\x93NUMPY")) {
+      throw TritonException("'" + path + "' is not a '.npy' file.");
+    }
+    // The header length is a little-endian uint16 in version 1.0 and a
+    // little-endian uint32 in the later versions.
+    const size_t len_byte_size = (preamble[6] == 1) ? 2 : 4;
+    char len_bytes[4];
+    if (!file.read(len_bytes, len_byte_size)) {
+      throw TritonException("Truncated header in '" + path + "'.");
+    }
+    size_t header_len = 0;
+    for (size_t i = 0; i < len_byte_size; ++i) {
+      header_len |= static_cast<size_t>(static_cast<uint8_t>(len_bytes[i]))
+                    << (8 * i);
+    }
+    const size_t header_offset = sizeof(preamble) + len_byte_size;
+    std::string header(header_len, '\0');
+    if (!file.read(&header[0], header_len)) {
+      throw TritonException("Truncated header in '" + path + "'.");
+    }
+
+    auto value_of = [&header, &path](const std::string& key) {
+      size_t pos = header.find("'" + key + "'");
+      if (pos == std::string::npos) {
+        throw TritonException(
+            "Missing '" + key + "' in the header of '" + path + "'.");
+      }
+      pos = header.find(':', pos);
+      return header.find_first_not_of(' ', pos + 1);
+    };
+
+    size_t pos = value_of("fortran_order");
+    if (header.compare(pos, 5, "False") != 0) {
+      throw TritonException(
+          "Fortran-ordered array in '" + path + "' is not supported.");
+    }
+
+    pos = value_of("descr");
+    const size_t descr_end = header.find(header[pos], pos + 1);
+    const std::string descr = header.substr(pos + 1, descr_end - pos - 1);
+    static const std::unordered_map<std::string, DataType> descr_types{
+        {"b1", DataType::BOOL},  {"u1", DataType::UINT8},
+        {"u2", DataType::UINT16}, {"u4", DataType::UINT32},
+        {"u8", DataType::UINT64}, {"i1", DataType::INT8},
+        {"i2", DataType::INT16},  {"i4", DataType::INT32},
+        {"i8", DataType::INT64},  {"f2", DataType::FP16},
+        {"f4", DataType::FP32},   {"f8", DataType::FP64}};
+    auto it = (descr.size() == 3) ? descr_types.find(descr.substr(1))
+                                  : descr_types.end();
+    // Only the native little-endian byte order is supported for multi-byte
+    // types.
+    const bool byte_order_ok =
+        (descr[0] == '<') || (descr[0] == '|') ||
+        ((descr[0] == '>') && (descr.substr(2) == "1"));
+    if ((it == descr_types.end()) || !byte_order_ok) {
+      throw TritonException(
+          "Data type '" + descr + "' in '" + path + "' is not supported.");
+    }
+
+    pos = value_of("shape");
+    const size_t shape_end = header.find(')', pos);
+    std::stringstream shape_ss(header.substr(pos + 1, shape_end - pos - 1));
+    std::vector<int64_t> shape;
+    std::string dim;
+    while (std::getline(shape_ss, dim, ',')) {
+      if (dim.find_first_not_of(' ') != std::string::npos) {
+        shape.push_back(std::stoll(dim));
       }
     }
+
+    return FromFile(path, it->second, shape, header_offset + header_len);
+  }
+  catch (const std::logic_error& ex) {
+    throw TritonException(
+        std::string("Error - FromNpyFile: Invalid header in '") + path +
+        "': " + ex.what());
+  }
+  catch (const TritonException& ex) {
+    throw TritonException(std::string("Error - FromNpyFile: ") + ex.what());
   }
 }
 
@@ -954,6 +1475,23 @@ NewModelRepo::NewModelRepo(
 {
 }
 
+WarmupOptions::WarmupOptions() : model_version_(-1), iterations_(5) {}
+
+WarmupOptions::WarmupOptions(
+    const int64_t model_version, const std::vector<int64_t>& batch_sizes,
+    const uint32_t iterations,
+    const std::unordered_map<std::string, std::shared_ptr<Tensor>>& samples)
+    : model_version_(model_version), batch_sizes_(batch_sizes),
+      iterations_(iterations), samples_(samples)
+{
+}
+
+WarmupStats::WarmupStats(const int64_t batch_size)
+    : batch_size_(batch_size), count_(0), first_ns_(0), min_ns_(UINT64_MAX),
+      max_ns_(0), total_ns_(0)
+{
+}
+
 InferOptions::InferOptions(const std::string& model_name)
     : model_name_(model_name), model_version_(-1), request_id_(""),
       correlation_id_(0), correlation_id_str_(""), sequence_start_(false),
@@ -978,6 +1516,12 @@ InferOptions::InferOptions(
 {
 }
 
+OutputPlacement::OutputPlacement(
+    const MemoryType& memory_type, const int64_t memory_type_id)
+    : memory_type_(memory_type), memory_type_id_(memory_type_id)
+{
+}
+
 std::unique_ptr<TritonServer>
 TritonServer::Create(const ServerOptions& options)
 {
@@ -1000,68 +1544,396 @@ TritonServer::LoadModel(const std::string& model_name)
   }
 }
 
-void
-TritonServer::UnloadModel(const std::string& model_name)
+std::vector<WarmupStats>
+TritonServer::LoadModel(
+    const std::string& model_name, const WarmupOptions& warmup_options)
 {
-  try {
-    THROW_IF_TRITON_ERR(TRITONSERVER_ServerUnloadModelAndDependents(
-        server_.get(), model_name.c_str()));
-  }
-  catch (const TritonException& ex) {
-    throw TritonException(std::string("Error - UnloadModel: ") + ex.what());
+  {
+    // Hide the model from the callers until the warm-up is completed.
+    std::lock_guard<std::mutex> lk(warmup_mu_);
+    warming_up_models_.insert(model_name);
   }
-}
+  auto unmark = [this, &model_name]() {
+    std::lock_guard<std::mutex> lk(warmup_mu_);
+    warming_up_models_.erase(warming_up_models_.find(model_name));
+  };
 
-std::set<std::string>
-TritonServer::LoadedModels()
-{
+  std::vector<WarmupStats> warmup_stats;
   try {
-    std::vector<RepositoryIndex> repository_index = ModelIndex();
-    std::set<std::string> models;
-    for (size_t i = 0; i < repository_index.size(); i++) {
-      models.insert(repository_index[i].name_);
-    }
-    return models;
+    LoadModel(model_name);
+    warmup_stats = WarmupModel(model_name, warmup_options);
   }
-  catch (const TritonException& ex) {
-    throw TritonException(std::string("Error - LoadedModels: ") + ex.what());
+  catch (...) {
+    unmark();
+    throw;
   }
+  unmark();
+
+  return warmup_stats;
 }
 
-std::vector<RepositoryIndex>
-TritonServer::ModelIndex()
+std::vector<WarmupStats>
+TritonServer::WarmupModel(
+    const std::string& model_name, const WarmupOptions& warmup_options)
 {
-  std::vector<RepositoryIndex> repository_index;
-  TRITONSERVER_Message* message = nullptr;
-  uint32_t flags = TRITONSERVER_INDEX_FLAG_READY;
+  // Every warm-up adds its own marker and removes only that one, so that the
+  // model stays hidden until all the concurrent warm-ups of it complete.
+  {
+    std::lock_guard<std::mutex> lk(warmup_mu_);
+    warming_up_models_.insert(model_name);
+  }
+  auto unmark = [this, &model_name]() {
+    std::lock_guard<std::mutex> lk(warmup_mu_);
+    warming_up_models_.erase(warming_up_models_.find(model_name));
+  };
+
+  std::vector<WarmupStats> warmup_stats;
   try {
+    const int64_t model_version = warmup_options.model_version_;
+    common::TritonJson::Value config;
+    std::string config_str = ModelConfig(model_name, model_version);
+    THROW_IF_TRITON_ERR(config.Parse(config_str.c_str(), config_str.size()));
+    int64_t max_batch_size = 0;
+    if (config.Find("max_batch_size")) {
+      THROW_IF_TRITON_ERR(
+          config.MemberAsInt("max_batch_size", &max_batch_size));
+    }
+
+    // Batch size 0 indicates that the inputs have no batch dimension.
+    std::vector<int64_t> batch_sizes;
+    if (max_batch_size <= 0) {
+      batch_sizes.push_back(0);
+    } else if (warmup_options.batch_sizes_.empty()) {
+      for (int64_t bs = 1; bs < max_batch_size; bs *= 2) {
+        batch_sizes.push_back(bs);
+      }
+      batch_sizes.push_back(max_batch_size);
+    } else {
+      for (const auto bs : warmup_options.batch_sizes_) {
+        if ((bs > 0) && (bs <= max_batch_size)) {
+          batch_sizes.push_back(bs);
+        }
+      }
+    }
+
+    common::TritonJson::Value metadata;
+    std::string metadata_str = ModelMetadata(model_name, model_version);
     THROW_IF_TRITON_ERR(
-        TRITONSERVER_ServerModelIndex(server_.get(), flags, &message));
-    const char* buffer;
-    size_t byte_size;
-    THROW_IF_TRITON_ERR(
-        TRITONSERVER_MessageSerializeToJson(message, &buffer, &byte_size));
+        metadata.Parse(metadata_str.c_str(), metadata_str.size()));
+    common::TritonJson::Value inputs_json;
+    THROW_IF_TRITON_ERR(metadata.MemberAsArray("inputs", &inputs_json));
+
+    std::vector<WarmupInput> inputs;
+    for (size_t i = 0; i < inputs_json.ArraySize(); i++) {
+      common::TritonJson::Value input_json;
+      THROW_IF_TRITON_ERR(inputs_json.IndexAsObject(i, &input_json));
+      std::string name, datatype;
+      THROW_IF_TRITON_ERR(input_json.MemberAsString("name", &name));
+      THROW_IF_TRITON_ERR(input_json.MemberAsString("datatype", &datatype));
+      common::TritonJson::Value shape_json;
+      THROW_IF_TRITON_ERR(input_json.MemberAsArray("shape", &shape_json));
+      // The shape in model metadata includes the batch dimension if the model
+      // supports batching.
+      std::vector<int64_t> shape;
+      for (size_t j = (max_batch_size > 0) ? 1 : 0;
+           j < shape_json.ArraySize(); j++) {
+        int64_t dim;
+        THROW_IF_TRITON_ERR(shape_json.IndexAsInt(j, &dim));
+        shape.push_back((dim < 0) ? 1 : dim);
+      }
 
-    common::TritonJson::Value repo_index;
-    THROW_IF_TRITON_ERR(repo_index.Parse(buffer, byte_size));
-    THROW_IF_TRITON_ERR(TRITONSERVER_MessageDelete(message));
+      std::shared_ptr<Tensor> sample;
+      auto it = warmup_options.samples_.find(name);
+      if (it != warmup_options.samples_.end()) {
+        sample = it->second;
+        if ((sample->memory_type_ == MemoryType::GPU) ||
+            ((sample->byte_size_ != 0) && (sample->buffer_ == nullptr))) {
+          throw TritonException(
+              "Warm-up sample for input '" + name +
+              "' must be a non-empty buffer in CPU memory.");
+        }
+        if ((max_batch_size > 0) &&
+            (sample->shape_.empty() || (sample->shape_[0] != 1))) {
+          throw TritonException(
+              "Warm-up sample for input '" + name +
+              "' must have a batch dimension of 1.");
+        }
+      }
+      inputs.emplace_back(
+          name, TritonToDataType(TRITONSERVER_StringToDataType(
+                    datatype.c_str())),
+          shape, sample);
+    }
 
-    for (size_t i = 0; i < repo_index.ArraySize(); i++) {
-      triton::common::TritonJson::Value index;
-      THROW_IF_TRITON_ERR(repo_index.IndexAsObject(i, &index));
-      std::string name, version, state;
-      THROW_IF_TRITON_ERR(index.MemberAsString("name", &name));
-      THROW_IF_TRITON_ERR(index.MemberAsString("version", &version));
-      THROW_IF_TRITON_ERR(index.MemberAsString("state", &state));
-      repository_index.push_back(
-          RepositoryIndex(name, version, StringToModelReadyState(state)));
+    for (const auto batch_size : batch_sizes) {
+      const size_t batch_count = std::max<int64_t>(1, batch_size);
+      // Prepare the input buffers once for all iterations of this batch size.
+      std::list<std::vector<char>> buffers;
+      std::vector<std::unique_ptr<Tensor>> tensors;
+      for (const auto& input : inputs) {
+        buffers.emplace_back();
+        std::vector<char>& buffer = buffers.back();
+        std::vector<int64_t> shape;
+        if (input.sample_ != nullptr) {
+          shape = input.sample_->shape_;
+          if (batch_size > 0) {
+            shape[0] = batch_size;
+          }
+          for (size_t b = 0; b < batch_count; b++) {
+            buffer.insert(
+                buffer.end(), input.sample_->buffer_,
+                input.sample_->buffer_ + input.sample_->byte_size_);
+          }
+        } else {
+          if (batch_size > 0) {
+            shape.push_back(batch_size);
+          }
+          shape.insert(shape.end(), input.shape_.begin(), input.shape_.end());
+          size_t element_count = 1;
+          for (const auto dim : shape) {
+            element_count *= dim;
+          }
+          // Each zero-filled BYTES element is a 4-byte length prefix of an
+          // empty string.
+          size_t element_byte_size =
+              (input.data_type_ == DataType::BYTES)
+                  ? sizeof(uint32_t)
+                  : TRITONSERVER_DataTypeByteSize(
+                        ToTritonDataType(input.data_type_));
+          buffer.resize(element_count * element_byte_size, 0);
+        }
+        tensors.emplace_back(new Tensor(
+            buffer.data(), buffer.size(), input.data_type_, shape,
+            MemoryType::CPU, 0));
+      }
+
+      WarmupStats stats(batch_size);
+      for (uint32_t iter = 0; iter < warmup_options.iterations_; iter++) {
+        InferOptions infer_options(model_name);
+        infer_options.model_version_ = model_version;
+        infer_options.request_id_ = "warmup";
+        std::unique_ptr<InferRequest> request =
+            InferRequest::Create(infer_options);
+        for (size_t i = 0; i < inputs.size(); i++) {
+          request->AddInput(inputs[i].name_, *tensors[i]);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::unique_ptr<InferResult> result = AsyncInfer(*request).get();
+        // Wait for all the responses if the model is decoupled.
+        while (result != nullptr) {
+          if (result->HasError()) {
+            throw TritonException(result->ErrorMsg());
+          }
+          auto next_result_future = result->GetNextResult();
+          if (next_result_future == nullptr) {
+            break;
+          }
+          result = next_result_future->get();
+        }
+        uint64_t latency_ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+
+        if (stats.count_ == 0) {
+          stats.first_ns_ = latency_ns;
+        }
+        stats.count_++;
+        stats.min_ns_ = std::min(stats.min_ns_, latency_ns);
+        stats.max_ns_ = std::max(stats.max_ns_, latency_ns);
+        stats.total_ns_ += latency_ns;
+      }
+      if (stats.count_ == 0) {
+        stats.min_ns_ = 0;
+      }
+      warmup_stats.push_back(stats);
+
+      LOG_MESSAGE(
+          TRITONSERVER_LOG_VERBOSE,
+          ("Warm-up of model '" + model_name + "' with batch size " +
+           std::to_string(batch_size) + ": " + std::to_string(stats.count_) +
+           " inferences, first " + std::to_string(stats.first_ns_) +
+           " ns, max " + std::to_string(stats.max_ns_) + " ns")
+              .c_str());
     }
   }
   catch (const TritonException& ex) {
-    throw TritonException(std::string("Error - ModelIndex: ") + ex.what());
+    unmark();
+    throw TritonException(std::string("Error - WarmupModel: ") + ex.what());
+  }
+  catch (...) {
+    // Never leave the model hidden from the ready listing.
+    unmark();
+    throw;
   }
 
-  return repository_index;
+  std::lock_guard<std::mutex> lk(warmup_mu_);
+  warming_up_models_.erase(warming_up_models_.find(model_name));
+  warmup_stats_[model_name] = warmup_stats;
+
+  return warmup_stats;
+}
+
+std::vector<WarmupStats>
+TritonServer::WarmupStatistics(const std::string& model_name)
+{
+  std::lock_guard<std::mutex> lk(warmup_mu_);
+  auto it = warmup_stats_.find(model_name);
+  if (it == warmup_stats_.end()) {
+    return std::vector<WarmupStats>();
+  }
+
+  return it->second;
+}
+
+void
+TritonServer::UnloadModel(const std::string& model_name)
+{
+  try {
+    THROW_IF_TRITON_ERR(TRITONSERVER_ServerUnloadModelAndDependents(
+        server_.get(), model_name.c_str()));
+    if (residency_manager_ != nullptr) {
+      residency_manager_->Forget(model_name);
+    }
+  }
+  catch (const TritonException& ex) {
+    throw TritonException(std::string("Error - UnloadModel: ") + ex.what());
+  }
+}
+
+ModelResidencyStats
+TritonServer::ModelResidencyStatistics()
+{
+  if (residency_manager_ == nullptr) {
+    throw TritonException(
+        "Error - ModelResidencyStatistics: model residency is not enabled.");
+  }
+
+  ResidencyManager::Counters counters = residency_manager_->Statistics();
+  ModelResidencyStats stats;
+  stats.hits_ = counters.hits_;
+  stats.load_stalls_ = counters.load_stalls_;
+  stats.loads_ = counters.loads_;
+  stats.load_failures_ = counters.load_failures_;
+  stats.evictions_ = counters.evictions_;
+  stats.load_ns_ = counters.load_ns_;
+  stats.resident_models_ = counters.resident_models_;
+  stats.resident_host_byte_size_ = counters.resident_host_byte_size_;
+  stats.resident_device_byte_size_ = counters.resident_device_byte_size_;
+  return stats;
+}
+
+std::vector<AllocationStats>
+TritonServer::AllocationStatistics()
+{
+  const uint64_t elapsed_ns = allocation_tracker_->ElapsedNs();
+  std::vector<AllocationStats> allocation_stats;
+  for (const auto& counters : allocation_tracker_->Statistics()) {
+    AllocationStats stats;
+    stats.model_name_ = counters.first.first;
+    stats.memory_type_ = counters.first.second;
+    stats.live_byte_size_ = counters.second.live_byte_size_;
+    stats.peak_byte_size_ = counters.second.peak_byte_size_;
+    stats.allocation_count_ = counters.second.allocation_count_;
+    stats.allocated_byte_size_ = counters.second.allocated_byte_size_;
+    if (elapsed_ns > 0) {
+      stats.allocations_per_sec_ =
+          counters.second.allocation_count_ * 1e9 / elapsed_ns;
+    }
+    stats.size_histogram_ = counters.second.histogram_;
+    allocation_stats.push_back(stats);
+  }
+  return allocation_stats;
+}
+
+std::set<std::string>
+TritonServer::LoadedModels()
+{
+  try {
+    std::vector<RepositoryIndex> repository_index = ModelIndex();
+    std::set<std::string> models;
+    std::lock_guard<std::mutex> lk(warmup_mu_);
+    for (size_t i = 0; i < repository_index.size(); i++) {
+      if (warming_up_models_.find(repository_index[i].name_) ==
+          warming_up_models_.end()) {
+        models.insert(repository_index[i].name_);
+      }
+    }
+    return models;
+  }
+  catch (const TritonException& ex) {
+    throw TritonException(std::string("Error - LoadedModels: ") + ex.what());
+  }
+}
+
+// Read the repository index of the server with the given
+// 'TRITONSERVER_ModelIndexFlag' flags.
+std::vector<RepositoryIndex>
+ReadModelIndex(TRITONSERVER_Server* server, const uint32_t flags)
+{
+  std::vector<RepositoryIndex> repository_index;
+  TRITONSERVER_Message* message = nullptr;
+  THROW_IF_TRITON_ERR(TRITONSERVER_ServerModelIndex(server, flags, &message));
+  const char* buffer;
+  size_t byte_size;
+  THROW_IF_TRITON_ERR(
+      TRITONSERVER_MessageSerializeToJson(message, &buffer, &byte_size));
+
+  common::TritonJson::Value repo_index;
+  THROW_IF_TRITON_ERR(repo_index.Parse(buffer, byte_size));
+  THROW_IF_TRITON_ERR(TRITONSERVER_MessageDelete(message));
+
+  for (size_t i = 0; i < repo_index.ArraySize(); i++) {
+    triton::common::TritonJson::Value index;
+    THROW_IF_TRITON_ERR(repo_index.IndexAsObject(i, &index));
+    std::string name, version, state;
+    THROW_IF_TRITON_ERR(index.MemberAsString("name", &name));
+    // Models that have never been loaded have no version or state.
+    if (index.Find("version")) {
+      THROW_IF_TRITON_ERR(index.MemberAsString("version", &version));
+    }
+    if (index.Find("state")) {
+      THROW_IF_TRITON_ERR(index.MemberAsString("state", &state));
+    }
+    repository_index.push_back(
+        RepositoryIndex(name, version, StringToModelReadyState(state)));
+  }
+  return repository_index;
+}
+
+// Block until no version of the model is ready or being unloaded. Unloading
+// a model only starts the unload, which completes once the requests in
+// flight are done and the model instances are released.
+void
+WaitForModelUnload(TRITONSERVER_Server* server, const std::string& model_name)
+{
+  while (true) {
+    bool unloaded = true;
+    for (const auto& index : ReadModelIndex(server, 0 /* flags */)) {
+      if ((index.name_ == model_name) &&
+          ((index.state_ == ModelReadyState::READY) ||
+           (index.state_ == ModelReadyState::UNLOADING))) {
+        unloaded = false;
+        break;
+      }
+    }
+    if (unloaded) {
+      return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
+std::vector<RepositoryIndex>
+TritonServer::ModelIndex()
+{
+  try {
+    return ReadModelIndex(server_.get(), TRITONSERVER_INDEX_FLAG_READY);
+  }
+  catch (const TritonException& ex) {
+    throw TritonException(std::string("Error - ModelIndex: ") + ex.what());
+  }
 }
 
 std::string
@@ -1151,6 +2023,14 @@ bool
 TritonServer::IsModelReady(
     const std::string& model_name, const int64_t model_version)
 {
+  {
+    // The model is not ready to the callers until the warm-up is completed.
+    std::lock_guard<std::mutex> lk(warmup_mu_);
+    if (warming_up_models_.find(model_name) != warming_up_models_.end()) {
+      return false;
+    }
+  }
+
   bool ready = false;
   try {
     THROW_IF_TRITON_ERR(TRITONSERVER_ServerModelIsReady(
@@ -1273,6 +2153,77 @@ TritonServer::UnregisterModelRepo(const std::string& repo_path)
   }
 }
 
+void
+TritonServer::StartRecording(const std::string& path, const uint32_t rate)
+{
+  try {
+    std::shared_ptr<RequestRecorder> recorder =
+        std::make_shared<RequestRecorder>(path, rate);
+    std::atomic_store(&recorder_, recorder);
+  }
+  catch (const TritonException& ex) {
+    throw TritonException(std::string("Error - StartRecording: ") + ex.what());
+  }
+}
+
+void
+TritonServer::StopRecording()
+{
+  std::atomic_store(&recorder_, std::shared_ptr<RequestRecorder>());
+}
+
+void
+TritonServer::RecordRequest(const InferRequest& infer_request)
+{
+  std::shared_ptr<RequestRecorder> recorder = std::atomic_load(&recorder_);
+  uint64_t arrival_ns = 0;
+  if ((recorder == nullptr) || !recorder->Sample(&arrival_ns)) {
+    return;
+  }
+
+  const InferOptions& options = *(infer_request.infer_options_);
+  RecordedRequest record;
+  record.arrival_ns_ = arrival_ns;
+  record.model_name_ = options.model_name_;
+  record.model_version_ = options.model_version_;
+  record.request_id_ = options.request_id_;
+  record.correlation_id_ = options.correlation_id_;
+  record.correlation_id_str_ = options.correlation_id_str_;
+  record.sequence_start_ = options.sequence_start_;
+  record.sequence_end_ = options.sequence_end_;
+  record.priority_ = options.priority_;
+  record.request_timeout_ = options.request_timeout_;
+  for (const auto& input : infer_request.inputs_) {
+    if (input.second->memory_type_ == MemoryType::GPU) {
+      LOG_MESSAGE(
+          TRITONSERVER_LOG_WARN,
+          ("Request to model '" + options.model_name_ +
+           "' is not recorded as input '" + input.first +
+           "' is in GPU memory.")
+              .c_str());
+      return;
+    }
+    RecordedRequest::Input recorded_input;
+    recorded_input.name_ = input.first;
+    recorded_input.data_type_ = input.second->data_type_;
+    recorded_input.shape_ = input.second->shape_;
+    recorded_input.data_.assign(
+        input.second->buffer_, input.second->byte_size_);
+    record.inputs_.emplace_back(std::move(recorded_input));
+  }
+  for (const auto& output : infer_request.outputs_) {
+    record.output_names_.push_back(output.first);
+  }
+
+  try {
+    recorder->Write(record);
+  }
+  catch (const TritonException& ex) {
+    // Recording must not fail the inference.
+    LOG_MESSAGE(TRITONSERVER_LOG_WARN, ex.what());
+  }
+}
+
 void
 TritonServer::PrepareInferenceRequest(
     TRITONSERVER_InferenceRequest** irequest, const InferRequest& request)
@@ -1348,14 +2299,15 @@ TritonServer::PrepareInferenceOutput(
 {
   try {
     for (auto& infer_output : request.outputs_) {
-      const char* name = infer_output->Name().c_str();
+      const char* name = infer_output.first.c_str();
+      InferRequestedOutput& output = *(infer_output.second);
       THROW_IF_TRITON_ERR(
           TRITONSERVER_InferenceRequestAddRequestedOutput(irequest, name));
-      if (infer_output->Buffer() != nullptr) {
+      if (output.Buffer() != nullptr) {
         request.tensor_alloc_map_[name] = std::make_tuple(
-            infer_output->Buffer(), infer_output->ByteSize(),
-            ToTritonMemoryType(infer_output->GetMemoryType()),
-            infer_output->MemoryTypeId());
+            output.Buffer(), output.ByteSize(),
+            ToTritonMemoryType(output.GetMemoryType()),
+            output.MemoryTypeId());
       }
     }
   }
@@ -1562,11 +2514,52 @@ InternalServer::InternalServer(const ServerOptions& options)
     trace_manager_ = nullptr;
   }
 
+  // Initialize residency manager
+  if (options.model_residency_) {
+    if (model_control_mode != TRITONSERVER_MODEL_CONTROL_EXPLICIT) {
+      throw TritonException(
+          "model residency is only available in EXPLICIT model control mode");
+    }
+    residency_manager_ = std::make_shared<ResidencyManager>(
+        options.model_residency_->host_budget_byte_size_,
+        options.model_residency_->device_budget_byte_size_,
+        options.model_residency_->host_byte_sizes_,
+        options.model_residency_->device_byte_sizes_,
+        [this](const std::string& model_name) { LoadModel(model_name); },
+        [this](const std::string& model_name) {
+          THROW_IF_TRITON_ERR(TRITONSERVER_ServerUnloadModelAndDependents(
+              server_.get(), model_name.c_str()));
+          // Only report the eviction once the memory of the model is
+          // released, so that it is not counted against the next load.
+          WaitForModelUnload(server_.get(), model_name);
+        },
+        [this](const std::string& model_name) {
+          bool ready = false;
+          THROW_IF_TRITON_ERR(TRITONSERVER_ServerModelIsReady(
+              server_.get(), model_name.c_str(), -1 /* model_version */,
+              &ready));
+          return ready;
+        });
+  } else {
+    residency_manager_ = nullptr;
+  }
+
+  // Initialize the accounting of the output buffers
+  allocation_tracker_ = std::make_shared<AllocationTracker>(
+      options.metrics_.allow_metrics_ &&
+      options.metrics_.allow_allocation_metrics_);
+
   StartRepoPollThread();
 }
 
 InternalServer::~InternalServer()
 {
+  // Stop loading models before tearing down the allocator used by the
+  // requests queued behind a model load.
+  if (residency_manager_ != nullptr) {
+    residency_manager_->Stop();
+  }
+
   if (allocator_ != nullptr) {
     LOG_IF_ERROR(
         TRITONSERVER_ResponseAllocatorDelete(allocator_),
@@ -1605,7 +2598,110 @@ InternalServer::StopRepoPollThread()
 std::future<std::unique_ptr<InferResult>>
 InternalServer::AsyncInfer(InferRequest& infer_request)
 {
-  std::future<std::unique_ptr<InferResult>> result_future;
+  auto p = new std::promise<std::unique_ptr<InferResult>>();
+  std::future<std::unique_ptr<InferResult>> result_future = p->get_future();
+  infer_request.prev_promise_.reset(std::move(p));
+  infer_request.response_stream_.reset();
+  infer_request.completion_fn_ = nullptr;
+  RecordRequest(infer_request);
+
+  try {
+    StartInfer(infer_request);
+  }
+  catch (const TritonException& ex) {
+    throw TritonException(std::string("Error - AsyncInfer: ") + ex.what());
+  }
+
+  return result_future;
+}
+
+std::shared_ptr<ResponseStream>
+InternalServer::InferStream(InferRequest& infer_request, const size_t capacity)
+{
+  std::shared_ptr<ResponseStream> stream(new ResponseStream(capacity));
+  infer_request.prev_promise_.reset();
+  infer_request.response_stream_ = stream;
+  infer_request.completion_fn_ = nullptr;
+
+  try {
+    StartInfer(infer_request);
+  }
+  catch (const TritonException& ex) {
+    infer_request.response_stream_.reset();
+    throw TritonException(std::string("Error - InferStream: ") + ex.what());
+  }
+
+  // The request keeps its own reference for the server, so the stream is
+  // cancelled through the caller's references rather than its destructor, to
+  // unblock the server if the caller abandons a stream that is not finished.
+  return std::shared_ptr<ResponseStream>(
+      stream.get(), [stream](ResponseStream*) { stream->Cancel(); });
+}
+
+void
+InternalServer::StartInfer(InferRequest& infer_request)
+{
+  if (residency_manager_ == nullptr) {
+    SubmitInfer(infer_request, nullptr /* lease */);
+    return;
+  }
+
+  const std::string model_name = infer_request.infer_options_->model_name_;
+  bool is_resident = residency_manager_->Acquire(
+      model_name, [this, &infer_request, model_name](const std::string& error) {
+        // Called on the loader thread once the model is loaded, so the errors
+        // are returned through the result instead of thrown.
+        std::string error_msg = error;
+        if (error_msg.empty()) {
+          try {
+            SubmitInfer(
+                infer_request, std::unique_ptr<ResidencyManager::Lease>(
+                                   new ResidencyManager::Lease(
+                                       residency_manager_, model_name)));
+            return;
+          }
+          catch (const TritonException& ex) {
+            error_msg = ex.what();
+          }
+        }
+        CompleteWithError(
+            infer_request, std::string("Error - AsyncInfer: ") + error_msg);
+      });
+  if (is_resident) {
+    SubmitInfer(
+        infer_request,
+        std::unique_ptr<ResidencyManager::Lease>(
+            new ResidencyManager::Lease(residency_manager_, model_name)));
+  }
+}
+
+void
+InternalServer::CompleteWithError(
+    InferRequest& infer_request, const std::string& error_msg)
+{
+  std::unique_ptr<InternalResult> result = std::make_unique<InternalResult>();
+  result->FinalizeError(error_msg);
+  if (infer_request.response_stream_ != nullptr) {
+    std::shared_ptr<ResponseStream> stream = infer_request.response_stream_;
+    stream->Push(std::move(result));
+    stream->Finish();
+  } else if (infer_request.completion_fn_ != nullptr) {
+    std::function<void(std::unique_ptr<InferResult>&&)> completion_fn =
+        std::move(infer_request.completion_fn_);
+    infer_request.completion_fn_ = nullptr;
+    completion_fn(std::move(result));
+  } else {
+    std::unique_ptr<std::promise<std::unique_ptr<InferResult>>> prev_promise =
+        std::move(infer_request.prev_promise_);
+    prev_promise->set_value(std::move(result));
+  }
+}
+
+void
+InternalServer::SubmitInfer(
+    InferRequest& infer_request,
+    std::unique_ptr<ResidencyManager::Lease> lease)
+{
   // The inference request object for sending internal requests.
   TRITONSERVER_InferenceRequest* irequest = nullptr;
   try {
@@ -1616,6 +2712,7 @@ InternalServer::AsyncInfer(InferRequest& infer_request)
         nullptr /* voidp */));
     infer_request.is_decoupled_ =
         ((txn_flags & TRITONSERVER_TXN_DECOUPLED) != 0);
+    infer_request.allocation_tracker_ = allocation_tracker_;
 
     AsyncInferHelper(&irequest, infer_request);
 
@@ -1648,10 +2745,19 @@ InternalServer::AsyncInfer(InferRequest& infer_request)
     }
 
     {
-      auto p = new std::promise<std::unique_ptr<InferResult>>();
-      result_future = p->get_future();
-      infer_request.prev_promise_.reset(std::move(p));
-
+      // Hold the reservation of the model and the input buffers to be
+      // returned to their pool until the request is released.
+      std::unique_ptr<RequestReleaseInfo> release_info(
+          new RequestReleaseInfo());
+      release_info->lease_ = std::move(lease);
+      release_info->input_owners_.swap(infer_request.input_release_owners_);
+      const bool has_release_info = (release_info->lease_ != nullptr) ||
+                                    !release_info->input_owners_.empty();
+      if (has_release_info) {
+        THROW_IF_TRITON_ERR(TRITONSERVER_InferenceRequestSetReleaseCallback(
+            irequest, InternalServer::InferRequestComplete,
+            reinterpret_cast<void*>(release_info.get())));
+      }
       if (infer_request.infer_options_->custom_allocator_ == nullptr) {
         THROW_IF_TRITON_ERR(TRITONSERVER_InferenceRequestSetResponseCallback(
             irequest, allocator_, reinterpret_cast<void*>(&infer_request),
@@ -1666,16 +2772,18 @@ InternalServer::AsyncInfer(InferRequest& infer_request)
       }
       THROW_IF_TRITON_ERR(
           TRITONSERVER_ServerInferAsync(server_.get(), irequest, triton_trace));
+      // The release info is now owned by the release callback of the request.
+      if (has_release_info) {
+        release_info.release();
+      }
     }
   }
   catch (const TritonException& ex) {
     LOG_IF_ERROR(
         TRITONSERVER_InferenceRequestDelete(irequest),
         "Failed to delete inference request.");
-    throw TritonException(std::string("Error - AsyncInfer: ") + ex.what());
+    throw;
   }
-
-  return result_future;
 }
 
 std::unique_ptr<InferRequest>
@@ -1686,7 +2794,7 @@ InferRequest::Create(const InferOptions& options)
   return internal_request;
 }
 
-InferRequest::InferRequest() : is_decoupled_(false)
+InferRequest::InferRequest() : str_buf_count_(0), is_decoupled_(false)
 {
   str_bufs_.clear();
   inputs_.clear();
@@ -1697,11 +2805,7 @@ InferRequest::~InferRequest() {}
 
 InternalRequest::InternalRequest(const InferOptions& options) : InferRequest()
 {
-  infer_options_.reset(new InferOptions(
-      options.model_name_, options.model_version_, options.request_id_,
-      options.correlation_id_, options.correlation_id_str_,
-      options.sequence_start_, options.sequence_end_, options.priority_,
-      options.request_timeout_, options.custom_allocator_, options.trace_));
+  infer_options_.reset(new InferOptions(options));
 
   // Store custom allocator as a static variable as it's needed in global
   // functions.
@@ -1731,7 +2835,41 @@ void
 InferRequest::AddInput(
     const std::string& name, const Tensor& input_tensor) noexcept
 {
-  inputs_[name] = std::make_unique<Tensor>(input_tensor);
+  std::unique_ptr<Tensor>& input = inputs_.Acquire(name);
+  if (input == nullptr) {
+    input = std::make_unique<Tensor>(input_tensor);
+  } else {
+    // Copy-assignment reuses the capacity of the shape of the slot.
+    *input = input_tensor;
+  }
+}
+
+void
+InferRequest::AddInput(const std::string& name, Tensor&& input_tensor) noexcept
+{
+  std::unique_ptr<Tensor>& input = inputs_.Acquire(name);
+  if ((input == nullptr) || (input->is_output_ && !input->is_pre_alloc_)) {
+    // A slot holding an output moved in earlier releases its buffer here.
+    input = std::make_unique<Tensor>(
+        input_tensor.buffer_, input_tensor.byte_size_,
+        input_tensor.memory_type_, input_tensor.memory_type_id_);
+  }
+  input->buffer_ = input_tensor.buffer_;
+  input->byte_size_ = input_tensor.byte_size_;
+  input->data_type_ = input_tensor.data_type_;
+  input->shape_.swap(input_tensor.shape_);
+  input->memory_type_ = input_tensor.memory_type_;
+  input->memory_type_id_ = input_tensor.memory_type_id_;
+  input->custom_allocator_ = std::move(input_tensor.custom_allocator_);
+  input->is_pre_alloc_ = input_tensor.is_pre_alloc_;
+  input->is_output_ = input_tensor.is_output_;
+  input->buffer_owner_ = std::move(input_tensor.buffer_owner_);
+
+  // The buffer now belongs to the request, so that it is released once, and
+  // only once the request is done with it.
+  input_tensor.buffer_ = nullptr;
+  input_tensor.is_pre_alloc_ = false;
+  input_tensor.is_output_ = false;
 }
 
 void
@@ -1742,10 +2880,19 @@ InferRequest::AddRequestedOutput(const std::string& name, Tensor& output_tensor)
       throw TritonException(
           "Pre-allocated buffer for '" + name + "' is a nullptr.");
     }
-    std::unique_ptr<InferRequestedOutput> output = InferRequestedOutput::Create(
-        name, output_tensor.buffer_, output_tensor.byte_size_,
-        output_tensor.memory_type_, output_tensor.memory_type_id_);
-    outputs_.push_back(std::move(output));
+    std::unique_ptr<InferRequestedOutput>& output = outputs_.Acquire(name);
+    if (output == nullptr) {
+      output = InferRequestedOutput::Create(
+          name, output_tensor.buffer_, output_tensor.byte_size_,
+          output_tensor.memory_type_, output_tensor.memory_type_id_);
+    } else {
+      output->Reset(
+          name, output_tensor.buffer_, output_tensor.byte_size_,
+          output_tensor.memory_type_, output_tensor.memory_type_id_);
+    }
+    if (output_tensor.buffer_owner_ != nullptr) {
+      buffer_owners_[name] = output_tensor.buffer_owner_;
+    }
   }
   catch (const TritonException& ex) {
     throw TritonException(
@@ -1757,9 +2904,12 @@ void
 InferRequest::AddRequestedOutput(const std::string& name)
 {
   try {
-    std::unique_ptr<InferRequestedOutput> output =
-        InferRequestedOutput::Create(name);
-    outputs_.push_back(std::move(output));
+    std::unique_ptr<InferRequestedOutput>& output = outputs_.Acquire(name);
+    if (output == nullptr) {
+      output = InferRequestedOutput::Create(name);
+    } else {
+      output->Reset(name, nullptr, 0, MemoryType::CPU, 0);
+    }
   }
   catch (const TritonException& ex) {
     throw TritonException(
@@ -1770,79 +2920,1607 @@ InferRequest::AddRequestedOutput(const std::string& name)
 void
 InferRequest::Reset()
 {
+  // Only the storage of the released inputs is kept, not the objects owning
+  // their buffers.
+  for (auto& input : inputs_) {
+    input.second->custom_allocator_.reset();
+    input.second->buffer_owner_.reset();
+  }
   inputs_.clear();
   outputs_.clear();
+  str_buf_count_ = 0;
   tensor_alloc_map_.clear();
+  buffer_owners_.clear();
+  input_release_owners_.clear();
 }
 
-InferResult::InferResult()
-    : has_error_(false), error_msg_(""), completed_response_(nullptr)
+void
+Allocator::Allocate(
+    const char* tensor_name, size_t byte_size,
+    MemoryType preferred_memory_type, int64_t preferred_memory_type_id,
+    void** buffer, MemoryType* actual_memory_type,
+    int64_t* actual_memory_type_id)
 {
+  if (alloc_fn_ == nullptr) {
+    throw TritonException("Custom response allocation function is not set.");
+  }
+  alloc_fn_(
+      tensor_name, byte_size, preferred_memory_type, preferred_memory_type_id,
+      buffer, actual_memory_type, actual_memory_type_id);
 }
 
-InferResult::~InferResult() {}
-
-InternalResult::InternalResult() : InferResult() {}
-
-InternalResult::~InternalResult()
+void
+Allocator::Release(
+    void* buffer, size_t byte_size, MemoryType memory_type,
+    int64_t memory_type_id)
 {
-  if (completed_response_ != nullptr) {
-    LOG_IF_ERROR(
-        TRITONSERVER_InferenceResponseDelete(completed_response_),
-        "Failed to delete inference response.");
+  if (release_fn_ == nullptr) {
+    std::cerr << "error: ReleaseFn() is not set in custom allocator."
+              << std::endl;
+    return;
   }
+  release_fn_(buffer, byte_size, memory_type, memory_type_id);
 }
 
-void
-InternalResult::FinalizeResponse(
-    TRITONSERVER_InferenceResponse* response, const AllocInfo& alloc_info)
+std::shared_ptr<MappedFileAllocator>
+MappedFileAllocator::Create(const std::string& path, const size_t capacity)
 {
   try {
-    THROW_IF_TRITON_ERR(TRITONSERVER_InferenceResponseError(response));
+    return std::shared_ptr<MappedFileAllocator>(
+        new MappedFileAllocator(MappedFile::CreateWrite(path, capacity)));
+  }
+  catch (const TritonException& ex) {
+    throw TritonException(
+        std::string("Error - MappedFileAllocator::Create: ") + ex.what());
+  }
+}
 
-    const char* model_name;
-    int64_t model_version;
-    THROW_IF_TRITON_ERR(TRITONSERVER_InferenceResponseModel(
-        response, &model_name, &model_version));
-    const char* request_id = nullptr;
-    THROW_IF_TRITON_ERR(
-        TRITONSERVER_InferenceResponseId(response, &request_id));
-    model_name_ = model_name;
-    model_version_ = model_version;
-    request_id_ = request_id;
+MappedFileAllocator::MappedFileAllocator(std::shared_ptr<MappedFile> file)
+    : Allocator(nullptr, nullptr), file_(file), used_byte_size_(0)
+{
+}
 
-    uint32_t parameter_count;
-    THROW_IF_TRITON_ERR(TRITONSERVER_InferenceResponseParameterCount(
-        response, &parameter_count));
-    for (uint32_t pidx = 0; pidx < parameter_count; ++pidx) {
-      const char* name;
-      TRITONSERVER_ParameterType type;
-      const void* vvalue;
-      THROW_IF_TRITON_ERR(TRITONSERVER_InferenceResponseParameter(
-          response, pidx, &name, &type, &vvalue));
-      params_.push_back(std::move(std::unique_ptr<ResponseParameters>(
-          new ResponseParameters(name, type, vvalue))));
+MappedFileAllocator::~MappedFileAllocator()
+{
+  file_->SetFinalByteSize(used_byte_size_.load());
+}
+
+void
+MappedFileAllocator::Allocate(
+    const char* tensor_name, size_t byte_size,
+    MemoryType preferred_memory_type, int64_t preferred_memory_type_id,
+    void** buffer, MemoryType* actual_memory_type,
+    int64_t* actual_memory_type_id)
+{
+  // Reserve the next aligned region of the file. The output itself must fit
+  // in the remaining capacity, while the padding that aligns the next output
+  // is only reserved as far as the end of the file.
+  const size_t aligned_byte_size = (byte_size + 63) & ~size_t(63);
+  size_t offset = used_byte_size_.load();
+  size_t next_offset = 0;
+  do {
+    if ((file_->ByteSize() - offset) < byte_size) {
+      throw TritonException(
+          "The mapped output file has no space for " +
+          std::to_string(byte_size) + " bytes of output '" + tensor_name +
+          "', " + std::to_string(file_->ByteSize() - offset) +
+          " bytes remaining.");
     }
+    next_offset = std::min(offset + aligned_byte_size, file_->ByteSize());
+  } while (!used_byte_size_.compare_exchange_weak(offset, next_offset));
 
-    uint32_t output_count;
-    THROW_IF_TRITON_ERR(
-        TRITONSERVER_InferenceResponseOutputCount(response, &output_count));
+  *buffer = (byte_size == 0) ? nullptr : (file_->Data() + offset);
+  *actual_memory_type = MemoryType::CPU;
+  *actual_memory_type_id = 0;
+}
 
-    for (uint32_t idx = 0; idx < output_count; ++idx) {
-      const char* cname;
-      TRITONSERVER_DataType datatype;
-      const int64_t* shape;
-      uint64_t dim_count;
-      const void* base;
-      size_t byte_size;
-      TRITONSERVER_MemoryType memory_type;
-      int64_t memory_type_id;
-      void* userp;
-      THROW_IF_TRITON_ERR(TRITONSERVER_InferenceResponseOutput(
-          response, idx, &cname, &datatype, &shape, &dim_count, &base,
-          &byte_size, &memory_type, &memory_type_id, &userp));
+void
+MappedFileAllocator::Release(
+    void* buffer, size_t byte_size, MemoryType memory_type,
+    int64_t memory_type_id)
+{
+  // The outputs are kept in the file.
+}
 
-      std::string name(cname);
+size_t
+MappedFileAllocator::Offset(const Tensor& output)
+{
+  if ((output.buffer_ < file_->Data()) ||
+      (output.buffer_ >= (file_->Data() + file_->ByteSize()))) {
+    throw TritonException(
+        std::string("Error - Offset: ") +
+        "The output is not allocated by this allocator.");
+  }
+  return output.buffer_ - file_->Data();
+}
+
+void
+MappedFileAllocator::Sync()
+{
+  try {
+    file_->Sync();
+  }
+  catch (const TritonException& ex) {
+    throw TritonException(std::string("Error - Sync: ") + ex.what());
+  }
+}
+
+std::shared_ptr<OutputBufferRing>
+OutputBufferRing::Create(
+    const size_t buffer_count, const size_t byte_size,
+    const MemoryType& memory_type, const int64_t memory_type_id)
+{
+  if ((buffer_count == 0) || (byte_size == 0)) {
+    throw TritonException(
+        "Error - OutputBufferRing::Create: The buffer count and the byte size "
+        "must be greater than 0.");
+  }
+#ifndef TRITON_ENABLE_GPU
+  if (memory_type != MemoryType::CPU) {
+    throw TritonException(
+        "Error - OutputBufferRing::Create: Only 'CPU' memory is supported "
+        "without enabling GPU.");
+  }
+#endif  // TRITON_ENABLE_GPU
+  return std::shared_ptr<OutputBufferRing>(new OutputBufferRing(
+      buffer_count, byte_size, memory_type, memory_type_id));
+}
+
+OutputBufferRing::OutputBufferRing(
+    const size_t buffer_count, const size_t byte_size,
+    const MemoryType& memory_type, const int64_t memory_type_id)
+    : buffer_count_(buffer_count), byte_size_(byte_size),
+      memory_type_(memory_type), memory_type_id_(memory_type_id)
+{
+}
+
+OutputBufferRing::~OutputBufferRing()
+{
+  // The ring is only destroyed once all the buffers are released, as each
+  // acquired buffer holds a reference to the ring.
+  for (auto& ring : rings_) {
+    for (char* buffer : ring.second.buffers_) {
+      FreeBuffer(buffer);
+    }
+  }
+}
+
+char*
+OutputBufferRing::AllocateBuffer(const std::string& output_name)
+{
+  void* allocated_ptr = nullptr;
+  switch (memory_type_) {
+#ifdef TRITON_ENABLE_GPU
+    case MemoryType::CPU_PINNED:
+    case MemoryType::GPU: {
+      auto err = cudaSetDevice(memory_type_id_);
+      if (err != cudaSuccess) {
+        throw TritonException(
+            "Error - Acquire: Unable to set CUDA device " +
+            std::to_string(memory_type_id_) + " for output '" + output_name +
+            "': " + std::string(cudaGetErrorString(err)));
+      }
+      if (memory_type_ == MemoryType::CPU_PINNED) {
+        err = cudaHostAlloc(&allocated_ptr, byte_size_, cudaHostAllocPortable);
+      } else {
+        err = cudaMalloc(&allocated_ptr, byte_size_);
+      }
+      if (err != cudaSuccess) {
+        allocated_ptr = nullptr;
+      }
+      break;
+    }
+#endif  // TRITON_ENABLE_GPU
+    default:
+      allocated_ptr = malloc(byte_size_);
+      break;
+  }
+  if (allocated_ptr == nullptr) {
+    throw TritonException(
+        "Error - Acquire: Failed to allocate " + std::to_string(byte_size_) +
+        " bytes in " + MemoryTypeString(memory_type_) + " for output '" +
+        output_name + "'.");
+  }
+  return reinterpret_cast<char*>(allocated_ptr);
+}
+
+void
+OutputBufferRing::FreeBuffer(char* buffer)
+{
+  switch (memory_type_) {
+#ifdef TRITON_ENABLE_GPU
+    case MemoryType::CPU_PINNED:
+      cudaFreeHost(buffer);
+      break;
+    case MemoryType::GPU:
+      cudaFree(buffer);
+      break;
+#endif  // TRITON_ENABLE_GPU
+    default:
+      free(buffer);
+      break;
+  }
+}
+
+Tensor
+OutputBufferRing::Acquire(const std::string& output_name)
+{
+  // Allocate the buffers of a new output outside of the lock, so that slow
+  // device allocations do not block the outputs that already have a ring.
+  bool needs_ring = false;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = rings_.find(output_name);
+    needs_ring = (it == rings_.end()) || it->second.buffers_.empty();
+  }
+  std::vector<char*> allocated;
+  if (needs_ring) {
+    try {
+      for (size_t i = 0; i < buffer_count_; ++i) {
+        allocated.push_back(AllocateBuffer(output_name));
+      }
+    }
+    catch (...) {
+      for (char* unused : allocated) {
+        FreeBuffer(unused);
+      }
+      throw;
+    }
+  }
+
+  char* buffer = nullptr;
+  {
+    std::unique_lock<std::mutex> lk(mu_);
+    Ring& ring = rings_[output_name];
+    if (ring.buffers_.empty()) {
+      for (char* allocated_buffer : allocated) {
+        ring.buffers_.push_back(allocated_buffer);
+        ring.free_buffers_.push_back(allocated_buffer);
+      }
+      allocated.clear();
+    }
+    cv_.wait(lk, [&ring]() { return !ring.free_buffers_.empty(); });
+    buffer = ring.free_buffers_.front();
+    ring.free_buffers_.pop_front();
+  }
+  // Another caller created the ring first.
+  for (char* unused : allocated) {
+    FreeBuffer(unused);
+  }
+
+  Tensor tensor(buffer, byte_size_, memory_type_, memory_type_id_);
+  std::shared_ptr<OutputBufferRing> self = shared_from_this();
+  tensor.buffer_owner_ = std::shared_ptr<void>(
+      buffer, [self, output_name](void* released) {
+        self->Release(output_name, reinterpret_cast<char*>(released));
+      });
+  return tensor;
+}
+
+void
+OutputBufferRing::AddRequestedOutput(
+    InferRequest& infer_request, const std::string& output_name)
+{
+  Tensor output = Acquire(output_name);
+  infer_request.AddRequestedOutput(output_name, output);
+}
+
+size_t
+OutputBufferRing::FreeBufferCount(const std::string& output_name)
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  auto it = rings_.find(output_name);
+  return (it == rings_.end()) ? buffer_count_
+                              : it->second.free_buffers_.size();
+}
+
+void
+OutputBufferRing::Release(const std::string& output_name, char* buffer)
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  rings_[output_name].free_buffers_.push_back(buffer);
+  cv_.notify_all();
+}
+
+std::shared_ptr<PinnedInputArena>
+PinnedInputArena::Create(const size_t buffer_count, const size_t byte_size)
+{
+  if ((buffer_count == 0) || (byte_size == 0)) {
+    throw TritonException(
+        "Error - PinnedInputArena::Create: The buffer count and the byte size "
+        "must be greater than 0.");
+  }
+  std::shared_ptr<PinnedInputArena> arena(new PinnedInputArena(byte_size));
+  for (size_t i = 0; i < buffer_count; ++i) {
+    void* allocated_ptr = nullptr;
+#ifdef TRITON_ENABLE_GPU
+    if (cudaHostAlloc(&allocated_ptr, byte_size, cudaHostAllocPortable) !=
+        cudaSuccess) {
+      allocated_ptr = nullptr;
+    }
+#elif defined(_WIN32)
+    allocated_ptr = _aligned_malloc(byte_size, 4096);
+#else
+    if (posix_memalign(&allocated_ptr, 4096, byte_size) != 0) {
+      allocated_ptr = nullptr;
+    }
+#endif  // TRITON_ENABLE_GPU
+    if (allocated_ptr == nullptr) {
+      throw TritonException(
+          "Error - PinnedInputArena::Create: Failed to allocate " +
+          std::to_string(byte_size) + " bytes in " +
+          MemoryTypeString(arena->memory_type_) + ".");
+    }
+    arena->buffers_.push_back(reinterpret_cast<char*>(allocated_ptr));
+    arena->free_buffers_.push_back(reinterpret_cast<char*>(allocated_ptr));
+  }
+  return arena;
+}
+
+PinnedInputArena::PinnedInputArena(const size_t byte_size)
+    : byte_size_(byte_size),
+#ifdef TRITON_ENABLE_GPU
+      memory_type_(MemoryType::CPU_PINNED)
+#else
+      memory_type_(MemoryType::CPU)
+#endif  // TRITON_ENABLE_GPU
+{
+}
+
+PinnedInputArena::~PinnedInputArena()
+{
+  // The arena is only destroyed once all the buffers are returned, as each
+  // acquired buffer holds a reference to the arena.
+  for (char* buffer : buffers_) {
+#ifdef TRITON_ENABLE_GPU
+    cudaFreeHost(buffer);
+#elif defined(_WIN32)
+    _aligned_free(buffer);
+#else
+    free(buffer);
+#endif  // TRITON_ENABLE_GPU
+  }
+}
+
+Tensor
+PinnedInputArena::Acquire()
+{
+  char* buffer = nullptr;
+  {
+    std::unique_lock<std::mutex> lk(mu_);
+    cv_.wait(lk, [this]() { return !free_buffers_.empty(); });
+    buffer = free_buffers_.front();
+    free_buffers_.pop_front();
+  }
+
+  Tensor tensor(buffer, byte_size_, memory_type_, 0);
+  std::shared_ptr<PinnedInputArena> self = shared_from_this();
+  tensor.buffer_owner_ =
+      std::shared_ptr<void>(buffer, [self](void* released) {
+        self->Release(reinterpret_cast<char*>(released));
+      });
+  return tensor;
+}
+
+void
+PinnedInputArena::AddInput(
+    InferRequest& infer_request, const std::string& name, Tensor& input)
+{
+  infer_request.AddInput(name, input);
+  // Only the request holds the buffer, so that it is returned to the pool
+  // once the server releases the request.
+  auto it = infer_request.inputs_.find(name);
+  if ((it != infer_request.inputs_.end()) &&
+      (it->second->buffer_owner_ != nullptr)) {
+    infer_request.input_release_owners_.push_back(it->second->buffer_owner_);
+    it->second->buffer_owner_.reset();
+  }
+  input.buffer_owner_.reset();
+}
+
+void
+PinnedInputArena::AddInput(
+    InferRequest& infer_request, const std::string& name, const char* data,
+    const size_t byte_size, const DataType& data_type,
+    const std::vector<int64_t>& shape)
+{
+  if (byte_size > byte_size_) {
+    throw TritonException(
+        "Error - AddInput: Input '" + name + "' of " +
+        std::to_string(byte_size) + " bytes does not fit in a buffer of " +
+        std::to_string(byte_size_) + " bytes.");
+  }
+  Tensor input = Acquire();
+  memcpy(input.buffer_, data, byte_size);
+  input.byte_size_ = byte_size;
+  input.data_type_ = data_type;
+  input.shape_ = shape;
+  AddInput(infer_request, name, input);
+}
+
+size_t
+PinnedInputArena::FreeBufferCount()
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  return free_buffers_.size();
+}
+
+void
+PinnedInputArena::Release(char* buffer)
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  free_buffers_.push_back(buffer);
+  cv_.notify_all();
+}
+
+std::unique_ptr<SequenceStream>
+SequenceStream::Create(
+    TritonServer& server, const InferOptions& infer_options,
+    const size_t max_inflight)
+{
+  try {
+    if ((infer_options.correlation_id_ == 0) &&
+        infer_options.correlation_id_str_.empty()) {
+      throw TritonException("The correlation ID of the sequence is not set.");
+    }
+    if (max_inflight == 0) {
+      throw TritonException("'max_inflight' must be greater than 0.");
+    }
+    return std::unique_ptr<SequenceStream>(
+        new SequenceStream(server, infer_options, max_inflight));
+  }
+  catch (const TritonException& ex) {
+    throw TritonException(
+        std::string("Error - SequenceStream::Create: ") + ex.what());
+  }
+}
+
+SequenceStream::SequenceStream(
+    TritonServer& server, const InferOptions& infer_options,
+    const size_t max_inflight)
+    : server_(server), slots_(max_inflight), next_slot_(0), started_(false),
+      ended_(false)
+{
+  for (auto& slot : slots_) {
+    slot.request_ = InferRequest::Create(infer_options);
+    slot.inflight_ = false;
+  }
+}
+
+SequenceStream::~SequenceStream()
+{
+  // The inflight requests are referenced by the server until they complete.
+  for (auto& step : pending_) {
+    if (!step.completed_) {
+      step.future_.wait();
+    }
+  }
+}
+
+void
+SequenceStream::Send(
+    const std::unordered_map<std::string, Tensor>& inputs, const bool is_last)
+{
+  try {
+    if (ended_) {
+      throw TritonException("The last step of the sequence has been sent.");
+    }
+
+    Slot& slot = slots_[next_slot_];
+    if (slot.inflight_) {
+      // Slots are used in round-robin, so the step using this slot is the
+      // oldest inflight one.
+      for (auto& step : pending_) {
+        if (!step.completed_) {
+          Complete(step);
+          break;
+        }
+      }
+    }
+
+    InferRequest& request = *slot.request_;
+    // Drop the inputs of the previous step that are not used by this step.
+    for (auto it = request.inputs_.begin(); it != request.inputs_.end();) {
+      if (inputs.find(it->first) == inputs.end()) {
+        slot.buffers_.erase(it->first);
+        it = request.inputs_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    for (const auto& input : inputs) {
+      request.AddInput(input.first, input.second);
+      if (input.second.memory_type_ != MemoryType::GPU) {
+        // Reuse the capacity of the buffer from the previous steps.
+        std::vector<char>& buffer = slot.buffers_[input.first];
+        buffer.assign(
+            input.second.buffer_,
+            input.second.buffer_ + input.second.byte_size_);
+        Tensor& request_input = *(request.inputs_.find(input.first)->second);
+        request_input.buffer_ = buffer.data();
+        request_input.memory_type_ = MemoryType::CPU;
+        request_input.memory_type_id_ = 0;
+      }
+    }
+    request.tensor_alloc_map_.clear();
+    request.infer_options_->sequence_start_ = !started_;
+    request.infer_options_->sequence_end_ = is_last;
+
+    Step step;
+    step.slot_ = next_slot_;
+    step.future_ = server_.AsyncInfer(request);
+    step.completed_ = false;
+    pending_.push_back(std::move(step));
+
+    slot.inflight_ = true;
+    next_slot_ = (next_slot_ + 1) % slots_.size();
+    started_ = true;
+    ended_ = is_last;
+  }
+  catch (const TritonException& ex) {
+    throw TritonException(
+        std::string("Error - SequenceStream::Send: ") + ex.what());
+  }
+}
+
+std::unique_ptr<InferResult>
+SequenceStream::Receive()
+{
+  if (pending_.empty()) {
+    return nullptr;
+  }
+
+  Step& step = pending_.front();
+  if (!step.completed_) {
+    Complete(step);
+  }
+  std::unique_ptr<InferResult> result = std::move(step.result_);
+  pending_.pop_front();
+  return result;
+}
+
+void
+SequenceStream::Complete(Step& step)
+{
+  step.result_ = step.future_.get();
+  step.completed_ = true;
+  slots_[step.slot_].inflight_ = false;
+}
+
+struct Pipeline::Run {
+  // The request of each stage. The request of a stage is released once the
+  // stage completes, which releases the outputs of the earlier stages that
+  // are passed as its inputs.
+  std::vector<std::unique_ptr<InferRequest>> requests_;
+  // The promise of the result of the last stage.
+  std::promise<std::unique_ptr<InferResult>> promise_;
+};
+
+std::unique_ptr<Pipeline>
+Pipeline::Create(TritonServer& server)
+{
+  return std::unique_ptr<Pipeline>(new Pipeline(server));
+}
+
+Pipeline::Pipeline(TritonServer& server) : server_(server), inflight_(0) {}
+
+Pipeline::~Pipeline()
+{
+  std::unique_lock<std::mutex> lk(mu_);
+  cv_.wait(lk, [this]() { return inflight_ == 0; });
+}
+
+size_t
+Pipeline::AddStage(const InferOptions& infer_options)
+{
+  stages_.push_back(infer_options);
+  return stages_.size() - 1;
+}
+
+void
+Pipeline::Connect(
+    const size_t from_stage, const std::string& output_name,
+    const size_t to_stage, const std::string& input_name)
+{
+  if ((to_stage >= stages_.size()) || (from_stage >= to_stage)) {
+    throw TritonException(
+        std::string("Error - Connect: ") + "Invalid connection from stage " +
+        std::to_string(from_stage) + " to stage " + std::to_string(to_stage) +
+        " in a pipeline of " + std::to_string(stages_.size()) + " stages.");
+  }
+  connections_.push_back(
+      Connection{from_stage, output_name, to_stage, input_name});
+}
+
+std::future<std::unique_ptr<InferResult>>
+Pipeline::AsyncInfer(const std::unordered_map<std::string, Tensor>& inputs)
+{
+  try {
+    if (stages_.empty()) {
+      throw TritonException("The pipeline has no stage.");
+    }
+    std::shared_ptr<Run> run = std::make_shared<Run>();
+    for (const auto& infer_options : stages_) {
+      run->requests_.push_back(InferRequest::Create(infer_options));
+    }
+    for (const auto& input : inputs) {
+      run->requests_[0]->AddInput(input.first, input.second);
+    }
+    std::future<std::unique_ptr<InferResult>> result_future =
+        run->promise_.get_future();
+
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      inflight_++;
+    }
+    try {
+      SendStage(run, 0);
+    }
+    catch (const TritonException& ex) {
+      std::lock_guard<std::mutex> lk(mu_);
+      inflight_--;
+      cv_.notify_all();
+      throw;
+    }
+
+    return result_future;
+  }
+  catch (const TritonException& ex) {
+    throw TritonException(
+        std::string("Error - Pipeline::AsyncInfer: ") + ex.what());
+  }
+}
+
+void
+Pipeline::SendStage(const std::shared_ptr<Run>& run, const size_t stage)
+{
+  InferRequest& request = *(run->requests_[stage]);
+  request.completion_fn_ = [this, run,
+                            stage](std::unique_ptr<InferResult>&& result) {
+    CompleteStage(run, stage, std::move(result));
+  };
+  try {
+    server_.StartInfer(request);
+  }
+  catch (const TritonException& ex) {
+    // Break the reference cycle between the run and the callback.
+    request.completion_fn_ = nullptr;
+    throw;
+  }
+}
+
+void
+Pipeline::CompleteStage(
+    const std::shared_ptr<Run>& run, const size_t stage,
+    std::unique_ptr<InferResult>&& result)
+{
+  if (result->HasError() || ((stage + 1) == stages_.size())) {
+    Finish(run, std::move(result));
+    return;
+  }
+
+  try {
+    for (const auto& connection : connections_) {
+      if (connection.from_stage_ != stage) {
+        continue;
+      }
+      // The input refers to the output buffer and shares the ownership of
+      // it, so the output outlives the result of this stage.
+      std::shared_ptr<Tensor> output = result->Output(connection.output_name_);
+      Tensor input(
+          output->buffer_, output->byte_size_, output->data_type_,
+          output->shape_, output->memory_type_, output->memory_type_id_);
+      input.buffer_owner_ = output;
+      run->requests_[connection.to_stage_]->AddInput(
+          connection.input_name_, input);
+    }
+    result.reset();
+    run->requests_[stage].reset();
+
+    SendStage(run, stage + 1);
+  }
+  catch (const TritonException& ex) {
+    std::unique_ptr<InternalResult> error = std::make_unique<InternalResult>();
+    error->FinalizeError(
+        std::string("Error - Pipeline stage ") + std::to_string(stage + 1) +
+        ": " + ex.what());
+    Finish(run, std::move(error));
+  }
+}
+
+void
+Pipeline::Finish(
+    const std::shared_ptr<Run>& run, std::unique_ptr<InferResult>&& result)
+{
+  run->promise_.set_value(std::move(result));
+  std::lock_guard<std::mutex> lk(mu_);
+  inflight_--;
+  cv_.notify_all();
+}
+
+ShardOptions::ShardOptions(const int32_t numa_node)
+    : numa_node_(numa_node), cpu_cores_(""), host_policy_names_({"cpu"})
+{
+}
+
+ShardOptions::ShardOptions(
+    const int32_t numa_node, const std::string& cpu_cores,
+    const std::vector<std::string>& host_policy_names)
+    : numa_node_(numa_node), cpu_cores_(cpu_cores),
+      host_policy_names_(host_policy_names)
+{
+}
+
+// Parse a list of CPU core IDs and ranges such as "0-3,8".
+std::vector<int>
+ParseCpuCores(const std::string& cpu_cores)
+{
+  std::vector<int> cores;
+  std::stringstream ss(cpu_cores);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    try {
+      size_t pos = 0;
+      int first = std::stoi(item, &pos);
+      int last = first;
+      if (pos < item.size()) {
+        if (item[pos] != '-') {
+          throw std::invalid_argument(item);
+        }
+        size_t last_pos = 0;
+        last = std::stoi(item.substr(pos + 1), &last_pos);
+        if ((pos + 1 + last_pos) != item.size()) {
+          throw std::invalid_argument(item);
+        }
+      }
+      if ((first < 0) || (last < first)) {
+        throw std::invalid_argument(item);
+      }
+      for (int core = first; core <= last; ++core) {
+        cores.push_back(core);
+      }
+    }
+    catch (const std::logic_error& ex) {
+      throw TritonException(
+          "Invalid CPU cores '" + cpu_cores + "': unexpected '" + item + "'.");
+    }
+  }
+  return cores;
+}
+
+std::unique_ptr<ShardedServer>
+ShardedServer::Create(
+    const ServerOptions& options, const std::vector<ShardOptions>& shards,
+    const Routing routing)
+{
+  try {
+    std::unique_ptr<ShardedServer> sharded_server(
+        new ShardedServer(routing, nullptr));
+    sharded_server->CreateShards(options, shards);
+    return sharded_server;
+  }
+  catch (const TritonException& ex) {
+    throw TritonException(
+        std::string("Error - ShardedServer::Create: ") + ex.what());
+  }
+}
+
+std::unique_ptr<ShardedServer>
+ShardedServer::Create(
+    const ServerOptions& options, const std::vector<ShardOptions>& shards,
+    RoutingFn routing_fn)
+{
+  try {
+    if (!routing_fn) {
+      throw TritonException("The routing function must not be empty.");
+    }
+    std::unique_ptr<ShardedServer> sharded_server(
+        new ShardedServer(Routing::ROUND_ROBIN, std::move(routing_fn)));
+    sharded_server->CreateShards(options, shards);
+    return sharded_server;
+  }
+  catch (const TritonException& ex) {
+    throw TritonException(
+        std::string("Error - ShardedServer::Create: ") + ex.what());
+  }
+}
+
+ShardedServer::ShardedServer(const Routing routing, RoutingFn routing_fn)
+    : routing_(routing), routing_fn_(std::move(routing_fn)), next_shard_(0)
+{
+}
+
+void
+ShardedServer::CreateShards(
+    const ServerOptions& options, const std::vector<ShardOptions>& shards)
+{
+  if (shards.empty()) {
+    throw TritonException("At least one shard must be specified.");
+  }
+  for (const auto& shard : shards) {
+    // Validate the cores here so that the error names the shard option
+    // rather than the host policy.
+    ParseCpuCores(shard.cpu_cores_);
+    ServerOptions shard_options = options;
+    for (const auto& name : shard.host_policy_names_) {
+      if (shard.numa_node_ >= 0) {
+        shard_options.host_policy_.emplace_back(
+            name, HostPolicy::Setting::NUMA_NODE,
+            std::to_string(shard.numa_node_));
+      }
+      if (!shard.cpu_cores_.empty()) {
+        shard_options.host_policy_.emplace_back(
+            name, HostPolicy::Setting::CPU_CORES, shard.cpu_cores_);
+      }
+    }
+
+    ShardState state;
+    state.server_ = TritonServer::Create(shard_options);
+    state.outstanding_ = std::make_shared<std::atomic<uint64_t>>(0);
+    shards_.push_back(std::move(state));
+  }
+}
+
+void
+ShardedServer::LoadModel(const std::string& model_name)
+{
+  for (auto& shard : shards_) {
+    shard.server_->LoadModel(model_name);
+  }
+}
+
+void
+ShardedServer::UnloadModel(const std::string& model_name)
+{
+  for (auto& shard : shards_) {
+    shard.server_->UnloadModel(model_name);
+  }
+}
+
+bool
+ShardedServer::IsServerReady()
+{
+  for (auto& shard : shards_) {
+    if (!shard.server_->IsServerReady()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool
+ShardedServer::IsModelReady(
+    const std::string& model_name, const int64_t model_version)
+{
+  for (auto& shard : shards_) {
+    if (!shard.server_->IsModelReady(model_name, model_version)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::future<std::unique_ptr<InferResult>>
+ShardedServer::AsyncInfer(InferRequest& infer_request)
+{
+  ShardState& shard = shards_[Route(infer_request)];
+  std::shared_ptr<std::atomic<uint64_t>> outstanding = shard.outstanding_;
+  std::shared_ptr<std::promise<std::unique_ptr<InferResult>>> promise =
+      std::make_shared<std::promise<std::unique_ptr<InferResult>>>();
+  std::future<std::unique_ptr<InferResult>> result_future =
+      promise->get_future();
+
+  outstanding->fetch_add(1);
+  infer_request.prev_promise_.reset();
+  infer_request.response_stream_.reset();
+  infer_request.completion_fn_ =
+      [outstanding, promise](std::unique_ptr<InferResult>&& result) {
+        outstanding->fetch_sub(1);
+        promise->set_value(std::move(result));
+      };
+  try {
+    shard.server_->StartInfer(infer_request);
+  }
+  catch (const TritonException& ex) {
+    infer_request.completion_fn_ = nullptr;
+    outstanding->fetch_sub(1);
+    throw TritonException(std::string("Error - AsyncInfer: ") + ex.what());
+  }
+
+  return result_future;
+}
+
+TritonServer&
+ShardedServer::Shard(const size_t index)
+{
+  if (index >= shards_.size()) {
+    throw TritonException(
+        std::string("Error - Shard: ") + "Shard index " +
+        std::to_string(index) + " is out of range, there are " +
+        std::to_string(shards_.size()) + " shards.");
+  }
+  return *(shards_[index].server_);
+}
+
+std::vector<uint64_t>
+ShardedServer::OutstandingRequests()
+{
+  std::vector<uint64_t> outstanding;
+  for (const auto& shard : shards_) {
+    outstanding.push_back(shard.outstanding_->load());
+  }
+  return outstanding;
+}
+
+size_t
+ShardedServer::Route(const InferRequest& infer_request)
+{
+  if (routing_fn_) {
+    const size_t idx = routing_fn_(infer_request, OutstandingRequests());
+    if (idx >= shards_.size()) {
+      throw TritonException(
+          std::string("Error - AsyncInfer: ") + "Shard index " +
+          std::to_string(idx) + " returned by the routing function is out " +
+          "of range, there are " + std::to_string(shards_.size()) +
+          " shards.");
+    }
+    return idx;
+  }
+  switch (routing_) {
+    case Routing::ROUND_ROBIN:
+      return next_shard_.fetch_add(1) % shards_.size();
+    case Routing::LEAST_OUTSTANDING: {
+      // Start the scan from a rotating shard so that ties are spread evenly.
+      const size_t start = next_shard_.fetch_add(1);
+      size_t selected = start % shards_.size();
+      uint64_t min_outstanding = shards_[selected].outstanding_->load();
+      for (size_t i = 1; i < shards_.size(); ++i) {
+        const size_t idx = (start + i) % shards_.size();
+        const uint64_t outstanding = shards_[idx].outstanding_->load();
+        if (outstanding < min_outstanding) {
+          selected = idx;
+          min_outstanding = outstanding;
+        }
+      }
+      return selected;
+    }
+  }
+  return 0;
+}
+
+BulkInferenceStats::BulkInferenceStats()
+    : rows_(0), batches_(0), elapsed_ns_(0), source_ns_(0), sink_ns_(0),
+      rows_per_sec_(0)
+{
+}
+
+namespace {
+
+// Source that slices whole tensors along their first dimension.
+class TensorSource : public BulkInferenceSource {
+ public:
+  TensorSource(const std::unordered_map<std::string, Tensor>& tensors)
+      : row_count_(0), next_row_(0)
+  {
+    bool first = true;
+    for (const auto& tensor : tensors) {
+      if (tensor.second.data_type_ == DataType::BYTES) {
+        throw TritonException(
+            "Tensor '" + tensor.first +
+            "' is of type 'BYTES', which can not be sliced into rows.");
+      }
+      if (tensor.second.shape_.empty()) {
+        throw TritonException(
+            "Tensor '" + tensor.first + "' has no first dimension.");
+      }
+      const size_t row_count = tensor.second.shape_[0];
+      if (first) {
+        row_count_ = row_count;
+        first = false;
+      } else if (row_count != row_count_) {
+        throw TritonException(
+            "Tensor '" + tensor.first + "' has " + std::to_string(row_count) +
+            " rows, expected " + std::to_string(row_count_) + ".");
+      }
+      // Keep a copy of the tensor so that the owner of the buffer, if any,
+      // outlives the batches referring to it.
+      tensors_.emplace(
+          tensor.first, std::make_shared<Tensor>(tensor.second));
+      row_byte_sizes_[tensor.first] =
+          (row_count == 0) ? 0 : tensor.second.byte_size_ / row_count;
+    }
+  }
+
+  size_t Next(
+      const size_t max_rows,
+      std::unordered_map<std::string, Tensor>* batch) override
+  {
+    const size_t row_count = std::min(max_rows, row_count_ - next_row_);
+    if (row_count == 0) {
+      return 0;
+    }
+    batch->clear();
+    for (const auto& tensor : tensors_) {
+      const size_t row_byte_size = row_byte_sizes_[tensor.first];
+      std::vector<int64_t> shape = tensor.second->shape_;
+      shape[0] = row_count;
+      Tensor slice(
+          tensor.second->buffer_ + next_row_ * row_byte_size,
+          row_count * row_byte_size, tensor.second->data_type_, shape,
+          tensor.second->memory_type_, tensor.second->memory_type_id_);
+      SetBufferOwner(slice, tensor.second);
+      batch->emplace(tensor.first, slice);
+    }
+    next_row_ += row_count;
+    return row_count;
+  }
+
+ private:
+  std::unordered_map<std::string, std::shared_ptr<Tensor>> tensors_;
+  std::unordered_map<std::string, size_t> row_byte_sizes_;
+  size_t row_count_;
+  size_t next_row_;
+};
+
+// Source that copies the rows read from a function into the batches.
+class RowSource : public BulkInferenceSource {
+ public:
+  RowSource(
+      std::function<bool(std::unordered_map<std::string, Tensor>* row)>
+          next_row)
+      : next_row_(next_row), done_(false)
+  {
+  }
+
+  size_t Next(
+      const size_t max_rows,
+      std::unordered_map<std::string, Tensor>* batch) override
+  {
+    // Each batch gets its own buffers as the previous batches may still be
+    // inferenced.
+    std::unordered_map<std::string, std::shared_ptr<std::vector<char>>>
+        buffers;
+    size_t row_count = 0;
+    while (!done_ && (row_count < max_rows)) {
+      std::unordered_map<std::string, Tensor> row;
+      if (!next_row_(&row)) {
+        done_ = true;
+        break;
+      }
+      for (const auto& tensor : row) {
+        if ((tensor.second.memory_type_ != MemoryType::CPU) &&
+            (tensor.second.memory_type_ != MemoryType::CPU_PINNED)) {
+          throw TritonException(
+              "Tensor '" + tensor.first + "' of row " +
+              std::to_string(row_count) + " is not in CPU memory.");
+        }
+        auto it = layouts_.find(tensor.first);
+        if (it == layouts_.end()) {
+          it = layouts_
+                   .emplace(
+                       tensor.first,
+                       std::make_pair(
+                           tensor.second.data_type_, tensor.second.shape_))
+                   .first;
+        } else if (
+            (it->second.first != tensor.second.data_type_) ||
+            (it->second.second != tensor.second.shape_)) {
+          throw TritonException(
+              "Tensor '" + tensor.first +
+              "' does not have the same data type and shape in every row.");
+        }
+        std::shared_ptr<std::vector<char>>& buffer = buffers[tensor.first];
+        if (buffer == nullptr) {
+          buffer = std::make_shared<std::vector<char>>();
+          buffer->reserve(max_rows * tensor.second.byte_size_);
+        }
+        buffer->insert(
+            buffer->end(), tensor.second.buffer_,
+            tensor.second.buffer_ + tensor.second.byte_size_);
+      }
+      row_count++;
+    }
+    if (row_count == 0) {
+      return 0;
+    }
+
+    batch->clear();
+    for (auto& buffer : buffers) {
+      const auto& layout = layouts_[buffer.first];
+      std::vector<int64_t> shape{static_cast<int64_t>(row_count)};
+      shape.insert(shape.end(), layout.second.begin(), layout.second.end());
+      Tensor tensor(
+          buffer.second->data(), buffer.second->size(), layout.first, shape,
+          MemoryType::CPU, 0);
+      SetBufferOwner(tensor, buffer.second);
+      batch->emplace(buffer.first, tensor);
+    }
+    return row_count;
+  }
+
+ private:
+  std::function<bool(std::unordered_map<std::string, Tensor>* row)> next_row_;
+  // The data type and the shape of the tensors of a row, set from the first
+  // row.
+  std::unordered_map<std::string, std::pair<DataType, std::vector<int64_t>>>
+      layouts_;
+  bool done_;
+};
+
+}  // namespace
+
+std::unique_ptr<BulkInferenceSource>
+BulkInferenceSource::FromTensors(
+    const std::unordered_map<std::string, Tensor>& tensors)
+{
+  try {
+    return std::unique_ptr<BulkInferenceSource>(new TensorSource(tensors));
+  }
+  catch (const TritonException& ex) {
+    throw TritonException(std::string("Error - FromTensors: ") + ex.what());
+  }
+}
+
+std::unique_ptr<BulkInferenceSource>
+BulkInferenceSource::FromRows(
+    std::function<bool(std::unordered_map<std::string, Tensor>* row)>
+        next_row)
+{
+  return std::unique_ptr<BulkInferenceSource>(new RowSource(next_row));
+}
+
+std::unique_ptr<BulkInferenceRunner>
+BulkInferenceRunner::Create(
+    TritonServer& server, const InferOptions& infer_options,
+    const size_t max_inflight, const size_t batch_size)
+{
+  try {
+    if (max_inflight == 0) {
+      throw TritonException("'max_inflight' must be greater than 0.");
+    }
+    size_t resolved_batch_size = batch_size;
+    if (resolved_batch_size == 0) {
+      common::TritonJson::Value config;
+      std::string config_str = server.ModelConfig(
+          infer_options.model_name_, infer_options.model_version_);
+      THROW_IF_TRITON_ERR(config.Parse(config_str.c_str(), config_str.size()));
+      int64_t max_batch_size = 0;
+      if (config.Find("max_batch_size")) {
+        THROW_IF_TRITON_ERR(
+            config.MemberAsInt("max_batch_size", &max_batch_size));
+      }
+      if (max_batch_size <= 0) {
+        throw TritonException(
+            "Model '" + infer_options.model_name_ +
+            "' does not support batching.");
+      }
+      resolved_batch_size = max_batch_size;
+    }
+    return std::unique_ptr<BulkInferenceRunner>(new BulkInferenceRunner(
+        server, infer_options, max_inflight, resolved_batch_size));
+  }
+  catch (const TritonException& ex) {
+    throw TritonException(
+        std::string("Error - BulkInferenceRunner::Create: ") + ex.what());
+  }
+}
+
+BulkInferenceRunner::BulkInferenceRunner(
+    TritonServer& server, const InferOptions& infer_options,
+    const size_t max_inflight, const size_t batch_size)
+    : server_(server), infer_options_(infer_options),
+      max_inflight_(max_inflight), batch_size_(batch_size)
+{
+}
+
+BulkInferenceStats
+BulkInferenceRunner::Run(
+    BulkInferenceSource& source, SinkFn sink, ProgressFn progress,
+    const uint64_t progress_interval)
+{
+  struct Batch {
+    uint64_t first_row_;
+    size_t row_count_;
+    std::unique_ptr<InferRequest> request_;
+    std::future<std::unique_ptr<InferResult>> result_future_;
+  };
+
+  std::mutex mu;
+  std::condition_variable cv;
+  // The batches in flight in the order of the rows. Only the writer thread
+  // removes batches, so the front batch can be used without holding the lock.
+  std::deque<Batch> inflight;
+  bool source_done = false;
+  std::string error;
+
+  BulkInferenceStats stats;
+  std::atomic<uint64_t> source_ns(0);
+  const auto start = std::chrono::steady_clock::now();
+  auto elapsed_ns = [&start]() -> uint64_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+  };
+
+  // Pass the results to the sink in order while the next batches are read
+  // and inferenced. Any error is recorded in 'error' rather than thrown, so
+  // that the reading side stops and the writer still drains the batches in
+  // flight.
+  std::thread writer([&]() {
+    while (true) {
+      Batch* batch;
+      bool failed;
+      {
+        std::unique_lock<std::mutex> lk(mu);
+        cv.wait(lk, [&]() { return !inflight.empty() || source_done; });
+        if (inflight.empty()) {
+          break;
+        }
+        batch = &inflight.front();
+        failed = !error.empty();
+      }
+
+      const std::string batch_name =
+          "Batch starting at row " + std::to_string(batch->first_row_);
+      std::string batch_error;
+      try {
+        std::unique_ptr<InferResult> result = batch->result_future_.get();
+        if (result->HasError()) {
+          batch_error = batch_name + " failed: " + result->ErrorMsg();
+        } else if (!failed) {
+          const auto sink_start = std::chrono::steady_clock::now();
+          try {
+            sink(batch->first_row_, batch->row_count_, *result);
+          }
+          catch (const std::exception& ex) {
+            batch_error = ex.what();
+          }
+          catch (...) {
+            batch_error = batch_name + " failed in the sink: unknown error";
+          }
+          stats.sink_ns_ +=
+              std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - sink_start)
+                  .count();
+          stats.rows_ += batch->row_count_;
+          stats.batches_++;
+          stats.elapsed_ns_ = elapsed_ns();
+          stats.source_ns_ = source_ns.load();
+          if ((progress != nullptr) && (progress_interval > 0) &&
+              (stats.batches_ % progress_interval == 0)) {
+            stats.rows_per_sec_ = stats.rows_ * 1e9 / stats.elapsed_ns_;
+            progress(stats);
+          }
+        }
+      }
+      catch (const std::exception& ex) {
+        if (batch_error.empty()) {
+          batch_error = batch_name + " failed: " + ex.what();
+        }
+      }
+      catch (...) {
+        if (batch_error.empty()) {
+          batch_error = batch_name + " failed: unknown error";
+        }
+      }
+
+      std::lock_guard<std::mutex> lk(mu);
+      if (error.empty() && !batch_error.empty()) {
+        error = batch_error;
+      }
+      inflight.pop_front();
+      cv.notify_all();
+    }
+  });
+
+  // Stop and join the writer on every exit path, as it refers to the state
+  // of this function.
+  class WriterJoiner {
+   public:
+    WriterJoiner(
+        std::thread& writer, std::mutex& mu, std::condition_variable& cv,
+        bool& source_done)
+        : writer_(writer), mu_(mu), cv_(cv), source_done_(source_done)
+    {
+    }
+    ~WriterJoiner()
+    {
+      {
+        std::lock_guard<std::mutex> lk(mu_);
+        source_done_ = true;
+        cv_.notify_all();
+      }
+      writer_.join();
+    }
+
+   private:
+    std::thread& writer_;
+    std::mutex& mu_;
+    std::condition_variable& cv_;
+    bool& source_done_;
+  };
+
+  {
+    WriterJoiner joiner(writer, mu, cv, source_done);
+    uint64_t next_row = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lk(mu);
+        cv.wait(lk, [&]() {
+          return (inflight.size() < max_inflight_) || !error.empty();
+        });
+        if (!error.empty()) {
+          break;
+        }
+      }
+
+      try {
+        std::unordered_map<std::string, Tensor> inputs;
+        const auto source_start = std::chrono::steady_clock::now();
+        const size_t row_count = source.Next(batch_size_, &inputs);
+        source_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - source_start)
+                         .count();
+        if (row_count == 0) {
+          break;
+        }
+
+        Batch batch{next_row, row_count, InferRequest::Create(infer_options_),
+                    std::future<std::unique_ptr<InferResult>>()};
+        for (const auto& input : inputs) {
+          batch.request_->AddInput(input.first, input.second);
+        }
+        batch.result_future_ = server_.AsyncInfer(*batch.request_);
+        next_row += row_count;
+
+        std::lock_guard<std::mutex> lk(mu);
+        inflight.push_back(std::move(batch));
+        cv.notify_all();
+      }
+      catch (const std::exception& ex) {
+        std::lock_guard<std::mutex> lk(mu);
+        if (error.empty()) {
+          error = ex.what();
+        }
+        break;
+      }
+      catch (...) {
+        std::lock_guard<std::mutex> lk(mu);
+        if (error.empty()) {
+          error = "Failed to read the batch starting at row " +
+                  std::to_string(next_row) + ": unknown error";
+        }
+        break;
+      }
+    }
+  }
+
+  if (!error.empty()) {
+    throw TritonException(std::string("Error - Run: ") + error);
+  }
+  stats.elapsed_ns_ = elapsed_ns();
+  stats.source_ns_ = source_ns.load();
+  if (stats.elapsed_ns_ > 0) {
+    stats.rows_per_sec_ = stats.rows_ * 1e9 / stats.elapsed_ns_;
+  }
+  if (progress != nullptr) {
+    progress(stats);
+  }
+  return stats;
+}
+
+ReplayOptions::ReplayOptions() : preserve_timing_(true), max_inflight_(16) {}
+
+ReplayOptions::ReplayOptions(
+    const bool preserve_timing, const size_t max_inflight)
+    : preserve_timing_(preserve_timing), max_inflight_(max_inflight)
+{
+}
+
+ReplayStats::ReplayStats()
+    : requests_(0), failed_(0), elapsed_ns_(0), mean_ns_(0), p50_ns_(0),
+      p90_ns_(0), p99_ns_(0), max_ns_(0)
+{
+}
+
+std::unique_ptr<RequestReplayer>
+RequestReplayer::Create(const std::string& path)
+{
+  try {
+    std::unique_ptr<RequestReplayer> replayer(new RequestReplayer());
+    RequestLogReader reader(path);
+    RecordedRequest record;
+    while (reader.Next(&record)) {
+      replayer->records_.push_back(record);
+    }
+    return replayer;
+  }
+  catch (const TritonException& ex) {
+    throw TritonException(
+        std::string("Error - RequestReplayer::Create: ") + ex.what());
+  }
+}
+
+ReplayStats
+RequestReplayer::Run(TritonServer& server, const ReplayOptions& replay_options)
+{
+  std::mutex mu;
+  std::condition_variable cv;
+  size_t inflight = 0;
+  uint64_t failed = 0;
+  std::vector<uint64_t> latencies;
+  latencies.reserve(records_.size());
+  // The requests must outlive their results.
+  std::vector<std::unique_ptr<InferRequest>> requests;
+  requests.reserve(records_.size());
+
+  const size_t max_inflight =
+      (replay_options.max_inflight_ == 0) ? 1 : replay_options.max_inflight_;
+  const auto start = std::chrono::steady_clock::now();
+  const uint64_t first_arrival_ns =
+      records_.empty() ? 0 : records_.front().arrival_ns_;
+  std::string error;
+  for (const auto& record : records_) {
+    if (replay_options.preserve_timing_) {
+      std::this_thread::sleep_until(
+          start +
+          std::chrono::nanoseconds(record.arrival_ns_ - first_arrival_ns));
+    } else {
+      std::unique_lock<std::mutex> lk(mu);
+      cv.wait(lk, [&]() { return inflight < max_inflight; });
+    }
+
+    InferOptions options(
+        record.model_name_, record.model_version_, record.request_id_,
+        record.correlation_id_, record.correlation_id_str_,
+        record.sequence_start_, record.sequence_end_, record.priority_,
+        record.request_timeout_, nullptr /* custom_allocator */,
+        nullptr /* trace */);
+    std::unique_ptr<InferRequest> request = InferRequest::Create(options);
+    for (const auto& input : record.inputs_) {
+      request->AddInput(
+          input.name_,
+          Tensor(
+              const_cast<char*>(input.data_.data()), input.data_.size(),
+              input.data_type_, input.shape_, MemoryType::CPU, 0));
+    }
+    for (const auto& name : record.output_names_) {
+      request->AddRequestedOutput(name);
+    }
+
+    const auto send = std::chrono::steady_clock::now();
+    request->completion_fn_ = [&mu, &cv, &inflight, &failed, &latencies,
+                               send](std::unique_ptr<InferResult>&& result) {
+      const uint64_t latency_ns =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - send)
+              .count();
+      std::lock_guard<std::mutex> lk(mu);
+      latencies.push_back(latency_ns);
+      if (result->HasError()) {
+        failed++;
+      }
+      inflight--;
+      cv.notify_all();
+    };
+    {
+      std::lock_guard<std::mutex> lk(mu);
+      inflight++;
+    }
+    try {
+      server.StartInfer(*request);
+    }
+    catch (const TritonException& ex) {
+      std::lock_guard<std::mutex> lk(mu);
+      inflight--;
+      error = ex.what();
+      break;
+    }
+    requests.emplace_back(std::move(request));
+  }
+
+  {
+    std::unique_lock<std::mutex> lk(mu);
+    cv.wait(lk, [&]() { return inflight == 0; });
+  }
+  if (!error.empty()) {
+    throw TritonException(std::string("Error - Run: ") + error);
+  }
+
+  ReplayStats stats;
+  stats.elapsed_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+  stats.requests_ = latencies.size();
+  stats.failed_ = failed;
+  if (!latencies.empty()) {
+    std::sort(latencies.begin(), latencies.end());
+    uint64_t total_ns = 0;
+    for (const uint64_t latency_ns : latencies) {
+      total_ns += latency_ns;
+    }
+    // Nearest-rank percentile.
+    auto percentile = [&latencies](const double p) {
+      size_t rank = static_cast<size_t>(std::ceil(p * latencies.size()));
+      return latencies[(rank == 0) ? 0 : rank - 1];
+    };
+    stats.mean_ns_ = total_ns / latencies.size();
+    stats.p50_ns_ = percentile(0.50);
+    stats.p90_ns_ = percentile(0.90);
+    stats.p99_ns_ = percentile(0.99);
+    stats.max_ns_ = latencies.back();
+  }
+  return stats;
+}
+
+InferResult::InferResult()
+    : has_error_(false), error_msg_(""), completed_response_(nullptr)
+{
+}
+
+InferResult::~InferResult() {}
+
+InternalResult::InternalResult() : InferResult() {}
+
+InternalResult::~InternalResult()
+{
+  if (completed_response_ != nullptr) {
+    LOG_IF_ERROR(
+        TRITONSERVER_InferenceResponseDelete(completed_response_),
+        "Failed to delete inference response.");
+  }
+}
+
+void
+InternalResult::FinalizeResponse(
+    TRITONSERVER_InferenceResponse* response, const AllocInfo& alloc_info)
+{
+  try {
+    THROW_IF_TRITON_ERR(TRITONSERVER_InferenceResponseError(response));
+
+    const char* model_name;
+    int64_t model_version;
+    THROW_IF_TRITON_ERR(TRITONSERVER_InferenceResponseModel(
+        response, &model_name, &model_version));
+    const char* request_id = nullptr;
+    THROW_IF_TRITON_ERR(
+        TRITONSERVER_InferenceResponseId(response, &request_id));
+    model_name_ = model_name;
+    model_version_ = model_version;
+    request_id_ = request_id;
+
+    uint32_t parameter_count;
+    THROW_IF_TRITON_ERR(TRITONSERVER_InferenceResponseParameterCount(
+        response, &parameter_count));
+    for (uint32_t pidx = 0; pidx < parameter_count; ++pidx) {
+      const char* name;
+      TRITONSERVER_ParameterType type;
+      const void* vvalue;
+      THROW_IF_TRITON_ERR(TRITONSERVER_InferenceResponseParameter(
+          response, pidx, &name, &type, &vvalue));
+      params_.push_back(std::move(std::unique_ptr<ResponseParameters>(
+          new ResponseParameters(name, type, vvalue))));
+    }
+
+    uint32_t output_count;
+    THROW_IF_TRITON_ERR(
+        TRITONSERVER_InferenceResponseOutputCount(response, &output_count));
+
+    for (uint32_t idx = 0; idx < output_count; ++idx) {
+      const char* cname;
+      TRITONSERVER_DataType datatype;
+      const int64_t* shape;
+      uint64_t dim_count;
+      const void* base;
+      size_t byte_size;
+      TRITONSERVER_MemoryType memory_type;
+      int64_t memory_type_id;
+      void* userp;
+      THROW_IF_TRITON_ERR(TRITONSERVER_InferenceResponseOutput(
+          response, idx, &cname, &datatype, &shape, &dim_count, &base,
+          &byte_size, &memory_type, &memory_type_id, &userp));
+
+      std::string name(cname);
 
       std::vector<int64_t> output_shape;
       for (uint64_t i = 0; i < dim_count; i++) {
@@ -1858,9 +4536,25 @@ InternalResult::FinalizeResponse(
           TritonToDataType(datatype), output_shape, mem_type, memory_type_id);
 
       // Set allocation info for the output tensor.
-      infer_outputs_[name]->custom_allocator_ = alloc_info.first;
-      if (alloc_info.second.find(name) != alloc_info.second.end()) {
+      infer_outputs_[name]->custom_allocator_ = std::get<0>(alloc_info);
+      if (std::get<1>(alloc_info).find(name) != std::get<1>(alloc_info).end()) {
         infer_outputs_[name]->is_pre_alloc_ = true;
+        auto it = std::get<2>(alloc_info).find(name);
+        if (it != std::get<2>(alloc_info).end()) {
+          infer_outputs_[name]->buffer_owner_ = it->second;
+        }
+      } else if (
+          (std::get<0>(alloc_info) == nullptr) &&
+          (std::get<3>(alloc_info) != nullptr) && (byte_size > 0)) {
+        // Account the release of the buffer allocated by the default
+        // allocator once the output tensor and all its copies are destroyed.
+        std::shared_ptr<AllocationTracker> tracker = std::get<3>(alloc_info);
+        std::string model = model_name_;
+        infer_outputs_[name]->buffer_owner_ = std::shared_ptr<void>(
+            const_cast<void*>(base),
+            [tracker, model, mem_type, byte_size](void*) {
+              tracker->Released(model, mem_type, byte_size);
+            });
       }
       infer_outputs_[name]->is_output_ = true;
     }
@@ -1879,6 +4573,16 @@ InternalResult::FinalizeResponse(
   completed_response_ = response;
 }
 
+void
+InternalResult::FinalizeError(const std::string& error_msg)
+{
+  model_name_ = "";
+  model_version_ = -1;
+  request_id_ = "";
+  has_error_ = true;
+  error_msg_ = error_msg;
+}
+
 std::string
 InferResult::ModelName() noexcept
 {
@@ -1923,6 +4627,52 @@ InferResult::Output(const std::string& name)
   return output;
 }
 
+DLManagedTensor*
+InferResult::OutputAsDLPack(const std::string& name)
+{
+  try {
+    auto it = infer_outputs_.find(name);
+    if (it == infer_outputs_.end()) {
+      throw TritonException(
+          "The response does not contain result for output '" + name + "'.");
+    }
+
+    std::unique_ptr<DLPackOutput> dlpack_output(new DLPackOutput());
+    dlpack_output->output_ = it->second;
+    dlpack_output->shape_ = it->second->shape_;
+
+    DLTensor& tensor = dlpack_output->dl_tensor_.dl_tensor;
+    tensor.data = it->second->buffer_;
+    switch (it->second->memory_type_) {
+      case MemoryType::CPU:
+        tensor.device.device_type = kDLCPU;
+        tensor.device.device_id = 0;
+        break;
+      case MemoryType::CPU_PINNED:
+        tensor.device.device_type = kDLCUDAHost;
+        tensor.device.device_id = 0;
+        break;
+      case MemoryType::GPU:
+        tensor.device.device_type = kDLCUDA;
+        tensor.device.device_id = it->second->memory_type_id_;
+        break;
+    }
+    tensor.ndim = dlpack_output->shape_.size();
+    tensor.dtype = DataTypeToDLPack(it->second->data_type_);
+    tensor.shape = dlpack_output->shape_.data();
+    tensor.strides = nullptr;
+    tensor.byte_offset = 0;
+
+    dlpack_output->dl_tensor_.manager_ctx = dlpack_output.get();
+    dlpack_output->dl_tensor_.deleter = DLPackOutput::Deleter;
+
+    return &(dlpack_output.release()->dl_tensor_);
+  }
+  catch (const TritonException& ex) {
+    throw TritonException(std::string("Error - OutputAsDLPack: ") + ex.what());
+  }
+}
+
 std::vector<std::string>
 InferResult::StringData(const std::string& name)
 {
@@ -2049,4 +4799,143 @@ InferResult::GetNextResult()
   return std::move(next_result_future_);
 }
 
+ResponseStream::ResponseStream(const size_t capacity)
+    : ring_(
+          size_t(1) << static_cast<size_t>(
+              std::ceil(std::log2(std::max<size_t>(capacity, 2))))),
+      mask_(ring_.size() - 1), head_(0), tail_(0), finished_(false),
+      cancelled_(false), consumer_waiting_(false), producer_waiting_(false)
+{
+}
+
+ResponseStream::~ResponseStream() {}
+
+std::unique_ptr<InferResult>
+ResponseStream::Next()
+{
+  std::unique_ptr<InferResult> result;
+  while (!TryNext(&result)) {
+    if (cancelled_.load()) {
+      return nullptr;
+    }
+    if (finished_.load()) {
+      // Responses pushed before the stream was finished are still visible.
+      TryNext(&result);
+      return result;
+    }
+    std::unique_lock<std::mutex> lk(mu_);
+    consumer_waiting_.store(true);
+    cv_.wait(lk, [this]() {
+      return (tail_.load() != head_.load(std::memory_order_relaxed)) ||
+             finished_.load() || cancelled_.load();
+    });
+    consumer_waiting_.store(false);
+  }
+  return result;
+}
+
+bool
+ResponseStream::TryNext(std::unique_ptr<InferResult>* result)
+{
+  const size_t head = head_.load(std::memory_order_relaxed);
+  if (cancelled_.load() || (head == tail_.load(std::memory_order_acquire))) {
+    return false;
+  }
+  *result = std::move(ring_[head & mask_]);
+  head_.store(head + 1);
+  if (producer_waiting_.load()) {
+    std::lock_guard<std::mutex> lk(mu_);
+    cv_.notify_all();
+  }
+  return true;
+}
+
+size_t
+ResponseStream::Drain(
+    std::vector<std::unique_ptr<InferResult>>* results, const size_t max_count)
+{
+  if (cancelled_.load()) {
+    return 0;
+  }
+  const size_t head = head_.load(std::memory_order_relaxed);
+  size_t count = tail_.load(std::memory_order_acquire) - head;
+  if ((max_count != 0) && (count > max_count)) {
+    count = max_count;
+  }
+  if (count == 0) {
+    return 0;
+  }
+  for (size_t i = 0; i < count; i++) {
+    results->push_back(std::move(ring_[(head + i) & mask_]));
+  }
+  head_.store(head + count);
+  if (producer_waiting_.load()) {
+    std::lock_guard<std::mutex> lk(mu_);
+    cv_.notify_all();
+  }
+  return count;
+}
+
+bool
+ResponseStream::IsFinished()
+{
+  return finished_.load() &&
+         (head_.load(std::memory_order_relaxed) == tail_.load());
+}
+
+void
+ResponseStream::Push(std::unique_ptr<InferResult>&& result)
+{
+  if (cancelled_.load()) {
+    return;
+  }
+  const size_t tail = tail_.load(std::memory_order_relaxed);
+  if ((tail - head_.load(std::memory_order_acquire)) == ring_.size()) {
+    // The ring is full. Block the server until the consumer catches up or
+    // cancels the stream.
+    std::unique_lock<std::mutex> lk(mu_);
+    producer_waiting_.store(true);
+    cv_.wait(lk, [this, tail]() {
+      return ((tail - head_.load()) < ring_.size()) || cancelled_.load();
+    });
+    producer_waiting_.store(false);
+    if (cancelled_.load()) {
+      return;
+    }
+  }
+  ring_[tail & mask_] = std::move(result);
+  tail_.store(tail + 1);
+  if (consumer_waiting_.load()) {
+    std::lock_guard<std::mutex> lk(mu_);
+    cv_.notify_all();
+  }
+}
+
+void
+ResponseStream::Cancel()
+{
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    cancelled_.store(true);
+    cv_.notify_all();
+  }
+  // Release the responses not retrieved. The producer no longer writes to
+  // the ring once it sees the stream cancelled, and any response it pushed
+  // concurrently is released with the stream.
+  const size_t head = head_.load(std::memory_order_relaxed);
+  const size_t tail = tail_.load(std::memory_order_acquire);
+  for (size_t i = head; i != tail; i++) {
+    ring_[i & mask_].reset();
+  }
+  head_.store(tail);
+}
+
+void
+ResponseStream::Finish()
+{
+  finished_.store(true);
+  std::lock_guard<std::mutex> lk(mu_);
+  cv_.notify_all();
+}
+
 }}}  // namespace triton::developer_tools::server
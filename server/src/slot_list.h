@@ -0,0 +1,108 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace triton { namespace developer_tools { namespace server {
+
+//==============================================================================
+/// A list of named objects that keeps the storage of its entries when they
+/// are erased or the list is cleared. The released slots, including their
+/// names and objects, are reused in place by the next entries, so that
+/// refilling the list with the same number of entries does not allocate as
+/// long as the objects are overwritten without growing their members. The
+/// lookup is linear, which is cheaper than hashing for the handful of tensors
+/// of an inference request. 'erase' does not preserve the order of the
+/// entries.
+///
+template <typename T>
+class SlotList {
+ public:
+  using Slot = std::pair<std::string, std::unique_ptr<T>>;
+  using iterator = typename std::vector<Slot>::iterator;
+  using const_iterator = typename std::vector<Slot>::const_iterator;
+
+  SlotList() : size_(0) {}
+
+  iterator begin() { return slots_.begin(); }
+  iterator end() { return slots_.begin() + size_; }
+  const_iterator begin() const { return slots_.begin(); }
+  const_iterator end() const { return slots_.begin() + size_; }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  iterator find(const std::string& name)
+  {
+    return std::find_if(begin(), end(), [&name](const Slot& slot) {
+      return slot.first == name;
+    });
+  }
+
+  // Return the object of the entry 'name', taking a released slot for it if
+  // there is no such entry. The returned object is nullptr if the slot has
+  // never been used, otherwise it holds its last value and should be
+  // overwritten by the caller.
+  std::unique_ptr<T>& Acquire(const std::string& name)
+  {
+    auto it = find(name);
+    if (it != end()) {
+      return it->second;
+    }
+    if (size_ == slots_.size()) {
+      slots_.emplace_back();
+    }
+    Slot& slot = slots_[size_++];
+    slot.first.assign(name);
+    return slot.second;
+  }
+
+  // Release the slot of the entry at 'it' and return the iterator to the
+  // entry that takes its position.
+  iterator erase(iterator it)
+  {
+    --size_;
+    if (it != end()) {
+      std::swap(*it, *end());
+    }
+    return it;
+  }
+
+  // Release all the slots.
+  void clear() { size_ = 0; }
+
+ private:
+  // The slots, only the first 'size_' of them are in use.
+  std::vector<Slot> slots_;
+  size_t size_;
+};
+
+}}}  // namespace triton::developer_tools::server
@@ -25,7 +25,16 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "gtest/gtest.h"
 
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <exception>
+#include <fstream>
+#include <future>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include "dlpack/dlpack.h"
 #include "triton/core/tritonserver.h"
 #include "triton/developer_tools/server_wrapper.h"
 
@@ -33,6 +42,38 @@ namespace tds = triton::developer_tools::server;
 
 namespace {
 
+// The number of allocations through the global 'operator new' made by the
+// current thread, used to check that the steady state of an API does not
+// allocate.
+thread_local uint64_t allocation_count = 0;
+
+}  // namespace
+
+void*
+operator new(std::size_t size)
+{
+  ++allocation_count;
+  void* ptr = malloc((size == 0) ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+  free(ptr);
+}
+
+void
+operator delete(void* ptr, std::size_t) noexcept
+{
+  free(ptr);
+}
+
+namespace {
+
 TEST(TritonServer, LibraryVersionCheck)
 {
   // Check that proper 'libtritonserver.so' is used
@@ -191,6 +232,62 @@ TEST_F(TritonServerTest, Explicit)
   }
 }
 
+TEST_F(TritonServerTest, LoadWithWarmup)
+{
+  try {
+    options_.model_control_mode_ = tds::ModelControlMode::EXPLICIT;
+    auto server = tds::TritonServer::Create(options_);
+
+    // 'add_sub' does not support batching so a single pass without batch
+    // dimension is expected.
+    std::vector<tds::WarmupStats> stats =
+        server->LoadModel("add_sub", tds::WarmupOptions());
+    ASSERT_EQ(stats.size(), 1);
+    ASSERT_EQ(stats[0].batch_size_, 0);
+    ASSERT_EQ(stats[0].count_, 5);
+    ASSERT_LE(stats[0].min_ns_, stats[0].max_ns_);
+    ASSERT_GE(stats[0].total_ns_, stats[0].first_ns_);
+    ASSERT_TRUE(server->IsModelReady("add_sub"));
+    ASSERT_EQ(server->LoadedModels().size(), 1);
+    ASSERT_EQ(server->WarmupStatistics("add_sub").size(), 1);
+    ASSERT_TRUE(server->WarmupStatistics("add_sub_str").empty());
+
+    // Warm up with user-provided samples.
+    std::vector<int32_t> input_data(16, 1);
+    auto sample = std::make_shared<tds::Tensor>(
+        reinterpret_cast<char*>(input_data.data()),
+        input_data.size() * sizeof(int32_t), tds::DataType::INT32,
+        std::vector<int64_t>{16}, tds::MemoryType::CPU, 0);
+    stats = server->WarmupModel(
+        "add_sub", tds::WarmupOptions(
+                       -1, {}, 2, {{"INPUT0", sample}, {"INPUT1", sample}}));
+    ASSERT_EQ(stats.size(), 1);
+    ASSERT_EQ(stats[0].count_, 2);
+
+    // The model stays hidden until every concurrent warm-up of it completes.
+    auto warmup = [&server, &sample](const uint32_t iterations) {
+      return server->WarmupModel(
+          "add_sub",
+          tds::WarmupOptions(
+              -1, {}, iterations, {{"INPUT0", sample}, {"INPUT1", sample}}));
+    };
+    auto long_warmup = std::async(std::launch::async, warmup, 2000);
+    auto short_warmup = std::async(std::launch::async, warmup, 1);
+    short_warmup.get();
+    if (server->IsModelReady("add_sub")) {
+      ASSERT_EQ(
+          long_warmup.wait_for(std::chrono::seconds(0)),
+          std::future_status::ready);
+    }
+    long_warmup.get();
+    ASSERT_TRUE(server->IsModelReady("add_sub"));
+    ASSERT_EQ(server->LoadedModels().size(), 1);
+  }
+  catch (...) {
+    ASSERT_NO_THROW(throw);
+  }
+}
+
 TEST_F(TritonServerTest, ModelRepoRegister)
 {
   try {
@@ -285,6 +382,864 @@ TEST_F(TritonServerTest, InferMinimal)
   }
 }
 
+TEST_F(TritonServerTest, InferLoadOnDemand)
+{
+  try {
+    options_.model_control_mode_ = tds::ModelControlMode::EXPLICIT;
+    options_.model_residency_ = std::make_shared<tds::ModelResidency>(
+        0 /* host_budget_byte_size */, 0 /* device_budget_byte_size */);
+    auto server = tds::TritonServer::Create(options_);
+    ASSERT_EQ(server->LoadedModels().size(), 0);
+
+    std::vector<int32_t> input_data(16, 1);
+    auto request = tds::InferRequest::Create(tds::InferOptions("add_sub"));
+    for (const auto& name : std::vector<std::string>{"INPUT0", "INPUT1"}) {
+      request->AddInput(
+          name, tds::Tensor(
+                    reinterpret_cast<char*>(input_data.data()),
+                    input_data.size() * sizeof(int32_t), tds::DataType::INT32,
+                    {16}, tds::MemoryType::CPU, 0));
+    }
+
+    // The first request is queued behind the load of the model and the second
+    // one is sent to the loaded model directly.
+    for (size_t i = 0; i < 2; i++) {
+      auto result = server->AsyncInfer(*request).get();
+      ASSERT_FALSE(result->HasError()) << result->ErrorMsg();
+      ASSERT_EQ(result->ModelName(), "add_sub");
+    }
+    ASSERT_EQ(server->LoadedModels().size(), 1);
+
+    tds::ModelResidencyStats stats = server->ModelResidencyStatistics();
+    ASSERT_EQ(stats.loads_, 1);
+    ASSERT_EQ(stats.load_stalls_, 1);
+    ASSERT_EQ(stats.hits_, 1);
+    ASSERT_EQ(stats.evictions_, 0);
+    ASSERT_EQ(stats.resident_models_, 1);
+
+    // Requests to a model that does not exist fail through the result.
+    auto missing_request =
+        tds::InferRequest::Create(tds::InferOptions("missing_model"));
+    auto result = server->AsyncInfer(*missing_request).get();
+    ASSERT_TRUE(result->HasError());
+    ASSERT_EQ(server->ModelResidencyStatistics().load_failures_, 1);
+  }
+  catch (...) {
+    ASSERT_NO_THROW(throw);
+  }
+}
+
+TEST_F(TritonServerTest, InferSequenceStream)
+{
+  try {
+    auto server = tds::TritonServer::Create(options_);
+
+    tds::InferOptions infer_options("add_sub");
+    infer_options.correlation_id_ = 42;
+    auto stream = tds::SequenceStream::Create(*server, infer_options, 2);
+
+    // Send more steps than 'max_inflight' while reusing the input buffer, and
+    // check that the results are received in order.
+    const size_t step_count = 6;
+    std::vector<int32_t> input_data(16);
+    for (size_t step = 0; step < step_count; step++) {
+      std::fill(input_data.begin(), input_data.end(), step);
+      tds::Tensor input(
+          reinterpret_cast<char*>(input_data.data()),
+          input_data.size() * sizeof(int32_t), tds::DataType::INT32, {16},
+          tds::MemoryType::CPU, 0);
+      stream->Send(
+          {{"INPUT0", input}, {"INPUT1", input}}, step == (step_count - 1));
+    }
+    ASSERT_TRUE(stream->IsEnded());
+    ASSERT_EQ(stream->Pending(), step_count);
+
+    for (size_t step = 0; step < step_count; step++) {
+      auto result = stream->Receive();
+      ASSERT_FALSE(result->HasError()) << result->ErrorMsg();
+      std::shared_ptr<tds::Tensor> out = result->Output("OUTPUT0");
+      for (size_t i = 0; i < input_data.size(); ++i) {
+        EXPECT_EQ(
+            reinterpret_cast<const int32_t*>(out->buffer_)[i], (2 * step));
+      }
+    }
+    ASSERT_EQ(stream->Receive(), nullptr);
+  }
+  catch (...) {
+    ASSERT_NO_THROW(throw);
+  }
+}
+
+TEST_F(TritonServerTest, InferDLPack)
+{
+  try {
+    auto server = tds::TritonServer::Create(options_);
+
+    // Wrap the input data as a DLPack tensor whose deleter records that it
+    // has been called.
+    struct InputContext {
+      std::vector<int32_t> data_;
+      std::vector<int64_t> shape_;
+      bool* deleted_;
+    };
+    bool input_deleted = false;
+    InputContext* ctx = new InputContext();
+    while (ctx->data_.size() < 16) {
+      ctx->data_.emplace_back(ctx->data_.size());
+    }
+    ctx->shape_ = {16};
+    ctx->deleted_ = &input_deleted;
+    DLManagedTensor* dl_input = new DLManagedTensor();
+    dl_input->dl_tensor.data = ctx->data_.data();
+    dl_input->dl_tensor.device = {kDLCPU, 0};
+    dl_input->dl_tensor.ndim = 1;
+    dl_input->dl_tensor.dtype = {kDLInt, 32, 1};
+    dl_input->dl_tensor.shape = ctx->shape_.data();
+    dl_input->dl_tensor.strides = nullptr;
+    dl_input->dl_tensor.byte_offset = 0;
+    dl_input->manager_ctx = ctx;
+    dl_input->deleter = [](DLManagedTensor* self) {
+      InputContext* ctx = reinterpret_cast<InputContext*>(self->manager_ctx);
+      *(ctx->deleted_) = true;
+      delete ctx;
+      delete self;
+    };
+
+    DLManagedTensor* dl_output = nullptr;
+    {
+      tds::Tensor input = tds::Tensor::FromDLPack(dl_input);
+      ASSERT_EQ(input.data_type_, tds::DataType::INT32);
+      ASSERT_EQ(input.shape_, std::vector<int64_t>{16});
+      ASSERT_EQ(input.byte_size_, 16 * sizeof(int32_t));
+      ASSERT_EQ(input.buffer_, reinterpret_cast<char*>(ctx->data_.data()));
+
+      auto request = tds::InferRequest::Create(tds::InferOptions("add_sub"));
+      request->AddInput("INPUT0", input);
+      request->AddInput("INPUT1", input);
+      auto result = server->AsyncInfer(*request).get();
+      ASSERT_FALSE(result->HasError()) << result->ErrorMsg();
+      ASSERT_FALSE(input_deleted);
+
+      dl_output = result->OutputAsDLPack("OUTPUT0");
+    }
+    // The input is released once the tensor and the request are destroyed,
+    // while the exported output outlives the result.
+    ASSERT_TRUE(input_deleted);
+    ASSERT_NE(dl_output, nullptr);
+    ASSERT_EQ(dl_output->dl_tensor.device.device_type, kDLCPU);
+    ASSERT_EQ(dl_output->dl_tensor.ndim, 1);
+    ASSERT_EQ(dl_output->dl_tensor.shape[0], 16);
+    ASSERT_EQ(dl_output->dl_tensor.dtype.code, kDLInt);
+    ASSERT_EQ(dl_output->dl_tensor.dtype.bits, 32);
+    for (int32_t i = 0; i < 16; ++i) {
+      EXPECT_EQ(
+          reinterpret_cast<const int32_t*>(dl_output->dl_tensor.data)[i],
+          2 * i);
+    }
+    dl_output->deleter(dl_output);
+  }
+  catch (...) {
+    ASSERT_NO_THROW(throw);
+  }
+}
+
+TEST_F(TritonServerTest, InferPipeline)
+{
+  try {
+    auto server = tds::TritonServer::Create(options_);
+
+    // Feed the sum of the first stage to both inputs of the second stage.
+    auto pipeline = tds::Pipeline::Create(*server);
+    size_t first = pipeline->AddStage(tds::InferOptions("add_sub"));
+    size_t second = pipeline->AddStage(tds::InferOptions("add_sub"));
+    pipeline->Connect(first, "OUTPUT0", second, "INPUT0");
+    pipeline->Connect(first, "OUTPUT0", second, "INPUT1");
+    ASSERT_THROW(
+        pipeline->Connect(second, "OUTPUT0", first, "INPUT0"),
+        tds::TritonException);
+
+    std::vector<int32_t> input_data;
+    while (input_data.size() < 16) {
+      input_data.emplace_back(input_data.size());
+    }
+    tds::Tensor input(
+        reinterpret_cast<char*>(input_data.data()),
+        input_data.size() * sizeof(int32_t), tds::DataType::INT32, {16},
+        tds::MemoryType::CPU, 0);
+    std::vector<std::future<std::unique_ptr<tds::InferResult>>> futures;
+    for (size_t i = 0; i < 4; ++i) {
+      futures.push_back(
+          pipeline->AsyncInfer({{"INPUT0", input}, {"INPUT1", input}}));
+    }
+
+    for (auto& future : futures) {
+      auto result = future.get();
+      ASSERT_FALSE(result->HasError()) << result->ErrorMsg();
+      ASSERT_EQ(result->ModelName(), "add_sub");
+
+      std::shared_ptr<tds::Tensor> sum = result->Output("OUTPUT0");
+      std::shared_ptr<tds::Tensor> diff = result->Output("OUTPUT1");
+      ASSERT_EQ(sum->shape_, std::vector<int64_t>{16});
+      for (size_t i = 0; i < input_data.size(); ++i) {
+        EXPECT_EQ(
+            reinterpret_cast<const int32_t*>(sum->buffer_)[i],
+            (4 * input_data[i]));
+        EXPECT_EQ(reinterpret_cast<const int32_t*>(diff->buffer_)[i], 0);
+      }
+    }
+
+    // A missing output fails the run with the error of the stage.
+    auto broken = tds::Pipeline::Create(*server);
+    first = broken->AddStage(tds::InferOptions("add_sub"));
+    second = broken->AddStage(tds::InferOptions("add_sub"));
+    broken->Connect(first, "NOT_EXIST", second, "INPUT0");
+    auto result =
+        broken->AsyncInfer({{"INPUT0", input}, {"INPUT1", input}}).get();
+    ASSERT_TRUE(result->HasError());
+  }
+  catch (...) {
+    ASSERT_NO_THROW(throw);
+  }
+}
+
+TEST_F(TritonServerTest, InferSharded)
+{
+  try {
+    // The shards are not bound to NUMA nodes so that the test does not
+    // depend on the topology of the host.
+    ASSERT_THROW(
+        tds::ShardedServer::Create(
+            options_, {tds::ShardOptions(-1, "0-x", {"cpu"})}),
+        tds::TritonException);
+
+    std::vector<int32_t> input_data;
+    while (input_data.size() < 16) {
+      input_data.emplace_back(input_data.size());
+    }
+    std::atomic<size_t> routed(0);
+    std::vector<std::function<std::unique_ptr<tds::ShardedServer>()>>
+        creators{
+            [this]() {
+              return tds::ShardedServer::Create(
+                  options_, {tds::ShardOptions(-1), tds::ShardOptions(-1)},
+                  tds::ShardedServer::Routing::ROUND_ROBIN);
+            },
+            [this]() {
+              return tds::ShardedServer::Create(
+                  options_, {tds::ShardOptions(-1), tds::ShardOptions(-1)},
+                  tds::ShardedServer::Routing::LEAST_OUTSTANDING);
+            },
+            [this, &routed]() {
+              return tds::ShardedServer::Create(
+                  options_, {tds::ShardOptions(-1), tds::ShardOptions(-1)},
+                  [&routed](
+                      const tds::InferRequest& request,
+                      const std::vector<uint64_t>& outstanding) {
+                    EXPECT_EQ(outstanding.size(), size_t(2));
+                    return routed++ % 2;
+                  });
+            }};
+    for (const auto& create : creators) {
+      auto server = create();
+      ASSERT_EQ(server->ShardCount(), size_t(2));
+      ASSERT_TRUE(server->IsServerReady());
+      ASSERT_TRUE(server->IsModelReady("add_sub"));
+
+      std::vector<std::unique_ptr<tds::InferRequest>> requests;
+      std::vector<std::future<std::unique_ptr<tds::InferResult>>> futures;
+      for (size_t i = 0; i < 8; ++i) {
+        requests.push_back(
+            tds::InferRequest::Create(tds::InferOptions("add_sub")));
+        for (const auto& name : std::vector<std::string>{"INPUT0", "INPUT1"}) {
+          requests.back()->AddInput(
+              name, tds::Tensor(
+                        reinterpret_cast<char*>(input_data.data()),
+                        input_data.size() * sizeof(int32_t),
+                        tds::DataType::INT32, {16}, tds::MemoryType::CPU, 0));
+        }
+        futures.push_back(server->AsyncInfer(*requests.back()));
+      }
+      for (auto& future : futures) {
+        auto result = future.get();
+        ASSERT_FALSE(result->HasError()) << result->ErrorMsg();
+        std::shared_ptr<tds::Tensor> out = result->Output("OUTPUT0");
+        for (size_t i = 0; i < input_data.size(); ++i) {
+          EXPECT_EQ(
+              reinterpret_cast<const int32_t*>(out->buffer_)[i],
+              (2 * input_data[i]));
+        }
+      }
+      for (const auto outstanding : server->OutstandingRequests()) {
+        ASSERT_EQ(outstanding, uint64_t(0));
+      }
+    }
+    EXPECT_EQ(routed.load(), size_t(8));
+
+    // A shard index out of range is reported to the caller.
+    auto server = tds::ShardedServer::Create(
+        options_, {tds::ShardOptions(-1)},
+        [](const tds::InferRequest& request,
+           const std::vector<uint64_t>& outstanding) { return size_t(1); });
+    auto request = tds::InferRequest::Create(tds::InferOptions("add_sub"));
+    ASSERT_THROW(server->AsyncInfer(*request), tds::TritonException);
+    ASSERT_EQ(server->OutstandingRequests()[0], uint64_t(0));
+  }
+  catch (...) {
+    ASSERT_NO_THROW(throw);
+  }
+}
+
+TEST_F(TritonServerTest, InferMappedFile)
+{
+  try {
+    auto server = tds::TritonServer::Create(options_);
+
+    std::vector<int32_t> input_data;
+    while (input_data.size() < 16) {
+      input_data.emplace_back(input_data.size());
+    }
+    // Write the input as a raw file with a leading padding and as a '.npy'
+    // file with a version 1.0 header padded to 64 bytes.
+    {
+      std::ofstream raw("mapped_input.bin", std::ios::binary);
+      raw << "PAD!";
+      raw.write(
+          reinterpret_cast<const char*>(input_data.data()),
+          input_data.size() * sizeof(int32_t));
+
+      std::string header =
+          "{'descr': '<i4', 'fortran_order': False, 'shape': (16,), }";
+      header.resize(117, ' ');
+      header += '\n';
+      std::ofstream npy("mapped_input.npy", std::ios::binary);
+      npy << "\x93NUMPY" << '\x01' << '\x00';
+      npy << static_cast<char>(header.size() & 0xFF)
+          << static_cast<char>(header.size() >> 8) << header;
+      npy.write(
+          reinterpret_cast<const char*>(input_data.data()),
+          input_data.size() * sizeof(int32_t));
+    }
+
+    tds::Tensor npy_input = tds::Tensor::FromNpyFile("mapped_input.npy");
+    ASSERT_EQ(npy_input.data_type_, tds::DataType::INT32);
+    ASSERT_EQ(npy_input.shape_, std::vector<int64_t>{16});
+    ASSERT_THROW(
+        tds::Tensor::FromFile(
+            "mapped_input.bin", tds::DataType::INT32, {32}, 4),
+        tds::TritonException);
+
+    auto allocator =
+        tds::MappedFileAllocator::Create("mapped_output.bin", 4096);
+    tds::InferOptions infer_options("add_sub");
+    infer_options.custom_allocator_ = allocator;
+    auto request = tds::InferRequest::Create(infer_options);
+    request->AddInput("INPUT0", npy_input);
+    request->AddInput(
+        "INPUT1", tds::Tensor::FromFile(
+                      "mapped_input.bin", tds::DataType::INT32, {16}, 4));
+    auto result = server->AsyncInfer(*request).get();
+    ASSERT_FALSE(result->HasError()) << result->ErrorMsg();
+
+    // The outputs are written into the mapped output file.
+    std::shared_ptr<tds::Tensor> sum = result->Output("OUTPUT0");
+    size_t sum_offset = allocator->Offset(*sum);
+    ASSERT_EQ(sum_offset % 64, size_t(0));
+    ASSERT_EQ(allocator->UsedByteSize(), size_t(128));
+    allocator->Sync();
+
+    std::ifstream output("mapped_output.bin", std::ios::binary);
+    output.seekg(sum_offset);
+    std::vector<int32_t> sum_data(input_data.size());
+    output.read(
+        reinterpret_cast<char*>(sum_data.data()),
+        sum_data.size() * sizeof(int32_t));
+    for (size_t i = 0; i < input_data.size(); ++i) {
+      EXPECT_EQ(sum_data[i], 2 * input_data[i]);
+    }
+
+    // An output that fits in the remaining capacity is allocated even if its
+    // alignment padding does not.
+    auto small_allocator =
+        tds::MappedFileAllocator::Create("mapped_small_output.bin", 164);
+    void* buffer = nullptr;
+    tds::MemoryType memory_type;
+    int64_t memory_type_id;
+    small_allocator->Allocate(
+        "OUTPUT0", 100, tds::MemoryType::CPU, 0, &buffer, &memory_type,
+        &memory_type_id);
+    ASSERT_EQ(small_allocator->UsedByteSize(), size_t(128));
+    small_allocator->Allocate(
+        "OUTPUT1", 36, tds::MemoryType::CPU, 0, &buffer, &memory_type,
+        &memory_type_id);
+    ASSERT_EQ(small_allocator->UsedByteSize(), size_t(164));
+    ASSERT_THROW(
+        small_allocator->Allocate(
+            "OUTPUT2", 1, tds::MemoryType::CPU, 0, &buffer, &memory_type,
+            &memory_type_id),
+        tds::TritonException);
+  }
+  catch (...) {
+    ASSERT_NO_THROW(throw);
+  }
+}
+
+TEST_F(TritonServerTest, InferBulk)
+{
+  try {
+    auto server = tds::TritonServer::Create(options_);
+
+    // 'add_sub' does not support batching, so the batch size must be given.
+    ASSERT_THROW(
+        tds::BulkInferenceRunner::Create(*server, tds::InferOptions("add_sub")),
+        tds::TritonException);
+
+    // Slice 1-D tensors of 3 x 16 elements into batches matching the [16]
+    // inputs of the model.
+    std::vector<int32_t> input0_data;
+    std::vector<int32_t> input1_data;
+    while (input0_data.size() < 48) {
+      input0_data.emplace_back(input0_data.size());
+      input1_data.emplace_back(1);
+    }
+    std::unordered_map<std::string, tds::Tensor> tensors;
+    tensors.emplace(
+        "INPUT0", tds::Tensor(
+                      reinterpret_cast<char*>(input0_data.data()),
+                      input0_data.size() * sizeof(int32_t),
+                      tds::DataType::INT32, {48}, tds::MemoryType::CPU, 0));
+    tensors.emplace(
+        "INPUT1", tds::Tensor(
+                      reinterpret_cast<char*>(input1_data.data()),
+                      input1_data.size() * sizeof(int32_t),
+                      tds::DataType::INT32, {48}, tds::MemoryType::CPU, 0));
+
+    auto runner = tds::BulkInferenceRunner::Create(
+        *server, tds::InferOptions("add_sub"), 2, 16);
+    std::vector<int32_t> sum_data;
+    auto sink = [&sum_data](
+                    const uint64_t first_row, const size_t row_count,
+                    tds::InferResult& result) {
+      ASSERT_EQ(first_row, sum_data.size());
+      ASSERT_EQ(row_count, size_t(16));
+      std::shared_ptr<tds::Tensor> sum = result.Output("OUTPUT0");
+      const int32_t* data = reinterpret_cast<const int32_t*>(sum->buffer_);
+      sum_data.insert(sum_data.end(), data, data + row_count);
+    };
+    auto source = tds::BulkInferenceSource::FromTensors(tensors);
+    tds::BulkInferenceStats stats = runner->Run(*source, sink);
+    ASSERT_EQ(stats.rows_, uint64_t(48));
+    ASSERT_EQ(stats.batches_, uint64_t(3));
+    ASSERT_EQ(sum_data.size(), input0_data.size());
+    for (size_t i = 0; i < sum_data.size(); ++i) {
+      EXPECT_EQ(sum_data[i], input0_data[i] + 1);
+    }
+
+    // Read the same rows one at a time, each row being a scalar.
+    size_t next_row = 0;
+    auto row_source = tds::BulkInferenceSource::FromRows(
+        [&](std::unordered_map<std::string, tds::Tensor>* row) {
+          if (next_row == input0_data.size()) {
+            return false;
+          }
+          row->clear();
+          row->emplace(
+              "INPUT0", tds::Tensor(
+                            reinterpret_cast<char*>(&input0_data[next_row]),
+                            sizeof(int32_t), tds::DataType::INT32, {},
+                            tds::MemoryType::CPU, 0));
+          row->emplace(
+              "INPUT1", tds::Tensor(
+                            reinterpret_cast<char*>(&input1_data[next_row]),
+                            sizeof(int32_t), tds::DataType::INT32, {},
+                            tds::MemoryType::CPU, 0));
+          next_row++;
+          return true;
+        });
+    sum_data.clear();
+    stats = runner->Run(*row_source, sink);
+    ASSERT_EQ(stats.rows_, uint64_t(48));
+    for (size_t i = 0; i < sum_data.size(); ++i) {
+      EXPECT_EQ(sum_data[i], input0_data[i] + 1);
+    }
+
+    // Errors of any type raised by the sink, the progress function or the
+    // source are reported by 'Run' once the batches in flight are done.
+    auto throwing_sink = [](const uint64_t first_row, const size_t row_count,
+                            tds::InferResult& result) {
+      throw std::runtime_error("sink failed");
+    };
+    source = tds::BulkInferenceSource::FromTensors(tensors);
+    ASSERT_THROW(runner->Run(*source, throwing_sink), tds::TritonException);
+    auto throwing_progress = [](const tds::BulkInferenceStats& stats) {
+      throw 1;
+    };
+    sum_data.clear();
+    source = tds::BulkInferenceSource::FromTensors(tensors);
+    ASSERT_THROW(
+        runner->Run(*source, sink, throwing_progress, 1),
+        tds::TritonException);
+    auto throwing_source = tds::BulkInferenceSource::FromRows(
+        [](std::unordered_map<std::string, tds::Tensor>* row) -> bool {
+          throw std::runtime_error("source failed");
+        });
+    ASSERT_THROW(runner->Run(*throwing_source, sink), tds::TritonException);
+  }
+  catch (...) {
+    ASSERT_NO_THROW(throw);
+  }
+}
+
+TEST_F(TritonServerTest, InferRecordReplay)
+{
+  try {
+    auto server = tds::TritonServer::Create(options_);
+
+    std::vector<int32_t> input_data;
+    while (input_data.size() < 16) {
+      input_data.emplace_back(input_data.size());
+    }
+
+    // Record one out of every two requests.
+    server->StartRecording("requests.log", 2);
+    for (size_t i = 0; i < 4; ++i) {
+      auto request = tds::InferRequest::Create(tds::InferOptions("add_sub"));
+      request->AddInput(
+          "INPUT0", input_data.begin(), input_data.end(),
+          tds::DataType::INT32, {16}, tds::MemoryType::CPU, 0);
+      request->AddInput(
+          "INPUT1", input_data.begin(), input_data.end(),
+          tds::DataType::INT32, {16}, tds::MemoryType::CPU, 0);
+      request->AddRequestedOutput("OUTPUT0");
+      auto result = server->AsyncInfer(*request).get();
+      ASSERT_FALSE(result->HasError()) << result->ErrorMsg();
+    }
+    server->StopRecording();
+
+    auto replayer = tds::RequestReplayer::Create("requests.log");
+    ASSERT_EQ(replayer->RequestCount(), size_t(2));
+    tds::ReplayStats stats = replayer->Run(*server);
+    ASSERT_EQ(stats.requests_, uint64_t(2));
+    ASSERT_EQ(stats.failed_, uint64_t(0));
+    ASSERT_LE(stats.p50_ns_, stats.max_ns_);
+
+    stats = replayer->Run(*server, tds::ReplayOptions(false, 1));
+    ASSERT_EQ(stats.requests_, uint64_t(2));
+    ASSERT_EQ(stats.failed_, uint64_t(0));
+  }
+  catch (...) {
+    ASSERT_NO_THROW(throw);
+  }
+}
+
+TEST_F(TritonServerTest, InferOutputBufferRing)
+{
+  try {
+    auto server = tds::TritonServer::Create(options_);
+
+    std::vector<int32_t> input_data;
+    while (input_data.size() < 16) {
+      input_data.emplace_back(input_data.size());
+    }
+
+    // The buffers are larger than the outputs, the actual byte size is
+    // reported by the output tensors.
+    auto ring = tds::OutputBufferRing::Create(2, 256);
+    std::set<char*> buffers;
+    for (size_t i = 0; i < 4; ++i) {
+      auto request = tds::InferRequest::Create(tds::InferOptions("add_sub"));
+      request->AddInput(
+          "INPUT0", input_data.begin(), input_data.end(),
+          tds::DataType::INT32, {16}, tds::MemoryType::CPU, 0);
+      request->AddInput(
+          "INPUT1", input_data.begin(), input_data.end(),
+          tds::DataType::INT32, {16}, tds::MemoryType::CPU, 0);
+      ring->AddRequestedOutput(*request, "OUTPUT0");
+      ASSERT_EQ(ring->FreeBufferCount("OUTPUT0"), size_t(1));
+
+      auto result = server->AsyncInfer(*request).get();
+      ASSERT_FALSE(result->HasError()) << result->ErrorMsg();
+      std::shared_ptr<tds::Tensor> sum = result->Output("OUTPUT0");
+      ASSERT_EQ(sum->byte_size_, input_data.size() * sizeof(int32_t));
+      const int32_t* sum_data = reinterpret_cast<const int32_t*>(sum->buffer_);
+      for (size_t j = 0; j < input_data.size(); ++j) {
+        EXPECT_EQ(sum_data[j], 2 * input_data[j]);
+      }
+      buffers.insert(sum->buffer_);
+    }
+
+    // The buffers are returned to the ring and reused.
+    ASSERT_EQ(ring->FreeBufferCount("OUTPUT0"), size_t(2));
+    ASSERT_EQ(buffers.size(), size_t(2));
+
+    // A pre-allocated buffer smaller than the output fails the inference.
+    std::vector<int32_t> small_buffer(4);
+    tds::Tensor small_output(
+        reinterpret_cast<char*>(small_buffer.data()),
+        small_buffer.size() * sizeof(int32_t), tds::MemoryType::CPU, 0);
+    auto request = tds::InferRequest::Create(tds::InferOptions("add_sub"));
+    request->AddInput(
+        "INPUT0", input_data.begin(), input_data.end(), tds::DataType::INT32,
+        {16}, tds::MemoryType::CPU, 0);
+    request->AddInput(
+        "INPUT1", input_data.begin(), input_data.end(), tds::DataType::INT32,
+        {16}, tds::MemoryType::CPU, 0);
+    request->AddRequestedOutput("OUTPUT0", small_output);
+    auto result = server->AsyncInfer(*request).get();
+    ASSERT_TRUE(result->HasError());
+  }
+  catch (...) {
+    ASSERT_NO_THROW(throw);
+  }
+}
+
+TEST_F(TritonServerTest, InferOutputPlacement)
+{
+  try {
+    auto server = tds::TritonServer::Create(options_);
+
+    std::vector<int32_t> input_data;
+    while (input_data.size() < 16) {
+      input_data.emplace_back(input_data.size());
+    }
+
+    // Without GPU support, pinned and GPU placements fall back to CPU.
+#ifdef TRITON_ENABLE_GPU
+    const tds::MemoryType pinned = tds::MemoryType::CPU_PINNED;
+    const tds::MemoryType gpu = tds::MemoryType::GPU;
+#else
+    const tds::MemoryType pinned = tds::MemoryType::CPU;
+    const tds::MemoryType gpu = tds::MemoryType::CPU;
+#endif  // TRITON_ENABLE_GPU
+
+    tds::InferOptions infer_options("add_sub");
+    infer_options.output_placements_.emplace(
+        "OUTPUT0", tds::OutputPlacement(tds::MemoryType::CPU_PINNED));
+    infer_options.output_placements_.emplace(
+        "OUTPUT1", tds::OutputPlacement(tds::MemoryType::GPU));
+    auto request = tds::InferRequest::Create(infer_options);
+    request->AddInput(
+        "INPUT0", input_data.begin(), input_data.end(), tds::DataType::INT32,
+        {16}, tds::MemoryType::CPU, 0);
+    request->AddInput(
+        "INPUT1", input_data.begin(), input_data.end(), tds::DataType::INT32,
+        {16}, tds::MemoryType::CPU, 0);
+    auto result = server->AsyncInfer(*request).get();
+    ASSERT_FALSE(result->HasError()) << result->ErrorMsg();
+
+    std::shared_ptr<tds::Tensor> sum = result->Output("OUTPUT0");
+    ASSERT_EQ(sum->memory_type_, pinned);
+    ASSERT_EQ(sum->memory_type_id_, 0);
+    const int32_t* sum_data = reinterpret_cast<const int32_t*>(sum->buffer_);
+    for (size_t i = 0; i < input_data.size(); ++i) {
+      EXPECT_EQ(sum_data[i], 2 * input_data[i]);
+    }
+
+    std::shared_ptr<tds::Tensor> diff = result->Output("OUTPUT1");
+    ASSERT_EQ(diff->memory_type_, gpu);
+    ASSERT_EQ(diff->memory_type_id_, 0);
+  }
+  catch (...) {
+    ASSERT_NO_THROW(throw);
+  }
+}
+
+TEST_F(TritonServerTest, InferPinnedInputArena)
+{
+  try {
+    auto server = tds::TritonServer::Create(options_);
+
+    std::vector<int32_t> input_data;
+    while (input_data.size() < 16) {
+      input_data.emplace_back(input_data.size());
+    }
+    const size_t byte_size = input_data.size() * sizeof(int32_t);
+
+    auto arena = tds::PinnedInputArena::Create(2, byte_size);
+    auto request = tds::InferRequest::Create(tds::InferOptions("add_sub"));
+    // Copy one input into a buffer and build the other one in place.
+    arena->AddInput(
+        *request, "INPUT0", reinterpret_cast<const char*>(input_data.data()),
+        byte_size, tds::DataType::INT32, {16});
+    tds::Tensor input1 = arena->Acquire();
+    memcpy(input1.buffer_, input_data.data(), byte_size);
+    input1.data_type_ = tds::DataType::INT32;
+    input1.shape_ = {16};
+    arena->AddInput(*request, "INPUT1", input1);
+    ASSERT_EQ(arena->FreeBufferCount(), size_t(0));
+
+    auto result = server->AsyncInfer(*request).get();
+    ASSERT_FALSE(result->HasError()) << result->ErrorMsg();
+    std::shared_ptr<tds::Tensor> sum = result->Output("OUTPUT0");
+    const int32_t* sum_data = reinterpret_cast<const int32_t*>(sum->buffer_);
+    for (size_t i = 0; i < input_data.size(); ++i) {
+      EXPECT_EQ(sum_data[i], 2 * input_data[i]);
+    }
+
+    // The buffers are returned once the server releases the request, while
+    // the request object is still alive.
+    for (size_t i = 0; (i < 100) && (arena->FreeBufferCount() != 2); ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_EQ(arena->FreeBufferCount(), size_t(2));
+  }
+  catch (...) {
+    ASSERT_NO_THROW(throw);
+  }
+}
+
+TEST_F(TritonServerTest, InferAllocationStatistics)
+{
+  try {
+    auto server = tds::TritonServer::Create(options_);
+
+    std::vector<int32_t> input_data;
+    while (input_data.size() < 16) {
+      input_data.emplace_back(input_data.size());
+    }
+    auto request = tds::InferRequest::Create(tds::InferOptions("add_sub"));
+    request->AddInput(
+        "INPUT0", input_data.begin(), input_data.end(), tds::DataType::INT32,
+        {16}, tds::MemoryType::CPU, 0);
+    request->AddInput(
+        "INPUT1", input_data.begin(), input_data.end(), tds::DataType::INT32,
+        {16}, tds::MemoryType::CPU, 0);
+    auto result = server->AsyncInfer(*request).get();
+    ASSERT_FALSE(result->HasError()) << result->ErrorMsg();
+
+    // Both outputs of 64 bytes are held by the result.
+    auto find_stats = [&server]() {
+      for (const auto& stats : server->AllocationStatistics()) {
+        if ((stats.model_name_ == "add_sub") &&
+            (stats.memory_type_ == tds::MemoryType::CPU)) {
+          return stats;
+        }
+      }
+      return tds::AllocationStats();
+    };
+    tds::AllocationStats stats = find_stats();
+    ASSERT_EQ(stats.allocation_count_, uint64_t(2));
+    ASSERT_EQ(stats.allocated_byte_size_, uint64_t(128));
+    ASSERT_EQ(stats.live_byte_size_, uint64_t(128));
+    ASSERT_EQ(stats.size_histogram_[0], uint64_t(2));
+
+    // The buffers are released with the result.
+    result.reset();
+    stats = find_stats();
+    ASSERT_EQ(stats.live_byte_size_, uint64_t(0));
+    ASSERT_EQ(stats.peak_byte_size_, uint64_t(128));
+  }
+  catch (...) {
+    ASSERT_NO_THROW(throw);
+  }
+}
+
+TEST_F(TritonServerTest, InferRequestReuse)
+{
+  try {
+    auto server = tds::TritonServer::Create(options_);
+
+    std::vector<int32_t> input_data;
+    while (input_data.size() < 16) {
+      input_data.emplace_back(input_data.size());
+    }
+    std::vector<int32_t> sum_data(16);
+    char* input_buffer = reinterpret_cast<char*>(input_data.data());
+    tds::Tensor input0(
+        input_buffer, 64, tds::DataType::INT32, {16}, tds::MemoryType::CPU, 0);
+    tds::Tensor input1(
+        input_buffer, 64, tds::DataType::INT32, {16}, tds::MemoryType::CPU, 0);
+    tds::Tensor output0(
+        reinterpret_cast<char*>(sum_data.data()), 64, tds::MemoryType::CPU, 0);
+
+    auto request = tds::InferRequest::Create(tds::InferOptions("add_sub"));
+    auto build = [&request, &input0, &input1, &output0, input_buffer]() {
+      request->Reset();
+      request->AddInput("INPUT0", input0);
+      // The moved tensor gets back the shape storage of the request, but not
+      // the buffer.
+      input1.buffer_ = input_buffer;
+      input1.shape_ = {16};
+      request->AddInput("INPUT1", std::move(input1));
+      request->AddRequestedOutput("OUTPUT0", output0);
+      request->AddRequestedOutput("OUTPUT1");
+    };
+
+    // Once the storage of the request is in place, building the same request
+    // again does not allocate.
+    build();
+    build();
+    const uint64_t allocations = allocation_count;
+    for (size_t i = 0; i < 100; ++i) {
+      build();
+    }
+    ASSERT_EQ(allocation_count - allocations, uint64_t(0));
+
+    for (size_t i = 0; i < 2; ++i) {
+      std::fill(sum_data.begin(), sum_data.end(), 0);
+      auto result = server->AsyncInfer(*request).get();
+      ASSERT_FALSE(result->HasError()) << result->ErrorMsg();
+      std::shared_ptr<tds::Tensor> diff = result->Output("OUTPUT1");
+      const int32_t* diff_data =
+          reinterpret_cast<const int32_t*>(diff->buffer_);
+      for (size_t j = 0; j < input_data.size(); ++j) {
+        EXPECT_EQ(sum_data[j], 2 * input_data[j]);
+        EXPECT_EQ(diff_data[j], 0);
+      }
+      result.reset();
+      build();
+    }
+  }
+  catch (...) {
+    ASSERT_NO_THROW(throw);
+  }
+}
+
+TEST_F(TritonServerTest, InferMovedOutput)
+{
+  try {
+    auto server = tds::TritonServer::Create(options_);
+
+    std::vector<int32_t> input_data;
+    while (input_data.size() < 16) {
+      input_data.emplace_back(input_data.size());
+    }
+
+    auto request = tds::InferRequest::Create(tds::InferOptions("add_sub"));
+    request->AddInput(
+        "INPUT0", input_data.begin(), input_data.end(), tds::DataType::INT32,
+        {16}, tds::MemoryType::CPU, 0);
+    request->AddInput(
+        "INPUT1", input_data.begin(), input_data.end(), tds::DataType::INT32,
+        {16}, tds::MemoryType::CPU, 0);
+    auto result = server->AsyncInfer(*request).get();
+    ASSERT_FALSE(result->HasError()) << result->ErrorMsg();
+
+    // Feed the sum back as an input of a second request. Moving the output
+    // hands its buffer to the request, which releases it.
+    std::shared_ptr<tds::Tensor> first_sum = result->Output("OUTPUT0");
+    auto next_request =
+        tds::InferRequest::Create(tds::InferOptions("add_sub"));
+    next_request->AddInput(
+        "INPUT0", input_data.begin(), input_data.end(), tds::DataType::INT32,
+        {16}, tds::MemoryType::CPU, 0);
+    next_request->AddInput("INPUT1", std::move(*first_sum));
+    ASSERT_EQ(first_sum->buffer_, nullptr);
+    first_sum.reset();
+    result.reset();
+
+    auto next_result = server->AsyncInfer(*next_request).get();
+    ASSERT_FALSE(next_result->HasError()) << next_result->ErrorMsg();
+    std::shared_ptr<tds::Tensor> sum = next_result->Output("OUTPUT0");
+    const int32_t* sum_data = reinterpret_cast<const int32_t*>(sum->buffer_);
+    for (size_t i = 0; i < input_data.size(); ++i) {
+      EXPECT_EQ(sum_data[i], 3 * input_data[i]);
+    }
+  }
+  catch (...) {
+    ASSERT_NO_THROW(throw);
+  }
+}
+
 TEST_F(TritonServerTest, InferString)
 {
   try {
@@ -607,6 +1562,95 @@ TEST_F(TritonServerTest, InferDecoupledZeroResponse)
   }
 }
 
+TEST_F(TritonServerTest, InferDecoupledStream)
+{
+  try {
+    auto server = tds::TritonServer::Create(options_);
+
+    std::vector<int32_t> input_data = {5};
+    auto request = tds::InferRequest::Create(tds::InferOptions("square_int32"));
+    request->AddInput(
+        "IN", tds::Tensor(
+                  reinterpret_cast<char*>(input_data.data()),
+                  input_data.size() * sizeof(int32_t), tds::DataType::INT32,
+                  {1}, tds::MemoryType::CPU, 0));
+    // Use a capacity smaller than the number of responses so that the server
+    // has to wait for the ring to be drained.
+    auto stream = server->InferStream(*request, 2);
+
+    std::vector<std::unique_ptr<tds::InferResult>> results;
+    results.push_back(stream->Next());
+    ASSERT_TRUE(results.back());
+    while (!stream->IsFinished()) {
+      if (stream->Drain(&results, 2) == 0) {
+        auto result = stream->Next();
+        if (result) {
+          results.push_back(std::move(result));
+        }
+      }
+    }
+    ASSERT_EQ(results.size(), size_t(5));
+    ASSERT_FALSE(stream->Next());
+    std::unique_ptr<tds::InferResult> extra;
+    ASSERT_FALSE(stream->TryNext(&extra));
+
+    for (auto& result : results) {
+      ASSERT_FALSE(result->HasError()) << result->ErrorMsg();
+      ASSERT_EQ(result->ModelName(), "square_int32");
+      std::shared_ptr<tds::Tensor> out = result->Output("OUT");
+      ASSERT_EQ(out->shape_, std::vector<int64_t>{1});
+      ASSERT_EQ(out->data_type_, tds::DataType::INT32);
+      EXPECT_EQ(reinterpret_cast<const int32_t*>(out->buffer_)[0], 5);
+    }
+
+    // A request with no response finishes the stream without any result.
+    input_data[0] = 0;
+    stream = server->InferStream(*request);
+    ASSERT_FALSE(stream->Next());
+    ASSERT_TRUE(stream->IsFinished());
+
+    // A cancelled stream returns no more responses and does not block the
+    // server, even though its ring is full. Each stream gets its own request
+    // as the cancelled requests may still be in flight.
+    std::vector<int32_t> long_data = {64};
+    auto long_request = [&long_data]() {
+      auto request =
+          tds::InferRequest::Create(tds::InferOptions("square_int32"));
+      request->AddInput(
+          "IN", tds::Tensor(
+                    reinterpret_cast<char*>(long_data.data()),
+                    long_data.size() * sizeof(int32_t), tds::DataType::INT32,
+                    {1}, tds::MemoryType::CPU, 0));
+      return request;
+    };
+    auto cancelled_request = long_request();
+    stream = server->InferStream(*cancelled_request, 2);
+    ASSERT_TRUE(stream->Next());
+    stream->Cancel();
+    ASSERT_FALSE(stream->Next());
+    std::unique_ptr<tds::InferResult> cancelled;
+    ASSERT_FALSE(stream->TryNext(&cancelled));
+
+    // So does a stream abandoned after a partial read. The next request on
+    // the model only completes once the server is no longer blocked.
+    auto abandoned_request = long_request();
+    auto abandoned = server->InferStream(*abandoned_request, 2);
+    ASSERT_TRUE(abandoned->Next());
+    abandoned.reset();
+
+    input_data[0] = 1;
+    stream = server->InferStream(*request);
+    auto last = stream->Next();
+    ASSERT_TRUE(last);
+    ASSERT_FALSE(last->HasError()) << last->ErrorMsg();
+    ASSERT_FALSE(stream->Next());
+    ASSERT_TRUE(stream->IsFinished());
+  }
+  catch (...) {
+    ASSERT_NO_THROW(throw);
+  }
+}
+
 }  // namespace
 
 int